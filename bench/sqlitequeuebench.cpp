@@ -0,0 +1,402 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+
+#ifndef _WIN32
+#include "unistd.h"
+#else
+#include "process.h"
+#define getpid _getpid
+#endif
+
+#include "benchmark/benchmark.h"
+#include "spdlog/spdlog.h"
+#include "sqlite3.h"
+
+#include "model/dao/sqliteconnect.hpp"
+#include "model/dao/sqlitequeue.hpp"
+#include "model/executor.hpp"
+#include "model/timer.hpp"
+#include "stubproc.hpp"
+
+namespace Bench
+{
+
+// every queue has its own database in here, removed at exit
+static std::filesystem::path tempDir;
+
+static std::shared_ptr<Model::DAO::IConnect> conn;
+
+static u64 queueCount(0);
+
+// filled once per size, the read benchmarks run many times
+static std::map<i64, std::shared_ptr<Model::DAO::SQLiteQueue>> filledQueues;
+
+static std::shared_ptr<Model::DAO::SQLiteQueue> newQueue(std::string &name)
+{
+    name = "bench" + std::to_string(queueCount++);
+    std::shared_ptr<Model::Proc::IProc> proc = std::make_shared<StubProc>();
+    auto queue = std::make_shared<Model::DAO::SQLiteQueue>();
+    if (queue->init(conn, proc, name))
+    {
+        return nullptr;
+    }
+
+    return queue;
+}
+
+static Model::Proc::Task sampleTask()
+{
+    Model::Proc::Task task;
+    task.execName = "/bin/true";
+    task.args = {"--input", "in.txt", "--output", "out.txt"};
+    task.workDir = tempDir.string();
+    return task;
+}
+
+static u8 execSQL(sqlite3 *db, const std::string &sql)
+{
+    char *err(nullptr);
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err))
+    {
+        spdlog::error("{}:{} {}: {}", __FILE__, __LINE__, sql, err);
+        sqlite3_free(err);
+        return 1;
+    }
+
+    return 0;
+}
+
+static i64 queryInt(sqlite3 *db, const std::string &sql)
+{
+    sqlite3_stmt *stmt(nullptr);
+    i64 ret(0);
+    if (!sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr) &&
+        sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        ret = sqlite3_column_int64(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+    return ret;
+}
+
+// Fill "pending" up to "rows" tasks. One task is added by the queue, then
+// copied with new IDs in a single transaction, adding a million tasks one
+// by one takes hours as every insert waits for the disk.
+static u8 fill(Model::DAO::SQLiteQueue &queue, const std::string &name, i64 rows)
+{
+    Model::Proc::Task task = sampleTask();
+    if (queue.addTask(task))
+    {
+        return 1;
+    }
+
+    sqlite3 *db(nullptr);
+    std::string path = (tempDir / (name + ".db")).string();
+    if (sqlite3_open(path.c_str(), &db))
+    {
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // same columns as the queue, whatever they are
+    std::string columns, values;
+    sqlite3_stmt *stmt(nullptr);
+    sqlite3_prepare_v2(db, "PRAGMA table_info(pending);", -1, &stmt, nullptr);
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        std::string column = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        columns += (columns.empty() ? "" : ", ") + column;
+        values += (values.empty() ? "" : ", ") +
+                  (column == "ID" ? std::string("ID + ?") : column);
+    }
+
+    sqlite3_finalize(stmt);
+
+    const std::string maxID =
+        "SELECT MAX(ID) FROM (SELECT ID FROM pending UNION ALL SELECT ID FROM done)";
+    u8 ret = execSQL(db, "BEGIN;");
+    i64 count = queryInt(db, "SELECT COUNT(*) FROM pending;");
+    while (!ret && count < rows)
+    {
+        std::string sql = "INSERT INTO pending (" + columns + ") SELECT " + values +
+                          " FROM pending ORDER BY ID LIMIT " +
+                          std::to_string(rows - count) + ";";
+        if (sqlite3_prepare_v2(db, sql.c_str(), sql.length(), &stmt, nullptr) ||
+            sqlite3_bind_int64(stmt, 1, queryInt(db, maxID + ";") + 1) ||
+            sqlite3_step(stmt) != SQLITE_DONE)
+        {
+            spdlog::error("{}:{} Fail to fill: {}", __FILE__, __LINE__, sqlite3_errmsg(db));
+            ret = 1;
+        }
+
+        sqlite3_finalize(stmt);
+        count += sqlite3_changes(db);
+    }
+
+    // the next ID of the queue must not be taken
+    if (!ret)
+    {
+        ret = execSQL(db, "UPDATE lastID SET ID = (" + maxID + ") + 1;") ||
+              execSQL(db, "COMMIT;");
+    }
+
+    if (ret)
+    {
+        UNUSED(execSQL(db, "ROLLBACK;"));
+    }
+
+    sqlite3_close(db);
+    return ret;
+}
+
+static std::shared_ptr<Model::DAO::SQLiteQueue> filledQueue(i64 rows)
+{
+    auto it = filledQueues.find(rows);
+    if (it != filledQueues.end())
+    {
+        return it->second;
+    }
+
+    std::string name;
+    auto queue = newQueue(name);
+    if (!queue || fill(*queue, name, rows))
+    {
+        return nullptr;
+    }
+
+    filledQueues[rows] = queue;
+    return queue;
+}
+
+static void BM_AddTask(benchmark::State &state)
+{
+    std::string name;
+    auto queue = newQueue(name);
+    if (!queue)
+    {
+        state.SkipWithError("Fail to create queue");
+        return;
+    }
+
+    Model::Proc::Task task = sampleTask();
+    for (auto _ : state)
+    {
+        if (queue->addTask(task))
+        {
+            state.SkipWithError("Fail to add task");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ListPending(benchmark::State &state)
+{
+    auto queue = filledQueue(state.range(0));
+    if (!queue)
+    {
+        state.SkipWithError("Fail to fill queue");
+        return;
+    }
+
+    std::vector<int> out;
+    for (auto _ : state)
+    {
+        if (queue->listPending(out))
+        {
+            state.SkipWithError("Fail to list pending");
+            break;
+        }
+
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_PendingDetails(benchmark::State &state)
+{
+    auto queue = filledQueue(state.range(0));
+    std::vector<int> ids;
+    if (!queue || queue->listPending(ids))
+    {
+        state.SkipWithError("Fail to fill queue");
+        return;
+    }
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> dist(0, ids.size() - 1);
+    Model::Proc::Task task;
+    for (auto _ : state)
+    {
+        if (queue->pendingDetails(ids[dist(gen)], task))
+        {
+            state.SkipWithError("Fail to get details");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_RemoveTask(benchmark::State &state)
+{
+    std::string name;
+    auto queue = newQueue(name);
+    if (!queue)
+    {
+        state.SkipWithError("Fail to create queue");
+        return;
+    }
+
+    std::vector<int> ids;
+    for (auto _ : state)
+    {
+        if (ids.empty())
+        {
+            state.PauseTiming();
+            if (fill(*queue, name, 10000) || queue->listPending(ids))
+            {
+                state.SkipWithError("Fail to fill queue");
+                break;
+            }
+
+            state.ResumeTiming();
+        }
+
+        if (queue->removeTask(ids.back()))
+        {
+            state.SkipWithError("Fail to remove task");
+            break;
+        }
+
+        ids.pop_back();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// pending -> done of the main loop (mainLoopInit() and mainLoopFin()),
+// the stub process is done at once
+static void BM_MoveToDone(benchmark::State &state)
+{
+    std::string name;
+    auto queue = newQueue(name);
+    if (!queue)
+    {
+        state.SkipWithError("Fail to create queue");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        if (fill(*queue, name, state.range(0)))
+        {
+            state.SkipWithError("Fail to fill queue");
+            break;
+        }
+
+        state.ResumeTiming();
+        if (queue->start())
+        {
+            state.SkipWithError("Fail to start queue");
+            break;
+        }
+
+        // the loop stops when pending is empty
+        while (queue->isRunning())
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    queue->stop();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// the writes wait for the disk and the main loop runs on the executor,
+// so they are measured in wall time
+BENCHMARK(BM_AddTask)->UseRealTime();
+BENCHMARK(BM_ListPending)->Arg(1000)->Arg(100000)->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PendingDetails)->Arg(1000)->Arg(100000)->Arg(1000000);
+BENCHMARK(BM_RemoveTask)->UseRealTime();
+BENCHMARK(BM_MoveToDone)->Arg(1000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // end namespace Bench
+
+int main(int argc, char **argv)
+{
+    // the queues log every empty pending list
+    spdlog::set_level(spdlog::level::off);
+
+    Bench::tempDir = std::filesystem::temp_directory_path() /
+                     ("ffbench-" + std::to_string(getpid()));
+    std::error_code ec;
+    std::filesystem::create_directories(Bench::tempDir, ec);
+    if (ec)
+    {
+        fmt::println("Fail to create {}: {}", Bench::tempDir.string(), ec.message());
+        return 1;
+    }
+
+    Model::DAO::SQLiteConnect *conn = new Model::DAO::SQLiteConnect;
+    Bench::conn = std::shared_ptr<Model::DAO::IConnect>(conn);
+    if (conn->startConnect(Bench::tempDir.string()) ||
+        Model::Timer::init() ||
+        Model::Executor::init())
+    {
+        fmt::println("Fail to initialize");
+        std::filesystem::remove_all(Bench::tempDir, ec);
+        return 1;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    int ret(0);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        ret = 1;
+    }
+    else
+    {
+        benchmark::RunSpecifiedBenchmarks();
+    }
+
+    benchmark::Shutdown();
+    Bench::filledQueues.clear();
+    Bench::conn = nullptr;
+    Model::Executor::fin();
+    Model::Timer::fin();
+    std::filesystem::remove_all(Bench::tempDir, ec);
+    return ret;
+}
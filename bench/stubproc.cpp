@@ -0,0 +1,94 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "stubproc.hpp"
+
+namespace Bench
+{
+
+StubProc::StubProc()
+{}
+
+StubProc::~StubProc()
+{}
+
+u8 StubProc::init()
+{
+    return 0;
+}
+
+u8 StubProc::start(const Model::Proc::Task &task)
+{
+    UNUSED(task);
+    return 0;
+}
+
+void StubProc::stop()
+{}
+
+bool StubProc::isRunning()
+{
+    return false;
+}
+
+void StubProc::readCurrentOutput(std::vector<std::string> &out)
+{
+    out.clear();
+}
+
+u8 StubProc::exitCode(i32 &out)
+{
+    out = 0;
+    return 0;
+}
+
+u8 StubProc::cpuTime(i64 &out)
+{
+    out = 0;
+    return 0;
+}
+
+u8 StubProc::setAffinity(const Model::Proc::Affinity &in)
+{
+    UNUSED(in);
+    return 0;
+}
+
+u8 StubProc::terminate(bool force)
+{
+    UNUSED(force);
+    return 0;
+}
+
+i64 StubProc::lastOutputTime()
+{
+    return 0;
+}
+
+void StubProc::outputLog(std::string &out)
+{
+    out.clear();
+}
+
+} // end namespace Bench
@@ -0,0 +1,69 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _BENCH_STUBPROC_HPP_
+#define _BENCH_STUBPROC_HPP_
+
+#include "model/proc/iproc.hpp"
+
+namespace Bench
+{
+
+// a process which is done as soon as it is started, so the queue
+// benchmarks measure the storage only
+class StubProc : public Model::Proc::IProc
+{
+public:
+
+    StubProc();
+
+    ~StubProc();
+
+    u8 init() override;
+
+    u8 start(const Model::Proc::Task &task) override;
+
+    void stop() override;
+
+    bool isRunning() override;
+
+    void readCurrentOutput(std::vector<std::string> &out) override;
+
+    u8 exitCode(i32 &out) override;
+
+    u8 cpuTime(i64 &out) override;
+
+    u8 setAffinity(const Model::Proc::Affinity &in) override;
+
+    u8 terminate(bool force) override;
+
+    i64 lastOutputTime() override;
+
+    void outputLog(std::string &out) override;
+
+}; // end class StubProc
+
+} // end namespace Bench
+
+#endif // _BENCH_STUBPROC_HPP_
@@ -15,8 +15,23 @@ set(MODEL_SRC
     model/dao/iqueuelist.hpp
     model/dao/iqueue.hpp
 
+    model/cron.cpp
+    model/cron.hpp
+    model/dag.cpp
+    model/dag.hpp
     model/errmsg.cpp
     model/errmsg.hpp
+    model/eventbus.cpp
+    model/eventbus.hpp
+    model/executor.cpp
+    model/executor.hpp
+    model/lrucache.hpp
+    model/metrics.cpp
+    model/metrics.hpp
+    model/scheduler.cpp
+    model/scheduler.hpp
+    model/timer.cpp
+    model/timer.hpp
     model/utils.cpp
     model/utils.hpp
 
@@ -47,8 +62,14 @@ set(MODEL_SRC
     model/dao/grpcutils.hpp
 
     # proc
+    model/proc/affinity.cpp
+    model/proc/affinity.hpp
     model/proc/iproc.cpp
     model/proc/iproc.hpp
+    model/proc/procfactory.cpp
+    model/proc/procfactory.hpp
+    model/proc/simproc.cpp
+    model/proc/simproc.hpp
     model/proc/task.cpp
     model/proc/task.hpp
 )
@@ -62,7 +83,16 @@ elseif (LINUX)
     list(APPEND MODEL_SRC
         model/proc/linuxproc.cpp
         model/proc/linuxproc.hpp
+        model/proc/reactor.cpp
+        model/proc/reactor.hpp
     )
+
+    if (ENABLE_IO_URING)
+        list(APPEND MODEL_SRC
+            model/proc/uring.cpp
+            model/proc/uring.hpp
+        )
+    endif (ENABLE_IO_URING)
 endif (WIN32)
 
 add_library(ffmodel STATIC
@@ -76,3 +106,7 @@ target_link_libraries(ffmodel
 
     ${FF_MODEL_LIBS}
 )
+
+if (LINUX AND ENABLE_IO_URING)
+    target_compile_definitions(ffmodel PRIVATE FF_IO_URING)
+endif (LINUX AND ENABLE_IO_URING)
@@ -0,0 +1,32 @@
+if(ENABLE_BENCHMARK)
+    find_package(benchmark REQUIRED)
+
+    set(FF_BENCH_LIBS
+        protobuf::libprotobuf
+        gRPC::grpc++
+        SQLite::SQLite3
+
+        benchmark::benchmark
+        grpc_common
+        spdlog::spdlog
+    )
+
+    set(BENCH_SRC
+        bench/sqlitequeuebench.cpp
+        bench/stubproc.cpp
+        bench/stubproc.hpp
+    )
+
+    add_executable(FlexFlowBench
+        ${BENCH_SRC}
+    )
+
+    add_dependencies(FlexFlowBench grpc_common ffmodel)
+
+    target_link_libraries(FlexFlowBench
+        PRIVATE
+
+        ${FF_BENCH_LIBS}
+        ffmodel
+    )
+endif(ENABLE_BENCHMARK)
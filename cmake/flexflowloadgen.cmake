@@ -0,0 +1,34 @@
+if(ENABLE_LOADGEN)
+    set(FF_LOADGEN_LIBS
+        protobuf::libprotobuf
+        gRPC::grpc++
+        cxxopts::cxxopts
+        SQLite::SQLite3
+
+        grpc_common
+        spdlog::spdlog
+    )
+
+    set(LOADGEN_CONTROLLER_SRC
+        controller/loadgen/config.cpp
+        controller/loadgen/config.hpp
+        controller/loadgen/loadgen.cpp
+        controller/loadgen/loadgen.hpp
+    )
+
+    add_executable(FlexFlowLoadGen
+        ${LOADGEN_CONTROLLER_SRC}
+
+        loadgenmain.cpp)
+
+    set_target_properties(FlexFlowLoadGen PROPERTIES OUTPUT_NAME ff-loadgen)
+
+    add_dependencies(FlexFlowLoadGen grpc_common ffmodel)
+
+    target_link_libraries(FlexFlowLoadGen
+        PRIVATE
+
+        ${FF_LOADGEN_LIBS}
+        ffmodel
+    )
+endif(ENABLE_LOADGEN)
@@ -21,12 +21,19 @@ if(ENABLE_SERVER)
         # grpc
         controller/grpcserver/accessimpl.cpp
         controller/grpcserver/accessimpl.hpp
+        controller/grpcserver/latencyinterceptor.cpp
+        controller/grpcserver/latencyinterceptor.hpp
+        controller/grpcserver/metricsserver.cpp
+        controller/grpcserver/metricsserver.hpp
         controller/grpcserver/queueimpl.cpp
         controller/grpcserver/queueimpl.hpp
         controller/grpcserver/queuelistimpl.cpp
         controller/grpcserver/queuelistimpl.hpp
+        controller/grpcserver/reactors.hpp
         controller/grpcserver/server.cpp
         controller/grpcserver/server.hpp
+        controller/grpcserver/statsimpl.cpp
+        controller/grpcserver/statsimpl.hpp
     )
 
     add_executable(FlexFlowServer
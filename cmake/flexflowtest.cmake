@@ -0,0 +1,36 @@
+if(ENABLE_TEST)
+    find_package(GTest REQUIRED)
+    include(GoogleTest)
+    enable_testing()
+
+    set(FF_TEST_LIBS
+        GTest::gtest
+        GTest::gtest_main
+        spdlog::spdlog
+    )
+
+    set(TEST_SRC
+        test/crontest.cpp
+        test/dagtest.cpp
+        test/timertest.cpp
+    )
+
+    add_executable(FlexFlowTest
+        ${TEST_SRC}
+    )
+
+    add_dependencies(FlexFlowTest grpc_common ffmodel)
+
+    target_link_libraries(FlexFlowTest
+        PRIVATE
+
+        ${FF_TEST_LIBS}
+        ffmodel
+    )
+
+    # the timer tests wait for the wall clock, up to about two minutes
+    gtest_discover_tests(FlexFlowTest
+        DISCOVERY_TIMEOUT 30
+        PROPERTIES TIMEOUT 180
+    )
+endif(ENABLE_TEST)
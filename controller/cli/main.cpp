@@ -199,7 +199,7 @@ i32 Main::parseArgs(int argc, char **argv)
         options.add_options()
             ("l,log-file", "file for output log", cxxopts::value<std::string>(Global::config.logFile)->default_value(""))
             ("L,log-level", "log level for spdlog", cxxopts::value<i32>(Global::config.logLevel)->default_value("2"))
-            ("a,address", "address to FF server", cxxopts::value<std::string>(Global::config.address)->default_value("127.0.0.1"))
+            ("a,address", "address to FF server, or unix:<path> for local server", cxxopts::value<std::string>(Global::config.address)->default_value("127.0.0.1"))
             ("A,auto-connect", "auto connect to server", cxxopts::value<bool>(Global::config.autoConnect)->default_value("true"))
             ("p,port", "which port is FF Server listening", cxxopts::value<u16>(Global::config.port)->default_value("12345"))
             ("v,version", "print version")
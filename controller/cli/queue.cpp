@@ -21,6 +21,10 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
 #ifdef _WIN32
 #include "winsock.h"
 #include "direct.h"
@@ -36,6 +40,7 @@
 
 #include "spdlog/spdlog.h"
 
+#include "model/errmsg.hpp"
 #include "model/utils.hpp"
 
 #include "controller/cli/global.hpp"
@@ -56,17 +61,23 @@ u8 Queue::init()
     m_funcs["remove"] = std::bind(&Queue::remove, this);
     m_funcs["current"] = std::bind(&Queue::current, this);
     m_funcs["add"] = std::bind(&Queue::add, this);
+    m_funcs["priority"] = std::bind(&Queue::priority, this);
+    m_funcs["history"] = std::bind(&Queue::history, this);
+    m_funcs["stats"] = std::bind(&Queue::stats, this);
+    m_funcs["log"] = std::bind(&Queue::log, this);
+    m_funcs["wait"] = std::bind(&Queue::wait, this);
+    m_funcs["watch"] = std::bind(&Queue::watch, this);
     m_funcs["isRunning"] = std::bind(&Queue::isRunning, this);
     m_funcs["start"] = std::bind(&Queue::start, this);
     m_funcs["stop"] = std::bind(&Queue::stop, this);
     m_funcs["output"] = std::bind(&Queue::output, this);
 
     m_listOpts.add_options()
-        ("m,mode", "list task, 1 for pending, 2 for finished", cxxopts::value<u8>()->default_value("1"))
+        ("m,mode", "list task, 1 for pending, 2 for finished, 3 for scheduled, 4 for blocked", cxxopts::value<u8>()->default_value("1"))
         ("h,help", "print help");
 
     m_detailsOpts.add_options()
-        ("m,mode", "for which list, 1 for pending, 2 for finished", cxxopts::value<u8>()->default_value("1"))
+        ("m,mode", "for which list, 1 for pending, 2 for finished, 3 for scheduled, 4 for blocked", cxxopts::value<u8>()->default_value("1"))
         ("i,id", "the task id", cxxopts::value<i32>()->default_value("0"))
         ("h,help", "print help");
 
@@ -93,6 +104,45 @@ u8 Queue::init()
         ("w,workDir", "set working dir", cxxopts::value<std::string>()->default_value(std::string(buf)))
         ("e,exec", "program to execute", cxxopts::value<std::string>())
         ("a,args", "command line arguments for the program to execute", cxxopts::value<std::vector<std::string>>())
+        ("p,priority", "higher priority runs first", cxxopts::value<i32>()->default_value("0"))
+        ("d,delay", "run after the given seconds", cxxopts::value<i64>()->default_value("0"))
+        ("c,cron", "run repeatedly, \"minute hour day month weekday\"", cxxopts::value<std::string>())
+        ("r,retries", "retry a failed task up to the given times", cxxopts::value<i32>()->default_value("0"))
+        ("b,backoff", "seconds before the first retry, doubled every retry", cxxopts::value<i32>()->default_value("0"))
+        ("B,backoffMax", "upper bound of the retry delay in seconds", cxxopts::value<i32>()->default_value("0"))
+        ("t,timeout", "terminate the task after the given seconds", cxxopts::value<i32>()->default_value("0"))
+        ("I,idleTimeout", "terminate the task after the given seconds without output", cxxopts::value<i32>()->default_value("0"))
+        ("k,key", "idempotency key, adding again with the same key returns the first ID", cxxopts::value<std::string>())
+        ("f,inputs", "input files of the task for the result cache", cxxopts::value<std::vector<std::string>>())
+        ("D,dependsOn", "run after these tasks have succeeded, \"ID\" or \"queue:ID\"", cxxopts::value<std::vector<std::string>>())
+        ("h,help", "print help");
+
+    m_historyOpts.add_options()
+        ("i,id", "the task id", cxxopts::value<i32>())
+        ("h,help", "print help");
+
+    m_statsOpts.add_options()
+        ("m,minutes", "the window ending now, in minutes", cxxopts::value<i64>()->default_value("60"))
+        ("e,exec", "only the tasks of this program", cxxopts::value<std::string>())
+        ("h,help", "print help");
+
+    m_logOpts.add_options()
+        ("i,id", "the task id", cxxopts::value<i32>())
+        ("h,help", "print help");
+
+    m_waitOpts.add_options()
+        ("i,id", "ids of the tasks", cxxopts::value<std::vector<int>>())
+        ("a,any", "return when any of the tasks is finished")
+        ("t,timeout", "give up after the given seconds, 0 for never", cxxopts::value<i32>()->default_value("0"))
+        ("h,help", "print help");
+
+    m_watchOpts.add_options()
+        ("c,count", "stop after the given number of events, 0 for never", cxxopts::value<i32>()->default_value("0"))
+        ("h,help", "print help");
+
+    m_priorityOpts.add_options()
+        ("i,id", "id of the pending task", cxxopts::value<i32>())
+        ("p,priority", "new priority, higher priority runs first", cxxopts::value<i32>())
         ("h,help", "print help");
 
     m_removeOpts.add_options()
@@ -141,7 +191,7 @@ i32 Queue::run(const std::string &prefix,
             if (Global::args.args().at(0) == "help")
             {
                 fmt::print("Vaild commands: list details clear ");
-                fmt::print("remove current add isRunning ");
+                fmt::print("remove current add priority history stats log wait watch isRunning ");
                 fmt::println("start stop output help exit");
                 fmt::println("Please type \"<command> -h\" for more details.");
                 fmt::println("Please type \"help\" to show this message.");
@@ -196,8 +246,10 @@ i32 Queue::printList(u8 exitCode, const std::string &name, const std::vector<int
     return 0;
 }
 
-#define PENDING  1
-#define FINISHED 2
+#define PENDING   1
+#define FINISHED  2
+#define SCHEDULED 3
+#define BLOCKED   4
 
 i32 Queue::list()
 {
@@ -234,6 +286,18 @@ i32 Queue::list()
             ret = m_queue->listFinished(out);
             return printList(ret, "finished", out);
         }
+        case SCHEDULED:
+        {
+            fmt::println("listing scheduled list...");
+            ret = m_queue->listScheduled(out);
+            return printList(ret, "scheduled", out);
+        }
+        case BLOCKED:
+        {
+            fmt::println("listing blocked list...");
+            ret = m_queue->listBlocked(out);
+            return printList(ret, "blocked", out);
+        }
         default:
         {
             fmt::print("{}", m_listOpts.help());
@@ -284,6 +348,18 @@ i32 Queue::details()
             ret = m_queue->finishedDetails(id, out);
             break;
         }
+        case SCHEDULED:
+        {
+            fmt::println("scheduled task details...");
+            ret = m_queue->scheduledDetails(id, out);
+            break;
+        }
+        case BLOCKED:
+        {
+            fmt::println("blocked task details...");
+            ret = m_queue->blockedDetails(id, out);
+            break;
+        }
         default:
         {
             fmt::print("{}", m_detailsOpts.help());
@@ -363,6 +439,8 @@ i32 Queue::clear()
 
 #undef PENDING
 #undef FINISHED
+#undef SCHEDULED
+#undef BLOCKED
 
 i32 Queue::current()
 {
@@ -424,6 +502,47 @@ i32 Queue::add()
 
         in.workDir = result["workDir"].as<std::string>();
         in.execName = result["exec"].as<std::string>();
+        in.priority = result["priority"].as<i32>();
+        i64 delay = result["delay"].as<i64>();
+        if (delay > 0)
+        {
+            in.notBefore = static_cast<i64>(time(nullptr)) + delay;
+        }
+
+        if (result.count("cron"))
+        {
+            in.cron = result["cron"].as<std::string>();
+        }
+
+        in.maxRetries = result["retries"].as<i32>();
+        in.backoff = result["backoff"].as<i32>();
+        in.backoffMax = result["backoffMax"].as<i32>();
+        in.timeout = result["timeout"].as<i32>();
+        in.idleOutputTimeout = result["idleTimeout"].as<i32>();
+        if (result.count("key"))
+        {
+            in.idempotencyKey = result["key"].as<std::string>();
+        }
+
+        if (result.count("inputs"))
+        {
+            in.inputs = result["inputs"].as<std::vector<std::string>>();
+        }
+
+        if (result.count("dependsOn"))
+        {
+            std::vector<std::string> refs = result["dependsOn"].as<std::vector<std::string>>();
+            Model::Proc::TaskRef ref;
+            for (auto it = refs.begin(); it != refs.end(); ++it)
+            {
+                // queue names may contain ':'
+                size_t pos = it->rfind(':');
+                ref.queue = (pos == std::string::npos) ? "" : it->substr(0, pos);
+                ref.ID = std::stoi((pos == std::string::npos) ? *it : it->substr(pos + 1));
+                in.dependsOn.push_back(ref);
+            }
+        }
+
         if (result.count("args"))
         {
             std::vector<std::string> args = result["args"].as<std::vector<std::string>>();
@@ -437,6 +556,12 @@ i32 Queue::add()
         fmt::println("{}", e.what());
         return 1;
     }
+    catch (...)
+    {
+        // std::stoi of dependsOn
+        fmt::println("Invalid task reference");
+        return 1;
+    }
 
     if (m_queue->addTask(in))
     {
@@ -444,10 +569,352 @@ i32 Queue::add()
         return 1;
     }
 
+    fmt::println("done, ID: {}", in.ID);
+    return 0;
+}
+
+i32 Queue::priority()
+{
+    if (Global::args.argc() == 1)
+    {
+        fmt::print("{}", m_priorityOpts.help());
+        return 0;
+    }
+
+    i32 id(0), priority(0);
+    try
+    {
+        auto result = m_priorityOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_priorityOpts.help());
+            return 0;
+        }
+
+        if (!result.count("id") || !result.count("priority"))
+        {
+            fmt::print("{}", m_priorityOpts.help());
+            return 1;
+        }
+
+        id = result["id"].as<i32>();
+        priority = result["priority"].as<i32>();
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    if (m_queue->setPriority(id, priority))
+    {
+        fmt::println("Fail to set priority");
+        return 1;
+    }
+
     fmt::println("done");
     return 0;
 }
 
+i32 Queue::history()
+{
+    if (Global::args.argc() == 1)
+    {
+        fmt::print("{}", m_historyOpts.help());
+        return 0;
+    }
+
+    i32 id(0);
+    try
+    {
+        auto result = m_historyOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_historyOpts.help());
+            return 0;
+        }
+
+        if (!result.count("id"))
+        {
+            fmt::print("{}", m_historyOpts.help());
+            return 1;
+        }
+
+        id = result["id"].as<i32>();
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    std::vector<Model::Proc::Attempt> out;
+    if (m_queue->taskHistory(id, out))
+    {
+        fmt::println("Fail to get task history");
+        return 1;
+    }
+
+    fmt::println("");
+    if (out.empty())
+    {
+        fmt::println("history is empty");
+        return 0;
+    }
+
+    for (auto it = out.begin(); it != out.end(); ++it)
+    {
+        fmt::println("attempt: {} exitCode: {} endTime: {}",
+                     it->attempt, it->exitCode, it->endTime);
+    }
+
+    return 0;
+}
+
+i32 Queue::stats()
+{
+    Model::DAO::HistoryFilter filter;
+    try
+    {
+        auto result = m_statsOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_statsOpts.help());
+            return 0;
+        }
+
+        i64 minutes = result["minutes"].as<i64>();
+        if (minutes <= 0)
+        {
+            fmt::print("{}", m_statsOpts.help());
+            return 1;
+        }
+
+        filter.to = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        filter.from = std::max<i64>(filter.to - minutes * 60000, 0);
+        if (result.count("exec"))
+        {
+            filter.execName = result["exec"].as<std::string>();
+        }
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    Model::DAO::HistoryStats out;
+    if (m_queue->historyStats(filter, out))
+    {
+        fmt::println("Fail to get history stats");
+        return 1;
+    }
+
+    fmt::println("count:        {}", out.count);
+    fmt::println("succeeded:    {}", out.succeeded);
+    fmt::println("success rate: {:.2f}%", out.successRate * 100);
+    fmt::println("p50:          {} ms", out.p50);
+    fmt::println("p95:          {} ms", out.p95);
+    fmt::println("p99:          {} ms", out.p99);
+    fmt::println("cpu time:     {} ms", out.cpuTime);
+    return 0;
+}
+
+i32 Queue::log()
+{
+    if (Global::args.argc() == 1)
+    {
+        fmt::print("{}", m_logOpts.help());
+        return 0;
+    }
+
+    i32 id(0);
+    try
+    {
+        auto result = m_logOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_logOpts.help());
+            return 0;
+        }
+
+        if (!result.count("id"))
+        {
+            fmt::print("{}", m_logOpts.help());
+            return 1;
+        }
+
+        id = result["id"].as<i32>();
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    std::string out;
+    if (m_queue->finishedOutput(id, out))
+    {
+        fmt::println("Fail to get output log");
+        return 1;
+    }
+
+    fmt::print("{}", out);
+    fmt::println("");
+    return 0;
+}
+
+i32 Queue::wait()
+{
+    if (Global::args.argc() == 1)
+    {
+        fmt::print("{}", m_waitOpts.help());
+        return 0;
+    }
+
+    std::vector<int> ids;
+    bool any(false);
+    i32 timeout(0);
+    try
+    {
+        auto result = m_waitOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_waitOpts.help());
+            return 0;
+        }
+
+        if (!result.count("id"))
+        {
+            fmt::print("{}", m_waitOpts.help());
+            return 1;
+        }
+
+        ids = result["id"].as<std::vector<int>>();
+        any = result.count("any");
+        timeout = result["timeout"].as<i32>();
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    if (timeout < 0)
+    {
+        fmt::println("Timeout must not be negative");
+        return 1;
+    }
+
+    i64 deadline(0);
+    if (timeout)
+    {
+        deadline = static_cast<i64>(time(nullptr)) + timeout;
+    }
+
+    std::vector<Model::Proc::Task> out;
+    u8 code = m_queue->waitTasks(ids, any, deadline, []()
+    {
+        return true;
+    }, out);
+
+    if (code && code != ErrCode_DEADLINE_EXCEEDED)
+    {
+        fmt::println("Fail to wait for tasks");
+        return 1;
+    }
+
+    for (auto it = out.begin(); it != out.end(); ++it)
+    {
+        fmt::println("");
+        it->print();
+    }
+
+    if (code)
+    {
+        fmt::println("");
+        fmt::println("Timeout");
+        return 1;
+    }
+
+    return 0;
+}
+
+i32 Queue::watch()
+{
+    i32 count(0);
+    try
+    {
+        auto result = m_watchOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_watchOpts.help());
+            return 0;
+        }
+
+        count = result["count"].as<i32>();
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    if (count < 0)
+    {
+        fmt::println("Count must not be negative");
+        return 1;
+    }
+
+    i32 printed(0);
+    u8 code = m_queue->watch([]()
+    {
+        return true;
+    },
+    [&](const Model::Event &event)
+    {
+        switch (event.type)
+        {
+        case EventType_RESYNC:
+            fmt::println("{} events are dropped, please list again", event.time);
+            break;
+        case EventType_ADDED:
+            fmt::println("{} added: {}", event.time, event.ID);
+            break;
+        case EventType_STARTED:
+            fmt::println("{} started: {}", event.time, event.ID);
+            break;
+        case EventType_FINISHED:
+            fmt::println("{} finished: {} exitCode: {} isSuccess: {}",
+                         event.time, event.ID, event.exitCode, event.isSuccess);
+            break;
+        case EventType_REMOVED:
+            fmt::println("{} removed: {}", event.time, event.ID);
+            break;
+        case EventType_PENDING_CLEARED:
+            fmt::println("{} pending list is cleared", event.time);
+            break;
+        case EventType_FINISHED_CLEARED:
+            fmt::println("{} finished list is cleared", event.time);
+            break;
+        default:
+            fmt::println("{} unknown event: {}", event.time, event.type);
+            break;
+        }
+
+        return !count || ++printed < count;
+    });
+
+    if (code)
+    {
+        fmt::println("Fail to watch queue");
+        return 1;
+    }
+
+    return 0;
+}
+
 i32 Queue::remove()
 {
     if (Global::args.argc() == 1)
@@ -75,6 +75,30 @@ private:
 
     i32 add();
 
+    cxxopts::Options m_priorityOpts = cxxopts::Options("priority", "change priority of pending task");
+
+    i32 priority();
+
+    cxxopts::Options m_historyOpts = cxxopts::Options("history", "print every run of the task");
+
+    i32 history();
+
+    cxxopts::Options m_statsOpts = cxxopts::Options("stats", "print statistics of the finished tasks");
+
+    i32 stats();
+
+    cxxopts::Options m_logOpts = cxxopts::Options("log", "print output of finished task");
+
+    i32 log();
+
+    cxxopts::Options m_waitOpts = cxxopts::Options("wait", "wait for tasks to finish");
+
+    i32 wait();
+
+    cxxopts::Options m_watchOpts = cxxopts::Options("watch", "print events of this queue");
+
+    i32 watch();
+
     cxxopts::Options m_removeOpts = cxxopts::Options("remove", "remove task to this queue");
 
     i32 remove();
@@ -37,9 +37,20 @@ namespace CLI
 {
 
 QueueList::QueueList() :
-    m_queueList(nullptr)
+    m_queueList(nullptr),
+    m_isLocal(false)
 {}
 
+QueueList::~QueueList()
+{
+    if (m_isLocal)
+    {
+        // the queues stop their loops on the executor
+        m_queueList = nullptr;
+        Controller::Global::runtimeFin();
+    }
+}
+
 // public member functions
 u8 QueueList::init()
 {
@@ -53,6 +64,13 @@ u8 QueueList::init()
         }
         case BACKEND_SQLITE:
         {
+            if (Controller::Global::runtimeInit())
+            {
+                spdlog::error("{}:{} Fail to initialize runtime", __FILE__, __LINE__);
+                return 1;
+            }
+
+            m_isLocal = true;
             ret = Controller::Global::sqliteInit(m_queueList, Global::config.address);
             break;
         }
@@ -73,6 +91,8 @@ u8 QueueList::init()
     m_funcs["delete"] = std::bind(&QueueList::Delete, this);
     m_funcs["list"] = std::bind(&QueueList::list, this);
     m_funcs["rename"] = std::bind(&QueueList::rename, this);
+    m_funcs["share"] = std::bind(&QueueList::share, this);
+    m_funcs["stats"] = std::bind(&QueueList::stats, this);
 
     m_createOpts.add_options()
         ("n,name", "the new queue name, the name cannot be empty", cxxopts::value<std::string>())
@@ -90,19 +110,31 @@ u8 QueueList::init()
         ("t,target", "the new name for source, cannot be empty", cxxopts::value<std::string>())
         ("h,help", "print help");
 
+    m_shareOpts.add_options()
+        ("n,name", "the queue name, the name cannot be empty", cxxopts::value<std::string>())
+        ("h,help", "print help");
+
+    m_statsOpts.add_options()
+        ("n,name", "the queue name, all queues if omitted", cxxopts::value<std::string>())
+        ("h,help", "print help");
+
     return 0;
 }
 
 i32 QueueList::run()
 {
-    m_prefix = Global::config.address + ":";
-    m_prefix += std::to_string(Global::config.port);
+    m_prefix = Global::config.address;
+    if (Global::config.address.rfind("unix:", 0) != 0)
+    {
+        m_prefix += ":";
+        m_prefix += std::to_string(Global::config.port);
+    }
     std::string prefix = m_prefix + "> ";
     i32 ret(0);
 
     while (Global::keepRunning.load(std::memory_order_relaxed))
     {
-        // vaild command: create delete list rename help exit
+        // vaild command: create delete list rename share stats help exit
         if (Global::args.getArgs(prefix))
         {
             fmt::println("Fail to get command");
@@ -114,7 +146,7 @@ i32 QueueList::run()
             // vaild command: help exit "queue name"
             if (Global::args.args().at(0) == "help")
             {
-                fmt::println("Valid command: create delete list rename help exit");
+                fmt::println("Valid command: create delete list rename share stats help exit");
                 fmt::println("Please type \"<command> -h\" for more details.");
                 fmt::println("Please type \"help\" to show this message.");
                 fmt::println("Please type \"exit\" to exit.");
@@ -339,6 +371,126 @@ i32 QueueList::rename()
     return 0;
 }
 
+i32 QueueList::share()
+{
+    if (Global::args.argc() == 1)
+    {
+        fmt::print("{}", m_shareOpts.help());
+        return 0;
+    }
+
+    std::string name;
+    try
+    {
+        auto result = m_shareOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_shareOpts.help());
+            return 0;
+        }
+
+        if (!result.count("name"))
+        {
+            fmt::print("{}", m_shareOpts.help());
+            return 1;
+        }
+
+        name = result["name"].as<std::string>();
+        if (name.empty())
+        {
+            fmt::print("{}", m_shareOpts.help());
+            return 1;
+        }
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    Model::Scheduler::Share out;
+    if (m_queueList->queueShare(name, out))
+    {
+        fmt::println("Fail to get share of queue");
+        return 1;
+    }
+
+    fmt::println("weight:   {}", out.weight);
+    fmt::println("priority: {}", out.priority);
+    fmt::println("consumed: {} ms", out.consumed);
+    fmt::println("tasks:    {}", out.tasks);
+    fmt::println("running:  {}", out.running);
+    fmt::println("waiting:  {}", out.waiting);
+    return 0;
+}
+
+static void printStats(const Model::DAO::QueueStats &in)
+{
+    fmt::println("{}:", in.name);
+    fmt::println("  pending:        {}", in.pending);
+    fmt::println("  finished:       {}", in.finished);
+    fmt::println("  failed:         {}", in.failed);
+    fmt::println("  running:        {}", in.running);
+    fmt::println("  oldest pending: {} ms", in.oldestPendingAge);
+    fmt::println("  avg duration:   {} ms", in.averageDuration);
+}
+
+i32 QueueList::stats()
+{
+    std::string name;
+    try
+    {
+        auto result = m_statsOpts.parse(Global::args.argc(), Global::args.argv());
+        if (result.count("help"))
+        {
+            fmt::print("{}", m_statsOpts.help());
+            return 0;
+        }
+
+        if (result.count("name"))
+        {
+            name = result["name"].as<std::string>();
+            if (name.empty())
+            {
+                fmt::print("{}", m_statsOpts.help());
+                return 1;
+            }
+        }
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        fmt::println("{}", e.what());
+        return 1;
+    }
+
+    if (name.empty())
+    {
+        std::vector<Model::DAO::QueueStats> out;
+        if (m_queueList->allQueueStats(out))
+        {
+            fmt::println("Fail to get stats of queues");
+            return 1;
+        }
+
+        for (auto it = out.begin(); it != out.end(); ++it)
+        {
+            printStats(*it);
+        }
+
+        return 0;
+    }
+
+    Model::DAO::QueueStats out;
+    if (m_queueList->queueStats(name, out))
+    {
+        fmt::println("Fail to get stats of queue");
+        return 1;
+    }
+
+    printStats(out);
+    return 0;
+}
+
 i32 QueueList::enter()
 {
     auto ptr = m_queueList->getQueue(Global::args.args().at(0));
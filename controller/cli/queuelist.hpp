@@ -45,6 +45,8 @@ public:
 
     QueueList();
 
+    ~QueueList();
+
     u8 init();
 
     i32 run();
@@ -55,6 +57,9 @@ private:
 
     std::shared_ptr<Model::DAO::IQueueList> m_queueList;
 
+    // the sqlite backend runs the queues in this process
+    bool m_isLocal;
+
     std::unordered_map<std::string, std::function<i32(void)>> m_funcs;
 
     cxxopts::Options m_createOpts = cxxopts::Options("create", "create new queue");
@@ -73,6 +78,14 @@ private:
 
     i32 rename();
 
+    cxxopts::Options m_shareOpts = cxxopts::Options("share", "show scheduler share of the queue");
+
+    i32 share();
+
+    cxxopts::Options m_statsOpts = cxxopts::Options("stats", "show statistics of the queue(s)");
+
+    i32 stats();
+
     i32 enter();
 }; // end class QueueList
 
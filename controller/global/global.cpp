@@ -27,8 +27,14 @@
 #include "model/dao/grpcqueuelist.hpp"
 #include "model/dao/sqliteconnect.hpp"
 #include "model/dao/sqlitequeuelist.hpp"
+#include "model/executor.hpp"
+#include "model/timer.hpp"
 #include "model/utils.hpp"
 
+#ifdef __linux__
+#include "model/proc/reactor.hpp"
+#endif
+
 #ifdef _WIN32
 #include "windows.h"
 #include "io.h"
@@ -175,6 +181,49 @@ u8 spdlogInit(const std::string &path)
     return 0;
 }
 
+u8 runtimeInit()
+{
+#ifdef __linux__
+    if (Model::Proc::Reactor::init())
+    {
+        spdlog::error("{}:{} Fail to initialize reactor", __FILE__, __LINE__);
+        return 1;
+    }
+#endif
+
+    // queues arm their scheduled tasks when they are loaded
+    if (Model::Timer::init())
+    {
+        spdlog::error("{}:{} Fail to initialize timer", __FILE__, __LINE__);
+#ifdef __linux__
+        Model::Proc::Reactor::fin();
+#endif
+        return 1;
+    }
+
+    // runs the queue loops
+    if (Model::Executor::init())
+    {
+        spdlog::error("{}:{} Fail to initialize executor", __FILE__, __LINE__);
+        Model::Timer::fin();
+#ifdef __linux__
+        Model::Proc::Reactor::fin();
+#endif
+        return 1;
+    }
+
+    return 0;
+}
+
+void runtimeFin()
+{
+    Model::Executor::fin();
+    Model::Timer::fin();
+#ifdef __linux__
+    Model::Proc::Reactor::fin();
+#endif
+}
+
 u8 sqliteInit(std::shared_ptr<Model::DAO::IQueueList> &out, const std::string &target)
 {
     Model::DAO::SQLiteConnect *conn(nullptr);
@@ -44,6 +44,13 @@ bool isAdmin();
 
 u8 spdlogInit(const std::string &);
 
+// the threads the queues of the sqlite backend run on: reactor, timer
+// and executor, must be called before sqliteInit()
+u8 runtimeInit();
+
+// all the queues must be destroyed before
+void runtimeFin();
+
 u8 sqliteInit(std::shared_ptr<Model::DAO::IQueueList> &out, const std::string &target);
 
 u8 grpcInit(std::shared_ptr<Model::DAO::IQueueList> &out, const std::string &target, const i32 port);
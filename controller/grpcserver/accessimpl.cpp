@@ -23,6 +23,8 @@
 
 #include "controller/global/defines.hpp"
 
+#include "reactors.hpp"
+
 #include "accessimpl.hpp"
 
 namespace Controller
@@ -31,14 +33,13 @@ namespace Controller
 namespace GRPCServer
 {
 
-grpc::Status AccessImpl::Echo(grpc::ServerContext* context,
-                              const ff::Empty* request,
-                              ff::EchoRes* response)
+grpc::ServerUnaryReactor *AccessImpl::Echo(grpc::CallbackServerContext *ctx,
+                                           const ff::Empty* request,
+                                           ff::EchoRes* response)
 {
-    UNUSED(context);
     UNUSED(request);
     UNUSED(response);
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
 } // end namespace GRPCServer
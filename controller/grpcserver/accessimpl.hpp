@@ -32,13 +32,13 @@ namespace Controller
 namespace GRPCServer
 {
 
-class AccessImpl : public ff::Access::Service
+class AccessImpl : public ff::Access::CallbackService
 {
 public:
 
-    grpc::Status Echo(grpc::ServerContext *context,
-                      const ff::Empty *request,
-                      ff::EchoRes *response) override;
+    grpc::ServerUnaryReactor *Echo(grpc::CallbackServerContext *ctx,
+                                   const ff::Empty *request,
+                                   ff::EchoRes *response) override;
 };
 
 } // end namespace GRPCServer
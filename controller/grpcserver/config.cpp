@@ -93,6 +93,11 @@ u8 Config::parse(Config *in, int argc, char **argv)
             ("L,log-level", "log level for spdlog", cxxopts::value<i32>(in->logLevel)->default_value("2"))
             ("a,address", "which addess will listen", cxxopts::value<std::string>(in->listenIP)->default_value("127.0.0.1"))
             ("p,port", "which port will listen", cxxopts::value<u16>(in->listenPort)->default_value("12345"))
+            ("u,unix-socket", "also listen on this unix domain socket", cxxopts::value<std::string>(in->unixSocket)->default_value(""))
+            ("s,slots", "max running tasks of all queues, 0 for number of cpus", cxxopts::value<u32>(in->slots)->default_value("0"))
+            ("t,max-threads", "max threads of the gRPC server, 0 for default", cxxopts::value<u32>(in->maxThreads)->default_value("0"))
+            ("m,metrics-port", "serve metrics for Prometheus on this local port, 0 for none", cxxopts::value<u16>(in->metricsPort)->default_value("0"))
+            ("simulate", "run no process, every task takes this many milliseconds", cxxopts::value<u32>(in->sim.duration))
             ("v,version", "print version")
             ("h,help", "print help")
             ;
@@ -110,6 +115,8 @@ u8 Config::parse(Config *in, int argc, char **argv)
             return 2;
         }
 
+        in->simulate = (result.count("simulate") > 0);
+
         if (!configFile.empty())
         {
             if (Model::DAO::DirUtils::verifyFile(configFile))
@@ -193,9 +200,41 @@ uint_fast8_t Config::parse(Config *obj, const std::string &path)
             return 1;
         }
 
+        if (config["unix socket"])
+        {
+            obj->unixSocket = config["unix socket"].as<std::string>();
+        }
+
+        if (config["slots"])
+        {
+            obj->slots = config["slots"].as<u32>();
+        }
+
+        if (config["max threads"])
+        {
+            obj->maxThreads = config["max threads"].as<u32>();
+        }
+
+        if (config["metrics port"])
+        {
+            obj->metricsPort = config["metrics port"].as<u16>();
+        }
+
         u8 level(0);
         level = config["log level"].as<u8>();
         obj->logLevel = static_cast<spdlog::level::level_enum>(level);
+
+        if (parseSimulate(obj, config["simulate"]))
+        {
+            spdlog::error("{}:{} fail to parse simulate", __FILE__, __LINE__);
+            return 1;
+        }
+
+        if (parseQueues(obj, config["queues"]))
+        {
+            spdlog::error("{}:{} fail to parse queues", __FILE__, __LINE__);
+            return 1;
+        }
     }
     catch (...)
     {
@@ -215,6 +254,101 @@ void Config::printVersion()
     fmt::println("version: " FF_VERSION);
 }
 
+u8 Config::parseQueues(Config *obj, const YAML::Node &node)
+{
+    obj->queues.clear();
+    if (!node)
+    {
+        return 0;
+    }
+
+    for (auto it = node.begin(); it != node.end(); ++it)
+    {
+        std::string name = it->first.as<std::string>();
+        const YAML::Node &queue = it->second;
+        QueueConfig queueConfig;
+
+        if (queue["cpus"] &&
+            Model::Proc::Affinity::parseCPUList(queue["cpus"].as<std::string>(),
+                                                queueConfig.affinity.cpus))
+        {
+            spdlog::error("{}:{} Invalid cpus for queue {}", __FILE__, __LINE__, name);
+            return 1;
+        }
+
+        if (queue["numa node"])
+        {
+            queueConfig.affinity.numaNode = queue["numa node"].as<i32>();
+        }
+
+        if (queue["round robin"])
+        {
+            queueConfig.affinity.roundRobin = queue["round robin"].as<bool>();
+        }
+
+        if (queue["priority"])
+        {
+            queueConfig.priority = queue["priority"].as<i32>();
+        }
+
+        if (queue["weight"])
+        {
+            queueConfig.weight = queue["weight"].as<u32>();
+            if (!queueConfig.weight)
+            {
+                spdlog::error("{}:{} Invalid weight for queue {}", __FILE__, __LINE__,
+                              name);
+                return 1;
+            }
+        }
+
+        if (queue["result cache"])
+        {
+            queueConfig.resultCache = queue["result cache"].as<bool>();
+        }
+
+        obj->queues[name] = queueConfig;
+    }
+
+    return 0;
+}
+
+u8 Config::parseSimulate(Config *obj, const YAML::Node &node)
+{
+    if (!node)
+    {
+        return 0;
+    }
+
+    obj->simulate = true;
+    if (node["duration"])
+    {
+        obj->sim.duration = node["duration"].as<u32>();
+    }
+
+    if (node["jitter"])
+    {
+        obj->sim.jitter = node["jitter"].as<u32>();
+    }
+
+    if (node["output lines"])
+    {
+        obj->sim.outputLines = node["output lines"].as<u32>();
+    }
+
+    if (node["fail rate"])
+    {
+        obj->sim.failRate = node["fail rate"].as<double>();
+        if (obj->sim.failRate < 0 || obj->sim.failRate > 1)
+        {
+            spdlog::error("{}:{} Invalid fail rate", __FILE__, __LINE__);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 } // end namespace GRPCServer
 
 } // end namespace Model
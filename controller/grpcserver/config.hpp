@@ -25,10 +25,14 @@
 #define _CONTROLLER_GRPCSERVER_CONFIG_HPP_
 
 #include <string>
+#include <unordered_map>
 
 #include "spdlog/common.h"
+#include "yaml-cpp/yaml.h"
 
 #include "controller/global/defines.hpp"
+#include "model/proc/affinity.hpp"
+#include "model/proc/simproc.hpp"
 
 namespace Controller
 {
@@ -36,6 +40,23 @@ namespace Controller
 namespace GRPCServer
 {
 
+class QueueConfig
+{
+public:
+
+    Model::Proc::Affinity affinity;
+
+    // priority for the host wide scheduler, higher is granted first
+    i32 priority = 0;
+
+    // share among queues of the same priority, must be > 0
+    u32 weight = 1;
+
+    // skip the tasks which have succeeded with the same definition and inputs
+    bool resultCache = false;
+
+}; // end class QueueConfig
+
 class Config
 {
 public:
@@ -56,11 +77,36 @@ public:
 
     std::string listenIP = "127.0.0.1";
 
+    // path of an additional unix domain socket for local clients,
+    // empty for tcp only
+    std::string unixSocket = "";
+
     i32 logLevel = static_cast<i32>(spdlog::level::level_enum::info);
 
+    // max concurrently running tasks of all queues, 0 for number of cpus
+    u32 slots = 0;
+
+    // max threads of the gRPC server, 0 for the default of gRPC
+    u32 maxThreads = 0;
+
+    // port on 127.0.0.1 for Prometheus to scrape the metrics, 0 for none
+    u16 metricsPort = 0;
+
+    // run SimProc instead of real processes, for profiling the server
+    bool simulate = false;
+
+    Model::Proc::SimConfig sim;
+
+    // per queue settings, key is queue name
+    std::unordered_map<std::string, QueueConfig> queues;
+
 private:
 
     static void printVersion();
+
+    static u8 parseQueues(Config *, const YAML::Node &);
+
+    static u8 parseSimulate(Config *, const YAML::Node &);
 };
 
 } // end namespace GRPCServer
@@ -21,10 +21,15 @@
  * SOFTWARE.
  */
 
+#include <thread>
+
 #include "spdlog/spdlog.h"
 
 #include "model/errmsg.hpp"
+#include "model/scheduler.hpp"
+#include "model/proc/procfactory.hpp"
 #include "model/dao/sqliteconnect.hpp"
+#include "model/dao/sqlitequeue.hpp"
 
 #include "controller/global/global.hpp"
 
@@ -62,12 +67,50 @@ u8 init(int argc, char **argv)
         return 1;
     }
 
+    if (config.slots)
+    {
+        Model::Scheduler::init(config.slots);
+    }
+    else
+    {
+        // hardware_concurrency() may return 0 if it is not computable
+        Model::Scheduler::init(std::thread::hardware_concurrency());
+    }
+
+    // must be chosen before any queue is created
+    if (config.simulate)
+    {
+        Model::Proc::Factory::simulate(config.sim);
+    }
+
+    if (Controller::Global::runtimeInit())
+    {
+        spdlog::error("{}:{} Fail to initialize runtime", __FILE__, __LINE__);
+        return 1;
+    }
+
     if (Controller::Global::sqliteInit(sqliteQueueList, config.dbPath))
     {
         spdlog::error("{}:{} Fail to initialize sqlite queue list", __FILE__, __LINE__);
         return 1;
     }
 
+    for (auto it = config.queues.begin(); it != config.queues.end(); ++it)
+    {
+        if (sqliteQueueList->getQueue(it->first) == nullptr)
+        {
+            // will be applied when the queue is created
+            continue;
+        }
+
+        if (applyQueueConfig(it->first))
+        {
+            spdlog::error("{}:{} Fail to apply config to queue {}", __FILE__, __LINE__,
+                          it->first);
+            return 1;
+        }
+    }
+
     Model::ErrMsg::init();
     if (config.logPath.empty())
     {
@@ -88,8 +131,49 @@ u8 init(int argc, char **argv)
     return 0;
 }
 
+u8 applyQueueConfig(const std::string &name)
+{
+    // a queue without an entry gets the defaults, it may have been renamed from
+    // a configured name
+    QueueConfig queueConfig;
+    auto it = config.queues.find(name);
+    if (it != config.queues.end())
+    {
+        queueConfig = it->second;
+    }
+
+    auto queue = std::dynamic_pointer_cast<Model::DAO::SQLiteQueue>(
+        sqliteQueueList->getQueue(name));
+    if (queue == nullptr)
+    {
+        spdlog::error("{}:{} No such queue: {}", __FILE__, __LINE__, name);
+        return 1;
+    }
+
+    Model::Scheduler::setPriority(queue.get(), queueConfig.priority);
+    if (Model::Scheduler::setWeight(queue.get(), queueConfig.weight))
+    {
+        spdlog::error("{}:{} Fail to set weight for queue {}", __FILE__, __LINE__,
+                      name);
+        return 1;
+    }
+
+    queue->setResultCache(queueConfig.resultCache);
+    if (queue->setAffinity(queueConfig.affinity))
+    {
+        spdlog::error("{}:{} Fail to set affinity for queue {}", __FILE__, __LINE__,
+                      name);
+        return 1;
+    }
+
+    return 0;
+}
+
 void fin()
 {
+    // stop the queues while their running tasks can still be reaped
+    sqliteQueueList = nullptr;
+    Controller::Global::runtimeFin();
     Global::consoleFin();
 }
 
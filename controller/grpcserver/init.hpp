@@ -46,6 +46,10 @@ extern std::shared_ptr<Model::DAO::IQueueList> sqliteQueueList;
 
 u8 init(int argc, char **argv);
 
+// apply the settings in "queues" section of config file to the queue, the
+// defaults if it has no entry
+u8 applyQueueConfig(const std::string &name);
+
 void fin();
 
 } // end namespace GRPCServer
@@ -0,0 +1,90 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "latencyinterceptor.hpp"
+
+namespace Controller
+{
+
+namespace GRPCServer
+{
+
+// "/ff.Queue/AddTask" to "Queue.AddTask"
+static std::string methodLabel(std::string_view method)
+{
+    size_t slash = method.rfind('/');
+    if (slash == std::string_view::npos || slash == 0)
+    {
+        return std::string(method);
+    }
+
+    std::string_view service = method.substr(0, slash);
+    size_t dot = service.find_last_of("./");
+    if (dot != std::string_view::npos)
+    {
+        service.remove_prefix(dot + 1);
+    }
+
+    return std::string(service) + "." + std::string(method.substr(slash + 1));
+}
+
+static Model::Metrics::Histogram &latencyOf(const char *method)
+{
+    // the registry takes a lock, every thread looks a method up only once
+    thread_local std::map<std::string, Model::Metrics::Histogram *, std::less<>> cache;
+    std::string_view key(method ? method : "");
+    auto it = cache.find(key);
+    if (it == cache.end())
+    {
+        Model::Metrics::Histogram &histogram = Model::Metrics::histogram(
+            "ff_rpc_duration_us", "method=\"" + methodLabel(key) + "\"");
+        it = cache.emplace(std::string(key), &histogram).first;
+    }
+
+    return *it->second;
+}
+
+LatencyInterceptor::LatencyInterceptor(grpc::experimental::ServerRpcInfo *info) :
+    m_scope(latencyOf(info->method()))
+{}
+
+void LatencyInterceptor::Intercept(grpc::experimental::InterceptorBatchMethods *methods)
+{
+    methods->Proceed();
+}
+
+grpc::experimental::Interceptor *
+LatencyInterceptorFactory::CreateServerInterceptor(grpc::experimental::ServerRpcInfo *info)
+{
+    return new LatencyInterceptor(info);
+}
+
+} // end namespace GRPCServer
+
+} // end namespace Controller
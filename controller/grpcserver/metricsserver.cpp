@@ -0,0 +1,214 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#ifndef _WIN32
+#include "arpa/inet.h"
+#include "netinet/in.h"
+#include "poll.h"
+#include "sys/socket.h"
+#include "unistd.h"
+#endif
+
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "model/metrics.hpp"
+
+#include "metricsserver.hpp"
+
+namespace Controller
+{
+
+namespace GRPCServer
+{
+
+MetricsServer::MetricsServer() :
+    m_fd(-1)
+{}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+#ifdef _WIN32
+u8 MetricsServer::start(u16 port)
+{
+    UNUSED(port);
+    spdlog::error("{}:{} Metrics port is not supported on Windows", __FILE__, __LINE__);
+    return 1;
+}
+
+void MetricsServer::stop()
+{}
+
+void MetricsServer::serve(std::stop_token token)
+{
+    UNUSED(token);
+}
+
+void MetricsServer::handle(int fd)
+{
+    UNUSED(fd);
+}
+#else
+u8 MetricsServer::start(u16 port)
+{
+    sockaddr_in addr = sockaddr_in();
+    int enable(1);
+
+    m_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd == -1)
+    {
+        spdlog::error("{}:{} Fail to create socket: {}", __FILE__, __LINE__,
+                      strerror(errno));
+        return 1;
+    }
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) ||
+        bind(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+        listen(m_fd, 16))
+    {
+        spdlog::error("{}:{} Fail to listen on port {}: {}", __FILE__, __LINE__,
+                      port, strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        return 1;
+    }
+
+    m_thread = std::jthread([this](std::stop_token token)
+    {
+        serve(token);
+    });
+
+    spdlog::info("{}:{} Metrics are served on 127.0.0.1:{}/metrics", __FILE__, __LINE__,
+                 port);
+    return 0;
+}
+
+void MetricsServer::stop()
+{
+    if (m_thread.joinable())
+    {
+        m_thread.request_stop();
+        m_thread.join();
+    }
+
+    if (m_fd != -1)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+// private member functions
+void MetricsServer::serve(std::stop_token token)
+{
+    pollfd pfd = pollfd();
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    while (!token.stop_requested())
+    {
+        // wake up now and then to see if we are asked to stop
+        if (poll(&pfd, 1, 500) <= 0)
+        {
+            continue;
+        }
+
+        int fd = accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd == -1)
+        {
+            continue;
+        }
+
+        handle(fd);
+        close(fd);
+    }
+}
+
+void MetricsServer::handle(int fd)
+{
+    // a slow client must not hold the thread
+    timeval timeout = timeval();
+    timeout.tv_sec = 1;
+    UNUSED(setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+    UNUSED(setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)));
+
+    std::string req;
+    char buf[1024];
+    while (req.find("\r\n\r\n") == std::string::npos && req.length() < 8192)
+    {
+        ssize_t len = recv(fd, buf, sizeof(buf), 0);
+        if (len <= 0)
+        {
+            return;
+        }
+
+        req.append(buf, static_cast<size_t>(len));
+    }
+
+    std::string body;
+    std::string status;
+    if (req.rfind("GET /metrics ", 0) == 0 || req.rfind("GET / ", 0) == 0)
+    {
+        status = "200 OK";
+        body = Model::Metrics::prometheus();
+    }
+    else
+    {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    std::string res = fmt::format("HTTP/1.1 {}\r\n"
+                                  "Content-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: {}\r\n"
+                                  "Connection: close\r\n"
+                                  "\r\n", status, body.length());
+    res += body;
+
+    size_t sent(0);
+    while (sent < res.length())
+    {
+        ssize_t len = send(fd, res.data() + sent, res.length() - sent, MSG_NOSIGNAL);
+        if (len <= 0)
+        {
+            return;
+        }
+
+        sent += static_cast<size_t>(len);
+    }
+}
+#endif
+
+} // end namespace GRPCServer
+
+} // end namespace Controller
@@ -0,0 +1,69 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _CONTROLLER_GRPCSERVER_METRICSSERVER_HPP_
+#define _CONTROLLER_GRPCSERVER_METRICSSERVER_HPP_
+
+#include <thread>
+
+#include "controller/global/defines.hpp"
+
+namespace Controller
+{
+
+namespace GRPCServer
+{
+
+// Minimal http server on 127.0.0.1 which answers "GET /metrics" with
+// Model::Metrics::prometheus(), for Prometheus to scrape.
+// Requests are served one by one on its own thread.
+class MetricsServer
+{
+public:
+
+    MetricsServer();
+
+    ~MetricsServer();
+
+    u8 start(u16 port);
+
+    void stop();
+
+private:
+
+    int m_fd;
+
+    std::jthread m_thread;
+
+    void serve(std::stop_token token);
+
+    void handle(int fd);
+
+}; // end class MetricsServer
+
+} // end namespace GRPCServer
+
+} // end namespace Controller
+
+#endif // _CONTROLLER_GRPCSERVER_METRICSSERVER_HPP_
@@ -24,8 +24,10 @@
 #include "spdlog/spdlog.h"
 
 #include "model/errmsg.hpp"
+#include "model/dao/sqlitequeue.hpp"
 
 #include "init.hpp"
+#include "reactors.hpp"
 
 #include "queueimpl.hpp"
 
@@ -35,23 +37,24 @@ namespace Controller
 namespace GRPCServer
 {
 
-grpc::Status
-QueueImpl::ListPending(grpc::ServerContext *ctx,
-                       const ff::QueueReq *req,
-                       grpc::ServerWriter<ff::ListTaskRes> *writer)
+grpc::ServerWriteReactor<ff::ListTaskRes> *
+QueueImpl::ListPending(grpc::CallbackServerContext *ctx,
+                       const ff::QueueReq *req)
 {
     UNUSED(ctx);
-    if (!req || !writer)
+    if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     std::vector<int> out;
@@ -59,36 +62,39 @@ QueueImpl::ListPending(grpc::ServerContext *ctx,
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to list pending");
+        return new ListReactor<ff::ListTaskRes>(
+            Model::ErrMsg::toGRPCStatus(code, "Fail to list pending"));
     }
 
+    std::vector<ff::ListTaskRes> replies;
     ff::ListTaskRes res;
     for (auto it = out.begin(); it != out.end(); ++it)
     {
         res.set_id(*it);
-        writer->Write(res);
+        replies.push_back(res);
     }
 
-    return grpc::Status::OK;
+    return new ListReactor<ff::ListTaskRes>(std::move(replies));
 }
 
-grpc::Status
-QueueImpl::ListFinished(grpc::ServerContext *ctx,
-                        const ff::QueueReq *req,
-                        grpc::ServerWriter<ff::ListTaskRes> *writer)
+grpc::ServerWriteReactor<ff::ListTaskRes> *
+QueueImpl::ListFinished(grpc::CallbackServerContext *ctx,
+                        const ff::QueueReq *req)
 {
     UNUSED(ctx);
-    if (!req || !writer)
+    if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     std::vector<int> out;
@@ -96,17 +102,19 @@ QueueImpl::ListFinished(grpc::ServerContext *ctx,
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to list finished");
+        return new ListReactor<ff::ListTaskRes>(
+            Model::ErrMsg::toGRPCStatus(code, "Fail to list finished"));
     }
 
+    std::vector<ff::ListTaskRes> replies;
     ff::ListTaskRes res;
     for (auto it = out.begin(); it != out.end(); ++it)
     {
         res.set_id(*it);
-        writer->Write(res);
+        replies.push_back(res);
     }
 
-    return grpc::Status::OK;
+    return new ListReactor<ff::ListTaskRes>(std::move(replies));
 }
 
 static void
@@ -127,25 +135,54 @@ buildTaskDetailsRes(Model::Proc::Task &task, ff::TaskDetailsRes *res)
 
     res->set_exitcode(task.exitCode);
     res->set_id(task.ID);
+    res->set_priority(task.priority);
+    res->set_notbefore(task.notBefore);
+    res->set_cron(task.cron);
+    res->set_issuccess(task.isSuccess);
+    res->set_maxretries(task.maxRetries);
+    res->set_backoff(task.backoff);
+    res->set_backoffmax(task.backoffMax);
+    res->set_attempt(task.attempt);
+    res->set_timeout(task.timeout);
+    res->set_idleoutputtimeout(task.idleOutputTimeout);
+    res->set_timedout(task.timedOut);
+    for (auto it = task.inputs.begin(); it != task.inputs.end(); ++it)
+    {
+        res->add_inputs(*it);
+    }
+
+    res->set_cached(task.cached);
+    for (auto it = task.dependsOn.begin(); it != task.dependsOn.end(); ++it)
+    {
+        ff::TaskDetailsReq *ref = res->add_dependson();
+        ref->set_name(it->queue);
+        ref->set_id(it->ID);
+    }
+
+    res->set_enqueuetime(task.enqueueTime);
+    res->set_starttime(task.startTime);
+    res->set_endtime(task.endTime);
+    res->set_waittime(task.waitTime);
+    res->set_runtime(task.runTime);
+    res->set_cputime(task.cpuTime);
 }
 
-grpc::Status
-QueueImpl::PendingDetails(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::PendingDetails(grpc::CallbackServerContext *ctx,
                           const ff::TaskDetailsReq *req,
                           ff::TaskDetailsRes *res)
 {
-    UNUSED(ctx);
     if (!req || !res)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     Model::Proc::Task out;
@@ -153,30 +190,29 @@ QueueImpl::PendingDetails(grpc::ServerContext *ctx,
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to get pending detailes");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get pending detailes"));
     }
 
     buildTaskDetailsRes(out, res);
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::FinishedDetails(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::FinishedDetails(grpc::CallbackServerContext *ctx,
                            const ff::TaskDetailsReq *req,
                            ff::TaskDetailsRes *res)
 {
-    UNUSED(ctx);
     if (!req || !res)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     Model::Proc::Task out;
@@ -184,90 +220,555 @@ QueueImpl::FinishedDetails(grpc::ServerContext *ctx,
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to get pending detailes");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get pending detailes"));
+    }
+
+    buildTaskDetailsRes(out, res);
+    return finish(ctx, grpc::Status::OK);
+}
+
+grpc::ServerWriteReactor<ff::ListTaskRes> *
+QueueImpl::ListScheduled(grpc::CallbackServerContext *ctx,
+                         const ff::QueueReq *req)
+{
+    UNUSED(ctx);
+    if (!req)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    std::vector<int> out;
+    u8 code = queue->listScheduled(out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::ListTaskRes>(
+            Model::ErrMsg::toGRPCStatus(code, "Fail to list scheduled"));
+    }
+
+    std::vector<ff::ListTaskRes> replies;
+    ff::ListTaskRes res;
+    for (auto it = out.begin(); it != out.end(); ++it)
+    {
+        res.set_id(*it);
+        replies.push_back(res);
+    }
+
+    return new ListReactor<ff::ListTaskRes>(std::move(replies));
+}
+
+grpc::ServerUnaryReactor *
+QueueImpl::ScheduledDetails(grpc::CallbackServerContext *ctx,
+                            const ff::TaskDetailsReq *req,
+                            ff::TaskDetailsRes *res)
+{
+    if (!req || !res)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    Model::Proc::Task out;
+    u8 code = queue->scheduledDetails(req->id(), out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get scheduled details"));
+    }
+
+    buildTaskDetailsRes(out, res);
+    return finish(ctx, grpc::Status::OK);
+}
+
+grpc::ServerWriteReactor<ff::ListTaskRes> *
+QueueImpl::ListBlocked(grpc::CallbackServerContext *ctx,
+                       const ff::QueueReq *req)
+{
+    UNUSED(ctx);
+    if (!req)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::ListTaskRes>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    std::vector<int> out;
+    u8 code = queue->listBlocked(out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::ListTaskRes>(
+            Model::ErrMsg::toGRPCStatus(code, "Fail to list blocked"));
+    }
+
+    std::vector<ff::ListTaskRes> replies;
+    ff::ListTaskRes res;
+    for (auto it = out.begin(); it != out.end(); ++it)
+    {
+        res.set_id(*it);
+        replies.push_back(res);
+    }
+
+    return new ListReactor<ff::ListTaskRes>(std::move(replies));
+}
+
+grpc::ServerUnaryReactor *
+QueueImpl::BlockedDetails(grpc::CallbackServerContext *ctx,
+                          const ff::TaskDetailsReq *req,
+                          ff::TaskDetailsRes *res)
+{
+    if (!req || !res)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    Model::Proc::Task out;
+    u8 code = queue->blockedDetails(req->id(), out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get blocked details"));
     }
 
     buildTaskDetailsRes(out, res);
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::ClearPending(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::ClearPending(grpc::CallbackServerContext *ctx,
                         const ff::QueueReq *req,
                         ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
     if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     u8 code = queue->clearPending();
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to clean pending");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to clean pending"));
     }
 
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::ClearFinished(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::ClearFinished(grpc::CallbackServerContext *ctx,
                          const ff::QueueReq *req,
                          ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
     if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     u8 code = queue->clearFinished();
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to clean finished");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to clean finished"));
+    }
+
+    return finish(ctx, grpc::Status::OK);
+}
+
+grpc::ServerWriteReactor<ff::AttemptRes> *
+QueueImpl::TaskHistory(grpc::CallbackServerContext *ctx,
+                       const ff::TaskDetailsReq *req)
+{
+    UNUSED(ctx);
+    if (!req)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::AttemptRes>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::AttemptRes>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    std::vector<Model::Proc::Attempt> out;
+    u8 code = queue->taskHistory(req->id(), out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::AttemptRes>(
+            Model::ErrMsg::toGRPCStatus(code, "Fail to get task history"));
     }
 
-    return grpc::Status::OK;
+    std::vector<ff::AttemptRes> replies;
+    ff::AttemptRes res;
+    for (auto it = out.begin(); it != out.end(); ++it)
+    {
+        res.set_attempt(it->attempt);
+        res.set_exitcode(it->exitCode);
+        res.set_endtime(it->endTime);
+        replies.push_back(res);
+    }
+
+    return new ListReactor<ff::AttemptRes>(std::move(replies));
 }
 
-grpc::Status
-QueueImpl::CurrentTask(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::HistoryStats(grpc::CallbackServerContext *ctx,
+                        const ff::HistoryStatsReq *req,
+                        ff::HistoryStatsRes *res)
+{
+    if (!req || !res)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    Model::DAO::HistoryFilter filter;
+    filter.from = req->from();
+    filter.to = req->to();
+    filter.execName = req->execname();
+
+    Model::DAO::HistoryStats out;
+    u8 code = queue->historyStats(filter, out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get history stats"));
+    }
+
+    res->set_count(out.count);
+    res->set_succeeded(out.succeeded);
+    res->set_successrate(out.successRate);
+    res->set_p50(out.p50);
+    res->set_p95(out.p95);
+    res->set_p99(out.p99);
+    res->set_cputime(out.cpuTime);
+    return finish(ctx, grpc::Status::OK);
+}
+
+grpc::ServerUnaryReactor *
+QueueImpl::FinishedOutput(grpc::CallbackServerContext *ctx,
+                          const ff::TaskDetailsReq *req,
+                          ff::Msg *res)
+{
+    if (!req || !res)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    std::string out;
+    u8 code = queue->finishedOutput(req->id(), out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get output log"));
+    }
+
+    res->set_msg(out);
+    return finish(ctx, grpc::Status::OK);
+}
+
+// finished when the queue calls back, no thread is held while waiting
+class WaitReactor : public ListReactor<ff::TaskDetailsRes>
+{
+public:
+
+    explicit WaitReactor(std::shared_ptr<Model::DAO::SQLiteQueue> &queue) :
+        m_queue(queue),
+        m_handle(0)
+    {}
+
+    void start(const ff::WaitTasksReq *req)
+    {
+        std::vector<int> ids(req->ids().begin(), req->ids().end());
+        m_handle = m_queue->waitTasksAsync(ids, req->any(), req->deadline(),
+            [this](u8 code, std::vector<Model::Proc::Task> &out)
+        {
+            onFinished(code, out);
+        });
+    }
+
+    void OnCancel() override
+    {
+        // the client deadline cancels the call as well
+        m_queue->cancelWait(m_handle);
+    }
+
+private:
+
+    std::shared_ptr<Model::DAO::SQLiteQueue> m_queue;
+
+    u64 m_handle;
+
+    void onFinished(u8 code, std::vector<Model::Proc::Task> &out)
+    {
+        if (code && code != ErrCode_DEADLINE_EXCEEDED)
+        {
+            spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+            write(std::vector<ff::TaskDetailsRes>(),
+                  Model::ErrMsg::toGRPCStatus(code, "Fail to wait for tasks"));
+            return;
+        }
+
+        // the finished ones are sent on timeout as well
+        std::vector<ff::TaskDetailsRes> replies(out.size());
+        for (size_t i = 0; i < out.size(); ++i)
+        {
+            buildTaskDetailsRes(out.at(i), &replies.at(i));
+        }
+
+        write(std::move(replies), code ?
+              Model::ErrMsg::toGRPCStatus(code, "Deadline exceeded") :
+              grpc::Status::OK);
+    }
+
+}; // end class WaitReactor
+
+grpc::ServerWriteReactor<ff::TaskDetailsRes> *
+QueueImpl::WaitTasks(grpc::CallbackServerContext *ctx,
+                     const ff::WaitTasksReq *req)
+{
+    UNUSED(ctx);
+    if (!req)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::TaskDetailsRes>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = std::dynamic_pointer_cast<Model::DAO::SQLiteQueue>(
+        sqliteQueueList->getQueue(req->name()));
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::TaskDetailsRes>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    WaitReactor *reactor = new WaitReactor(queue);
+    reactor->start(req);
+    return reactor;
+}
+
+// Writes the events of a queue as they are published, one write in flight
+// at a time. Events published while writing wait in the subscription.
+class WatchReactor : public grpc::ServerWriteReactor<ff::QueueEvent>
+{
+public:
+
+    explicit WatchReactor(std::shared_ptr<Model::DAO::SQLiteQueue> &queue) :
+        m_queue(queue),
+        m_isWriting(false),
+        m_isFinished(false)
+    {
+        // publish() calls writeNext() with the lock of the bus held, so
+        // m_subscription is set after subscribe() returns, the events
+        // pushed meanwhile are written from here
+        auto subscription = m_queue->eventBus().subscribe([this]()
+        {
+            writeNext();
+        });
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_subscription = subscription;
+        }
+
+        writeNext();
+    }
+
+    void OnWriteDone(bool ok) override
+    {
+        if (!ok)
+        {
+            finish(grpc::Status(grpc::StatusCode::CANCELLED, "Fail to write"));
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_isWriting = false;
+        }
+
+        writeNext();
+    }
+
+    void OnCancel() override
+    {
+        finish(grpc::Status::CANCELLED);
+    }
+
+    void OnDone() override
+    {
+        // no more writeNext() from the publishers after this
+        m_queue->eventBus().unsubscribe(m_subscription);
+        delete this;
+    }
+
+private:
+
+    std::shared_ptr<Model::DAO::SQLiteQueue> m_queue;
+
+    std::mutex m_mutex;
+
+    // guarded by m_mutex
+    std::shared_ptr<Model::Subscription> m_subscription;
+
+    bool m_isWriting;
+
+    bool m_isFinished;
+
+    ff::QueueEvent m_res;
+
+    void writeNext()
+    {
+        Model::Event event;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_isWriting || m_isFinished || m_subscription == nullptr ||
+                m_subscription->tryPop(event))
+            {
+                return;
+            }
+
+            m_isWriting = true;
+        }
+
+        m_res.set_type(event.type);
+        m_res.set_id(event.ID);
+        m_res.set_exitcode(event.exitCode);
+        m_res.set_issuccess(event.isSuccess);
+        m_res.set_time(event.time);
+        StartWrite(&m_res);
+    }
+
+    void finish(const grpc::Status &status)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_isFinished)
+            {
+                return;
+            }
+
+            m_isFinished = true;
+        }
+
+        Finish(status);
+    }
+
+}; // end class WatchReactor
+
+grpc::ServerWriteReactor<ff::QueueEvent> *
+QueueImpl::WatchQueue(grpc::CallbackServerContext *ctx,
+                      const ff::QueueReq *req)
+{
+    UNUSED(ctx);
+    if (!req)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::QueueEvent>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = std::dynamic_pointer_cast<Model::DAO::SQLiteQueue>(
+        sqliteQueueList->getQueue(req->name()));
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::QueueEvent>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    return new WatchReactor(queue);
+}
+
+grpc::ServerUnaryReactor *
+QueueImpl::CurrentTask(grpc::CallbackServerContext *ctx,
                        const ff::QueueReq *req,
                        ff::TaskDetailsRes *res)
 {
-    UNUSED(ctx);
     if (!req || !res)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     Model::Proc::Task out;
@@ -275,30 +776,29 @@ QueueImpl::CurrentTask(grpc::ServerContext *ctx,
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to get current task");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get current task"));
     }
 
     buildTaskDetailsRes(out, res);
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::AddTask(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::AddTask(grpc::CallbackServerContext *ctx,
                    const ff::AddTaskReq *req,
                    ff::ListTaskRes *res)
 {
-    UNUSED(ctx);
     if (!req || !res)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     Model::Proc::Task in;
@@ -310,154 +810,219 @@ QueueImpl::AddTask(grpc::ServerContext *ctx,
         in.args.push_back(*it);
     }
 
+    in.priority = req->priority();
+    in.notBefore = req->notbefore();
+    in.cron = req->cron();
+    in.maxRetries = req->maxretries();
+    in.backoff = req->backoff();
+    in.backoffMax = req->backoffmax();
+    if (in.maxRetries < 0 || in.backoff < 0 || in.backoffMax < 0)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                        "Retry settings must not be negative"));
+    }
+
+    in.timeout = req->timeout();
+    in.idleOutputTimeout = req->idleoutputtimeout();
+    if (in.timeout < 0 || in.idleOutputTimeout < 0)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                        "Timeouts must not be negative"));
+    }
+
+    in.idempotencyKey = req->idempotencykey();
+    in.inputs.reserve(req->inputs_size());
+    for (auto it = req->inputs().begin(); it != req->inputs().end(); ++it)
+    {
+        in.inputs.push_back(*it);
+    }
+
+    Model::Proc::TaskRef ref;
+    in.dependsOn.reserve(req->dependson_size());
+    for (auto it = req->dependson().begin(); it != req->dependson().end(); ++it)
+    {
+        ref.queue = it->name();
+        ref.ID = it->id();
+        in.dependsOn.push_back(ref);
+    }
+
     u8 code = queue->addTask(in);
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to add task");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to add task"));
     }
 
     res->set_id(in.ID);
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::RemoveTask(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::RemoveTask(grpc::CallbackServerContext *ctx,
                       const ff::TaskDetailsReq *req,
                       ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
     if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     u8 code = queue->removeTask(req->id());
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to remove task");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to remove task"));
+    }
+
+    return finish(ctx, grpc::Status::OK);
+}
+
+grpc::ServerUnaryReactor *
+QueueImpl::SetPriority(grpc::CallbackServerContext *ctx,
+                       const ff::SetPriorityReq *req,
+                       ff::Empty *res)
+{
+    UNUSED(res);
+    if (!req)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
+    }
+
+    auto queue = sqliteQueueList->getQueue(req->name());
+    if (queue == nullptr)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
+    }
+
+    u8 code = queue->setPriority(req->id(), req->priority());
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to set priority"));
     }
 
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::IsRunning(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::IsRunning(grpc::CallbackServerContext *ctx,
                      const ff::QueueReq *req,
                      ff::IsRunningRes *res)
 {
-    UNUSED(ctx);
     if (!req || !res)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     res->set_isrunning(queue->isRunning());
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::ReadCurrentOutput(grpc::ServerContext *ctx,
-                             const ff::QueueReq *req,
-                             grpc::ServerWriter<ff::Msg> *writer)
+grpc::ServerWriteReactor<ff::Msg> *
+QueueImpl::ReadCurrentOutput(grpc::CallbackServerContext *ctx,
+                             const ff::QueueReq *req)
 {
     UNUSED(ctx);
-    if (!req || !writer)
+    if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return new ListReactor<ff::Msg>(
+            grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return new ListReactor<ff::Msg>(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     std::vector<std::string> output;
     queue->readCurrentOutput(output);
 
+    std::vector<ff::Msg> replies;
     ff::Msg res;
     for (auto it = output.begin(); it != output.end(); ++it)
     {
         res.set_msg(*it);
-        writer->Write(res);
+        replies.push_back(res);
     }
 
-    return grpc::Status::OK;
+    return new ListReactor<ff::Msg>(std::move(replies));
 }
 
-grpc::Status
-QueueImpl::Start(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::Start(grpc::CallbackServerContext *ctx,
                 const ff::QueueReq *req,
                 ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
     if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     u8 code = queue->start();
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to start queue");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to start queue"));
     }
 
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueImpl::Stop(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueImpl::Stop(grpc::CallbackServerContext *ctx,
                 const ff::QueueReq *req,
                 ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
     if (!req)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL, "Invalid input"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND, "Fail to get queue"));
     }
 
     queue->stop();
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
 } // end namespace GRPCServer
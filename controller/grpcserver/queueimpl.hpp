@@ -32,72 +32,114 @@ namespace Controller
 namespace GRPCServer
 {
 
-class QueueImpl : public ff::Queue::Service
+class QueueImpl : public ff::Queue::CallbackService
 {
 public:
 
-    grpc::Status
-    ListPending(grpc::ServerContext *ctx,
-                const ff::QueueReq *req,
-                grpc::ServerWriter<ff::ListTaskRes> *writer) override;
+    grpc::ServerWriteReactor<ff::ListTaskRes> *
+    ListPending(grpc::CallbackServerContext *ctx,
+                const ff::QueueReq *req) override;
 
-    grpc::Status
-    ListFinished(grpc::ServerContext *ctx,
-                 const ff::QueueReq *req,
-                 grpc::ServerWriter<ff::ListTaskRes> *writer) override;
+    grpc::ServerWriteReactor<ff::ListTaskRes> *
+    ListFinished(grpc::CallbackServerContext *ctx,
+                 const ff::QueueReq *req) override;
 
-    grpc::Status
-    PendingDetails(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    PendingDetails(grpc::CallbackServerContext *ctx,
                    const ff::TaskDetailsReq *req,
                    ff::TaskDetailsRes *res) override;
 
-    grpc::Status
-    FinishedDetails(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    FinishedDetails(grpc::CallbackServerContext *ctx,
                     const ff::TaskDetailsReq *req,
                     ff::TaskDetailsRes *res) override;
 
-    grpc::Status
-    ClearPending(grpc::ServerContext *ctx,
+    grpc::ServerWriteReactor<ff::ListTaskRes> *
+    ListScheduled(grpc::CallbackServerContext *ctx,
+                  const ff::QueueReq *req) override;
+
+    grpc::ServerUnaryReactor *
+    ScheduledDetails(grpc::CallbackServerContext *ctx,
+                     const ff::TaskDetailsReq *req,
+                     ff::TaskDetailsRes *res) override;
+
+    grpc::ServerWriteReactor<ff::ListTaskRes> *
+    ListBlocked(grpc::CallbackServerContext *ctx,
+                const ff::QueueReq *req) override;
+
+    grpc::ServerUnaryReactor *
+    BlockedDetails(grpc::CallbackServerContext *ctx,
+                   const ff::TaskDetailsReq *req,
+                   ff::TaskDetailsRes *res) override;
+
+    grpc::ServerUnaryReactor *
+    ClearPending(grpc::CallbackServerContext *ctx,
                  const ff::QueueReq *req,
                  ff::Empty *res) override;
 
-    grpc::Status
-    ClearFinished(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    ClearFinished(grpc::CallbackServerContext *ctx,
                   const ff::QueueReq *req,
                   ff::Empty *res) override;
 
-    grpc::Status
-    CurrentTask(grpc::ServerContext *ctx,
+    grpc::ServerWriteReactor<ff::AttemptRes> *
+    TaskHistory(grpc::CallbackServerContext *ctx,
+                const ff::TaskDetailsReq *req) override;
+
+    grpc::ServerUnaryReactor *
+    HistoryStats(grpc::CallbackServerContext *ctx,
+                 const ff::HistoryStatsReq *req,
+                 ff::HistoryStatsRes *res) override;
+
+    grpc::ServerUnaryReactor *
+    FinishedOutput(grpc::CallbackServerContext *ctx,
+                   const ff::TaskDetailsReq *req,
+                   ff::Msg *res) override;
+
+    grpc::ServerWriteReactor<ff::TaskDetailsRes> *
+    WaitTasks(grpc::CallbackServerContext *ctx,
+              const ff::WaitTasksReq *req) override;
+
+    grpc::ServerWriteReactor<ff::QueueEvent> *
+    WatchQueue(grpc::CallbackServerContext *ctx,
+               const ff::QueueReq *req) override;
+
+    grpc::ServerUnaryReactor *
+    CurrentTask(grpc::CallbackServerContext *ctx,
                 const ff::QueueReq *req,
                 ff::TaskDetailsRes *res) override;
 
-    grpc::Status
-    AddTask(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    AddTask(grpc::CallbackServerContext *ctx,
             const ff::AddTaskReq *req,
             ff::ListTaskRes *res) override;
 
-    grpc::Status
-    RemoveTask(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    RemoveTask(grpc::CallbackServerContext *ctx,
                const ff::TaskDetailsReq *req,
                ff::Empty *res) override;
 
-    grpc::Status
-    IsRunning(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    SetPriority(grpc::CallbackServerContext *ctx,
+                const ff::SetPriorityReq *req,
+                ff::Empty *res) override;
+
+    grpc::ServerUnaryReactor *
+    IsRunning(grpc::CallbackServerContext *ctx,
               const ff::QueueReq *req,
               ff::IsRunningRes *res) override;
 
-    grpc::Status
-    ReadCurrentOutput(grpc::ServerContext *ctx,
-                      const ff::QueueReq *req,
-                      grpc::ServerWriter<ff::Msg> *writer) override;
+    grpc::ServerWriteReactor<ff::Msg> *
+    ReadCurrentOutput(grpc::CallbackServerContext *ctx,
+                      const ff::QueueReq *req) override;
 
-    grpc::Status
-    Start(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    Start(grpc::CallbackServerContext *ctx,
           const ff::QueueReq *req,
           ff::Empty *res) override;
 
-    grpc::Status
-    Stop(grpc::ServerContext *ctx,
+    grpc::ServerUnaryReactor *
+    Stop(grpc::CallbackServerContext *ctx,
          const ff::QueueReq *req,
          ff::Empty *res) override;
 };
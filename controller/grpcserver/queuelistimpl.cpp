@@ -26,6 +26,7 @@
 #include "controller/global/defines.hpp"
 #include "model/errmsg.hpp"
 #include "init.hpp"
+#include "reactors.hpp"
 
 #include "queuelistimpl.hpp"
 
@@ -35,157 +36,263 @@ namespace Controller
 namespace GRPCServer
 {
 
-grpc::Status
-QueueListImpl::Create(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueListImpl::Create(grpc::CallbackServerContext *ctx,
                       const ff::QueueReq *req,
                       ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
 
     if (!req)
     {
         spdlog::critical("{}:{} invalid input", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL,
-                            "Internal server error");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Internal server error"));
     }
 
     if (req->name().empty())
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                            "\"name\" is empty string");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                        "\"name\" is empty string"));
     }
 
     u8 code = sqliteQueueList->createQueue(req->name());
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to create queue");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to create queue"));
+    }
+
+    if (applyQueueConfig(req->name()))
+    {
+        // not created unless it runs with its config
+        if (sqliteQueueList->deleteQueue(req->name()))
+        {
+            spdlog::error("{}:{} Fail to delete queue {}", __FILE__, __LINE__,
+                          req->name());
+        }
+
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Fail to apply queue config"));
     }
 
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueListImpl::Rename(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueListImpl::Rename(grpc::CallbackServerContext *ctx,
                       const ff::RenameQueueReq *req,
                       ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
 
     if (!req)
     {
         spdlog::critical("{}:{} invalid input", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL,
-                            "Internal server error");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Internal server error"));
     }
 
     if (req->oldname().empty() || req->newname().empty())
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                            "\"oldName\" or \"newName\" is empty string");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                        "\"oldName\" or \"newName\" is empty string"));
     }
 
     u8 code = sqliteQueueList->renameQueue(req->oldname(), req->newname());
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to rename");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to rename"));
     }
 
-    return grpc::Status::OK;
+    if (applyQueueConfig(req->newname()))
+    {
+        // back to the old name and its config
+        if (sqliteQueueList->renameQueue(req->newname(), req->oldname()) ||
+            applyQueueConfig(req->oldname()))
+        {
+            spdlog::error("{}:{} Fail to rename queue {} back", __FILE__, __LINE__,
+                          req->newname());
+        }
+
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Fail to apply queue config"));
+    }
+
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueListImpl::Delete(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueListImpl::Delete(grpc::CallbackServerContext *ctx,
                       const ff::QueueReq *req,
                       ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
 
     if (!req)
     {
         spdlog::critical("{}:{} invalid input", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL,
-                            "Internal server error");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Internal server error"));
     }
 
     if (req->name().empty())
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                            "\"name\" is empty string");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                        "\"name\" is empty string"));
     }
 
     u8 code = sqliteQueueList->deleteQueue(req->name());
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to delete");
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to delete"));
     }
 
-    return grpc::Status::OK;
+    return finish(ctx, grpc::Status::OK);
 }
 
-grpc::Status
-QueueListImpl::List(grpc::ServerContext *ctx,
-                    const ff::Empty *req,
-                    grpc::ServerWriter<::ff::ListQueueRes> *writer)
+grpc::ServerWriteReactor<ff::ListQueueRes> *
+QueueListImpl::List(grpc::CallbackServerContext *ctx,
+                    const ff::Empty *req)
 {
     UNUSED(ctx);
     UNUSED(req);
 
-    if (!writer)
-    {
-        spdlog::critical("{}:{} invalid input", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL,
-                            "Internal server error");
-    }
-
     std::vector<std::string> out;
     u8 code = sqliteQueueList->listQueue(out);
     if (code)
     {
         spdlog::debug("{}:{} trace", __FILE__, __LINE__);
-        return Model::ErrMsg::toGRPCStatus(code, "Fail to list queue");
+        return new ListReactor<ff::ListQueueRes>(
+            Model::ErrMsg::toGRPCStatus(code, "Fail to list queue"));
     }
 
+    std::vector<ff::ListQueueRes> replies;
     ff::ListQueueRes toWrite;
     for (size_t i = 0; i < out.size(); ++i)
     {
         toWrite.set_name(out.at(i));
-        writer->Write(toWrite);
+        replies.push_back(toWrite);
     }
 
-    return grpc::Status::OK;
+    return new ListReactor<ff::ListQueueRes>(std::move(replies));
 }
 
-grpc::Status
-QueueListImpl::GetQueue(grpc::ServerContext *ctx,
+grpc::ServerUnaryReactor *
+QueueListImpl::GetQueue(grpc::CallbackServerContext *ctx,
                         const ff::QueueReq *req,
                         ff::Empty *res)
 {
-    UNUSED(ctx);
     UNUSED(res);
     if (!req)
     {
         spdlog::critical("{}:{} invalid input", __FILE__, __LINE__);
-        return grpc::Status(grpc::StatusCode::INTERNAL,
-                            "Internal server error");
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Internal server error"));
     }
 
     auto queue = sqliteQueueList->getQueue(req->name());
     if (queue == nullptr)
     {
-        return grpc::Status(grpc::StatusCode::NOT_FOUND,
-                            "No such queue");
+        return finish(ctx, grpc::Status(grpc::StatusCode::NOT_FOUND,
+                                        "No such queue"));
+    }
+
+    return finish(ctx, grpc::Status::OK);
+}
+
+grpc::ServerUnaryReactor *
+QueueListImpl::Share(grpc::CallbackServerContext *ctx,
+                     const ff::QueueReq *req,
+                     ff::QueueShareRes *res)
+{
+    if (!req || !res)
+    {
+        spdlog::critical("{}:{} invalid input", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Internal server error"));
+    }
+
+    Model::Scheduler::Share share;
+    u8 code = sqliteQueueList->queueShare(req->name(), share);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get share"));
+    }
+
+    res->set_weight(share.weight);
+    res->set_priority(share.priority);
+    res->set_consumed(share.consumed);
+    res->set_tasks(share.tasks);
+    res->set_running(share.running);
+    res->set_waiting(share.waiting);
+    return finish(ctx, grpc::Status::OK);
+}
+
+static void writeStats(const Model::DAO::QueueStats &in, ff::QueueStatsRes &out)
+{
+    out.set_name(in.name);
+    out.set_pending(in.pending);
+    out.set_finished(in.finished);
+    out.set_failed(in.failed);
+    out.set_running(in.running);
+    out.set_oldestpendingage(in.oldestPendingAge);
+    out.set_averageduration(in.averageDuration);
+}
+
+grpc::ServerUnaryReactor *
+QueueListImpl::QueueStats(grpc::CallbackServerContext *ctx,
+                          const ff::QueueReq *req,
+                          ff::QueueStatsRes *res)
+{
+    if (!req || !res)
+    {
+        spdlog::critical("{}:{} invalid input", __FILE__, __LINE__);
+        return finish(ctx, grpc::Status(grpc::StatusCode::INTERNAL,
+                                        "Internal server error"));
+    }
+
+    Model::DAO::QueueStats stats;
+    u8 code = sqliteQueueList->queueStats(req->name(), stats);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return finish(ctx, Model::ErrMsg::toGRPCStatus(code, "Fail to get stats"));
+    }
+
+    writeStats(stats, *res);
+    return finish(ctx, grpc::Status::OK);
+}
+
+grpc::ServerWriteReactor<ff::QueueStatsRes> *
+QueueListImpl::AllQueueStats(grpc::CallbackServerContext *ctx,
+                             const ff::Empty *req)
+{
+    UNUSED(ctx);
+    UNUSED(req);
+
+    std::vector<Model::DAO::QueueStats> out;
+    u8 code = sqliteQueueList->allQueueStats(out);
+    if (code)
+    {
+        spdlog::debug("{}:{} trace", __FILE__, __LINE__);
+        return new ListReactor<ff::QueueStatsRes>(
+            Model::ErrMsg::toGRPCStatus(code, "Fail to get stats"));
+    }
+
+    std::vector<ff::QueueStatsRes> replies(out.size());
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+        writeStats(out.at(i), replies.at(i));
     }
 
-    return grpc::Status::OK;
+    return new ListReactor<ff::QueueStatsRes>(std::move(replies));
 }
 
 } // end namespace GRPCServer
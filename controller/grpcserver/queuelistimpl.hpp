@@ -32,29 +32,40 @@ namespace Controller
 namespace GRPCServer
 {
 
-class QueueListImpl : public ff::QueueList::Service
+class QueueListImpl : public ff::QueueList::CallbackService
 {
 public:
 
-    grpc::Status Create(grpc::ServerContext *ctx,
-                        const ff::QueueReq *req,
-                        ff::Empty *res) override;
+    grpc::ServerUnaryReactor *Create(grpc::CallbackServerContext *ctx,
+                                     const ff::QueueReq *req,
+                                     ff::Empty *res) override;
 
-    grpc::Status Rename(grpc::ServerContext *ctx,
-                        const ff::RenameQueueReq *req,
-                        ff::Empty *res) override;
+    grpc::ServerUnaryReactor *Rename(grpc::CallbackServerContext *ctx,
+                                     const ff::RenameQueueReq *req,
+                                     ff::Empty *res) override;
 
-    grpc::Status Delete(grpc::ServerContext *ctx,
-                        const ff::QueueReq *req,
-                        ff::Empty *res) override;
+    grpc::ServerUnaryReactor *Delete(grpc::CallbackServerContext *ctx,
+                                     const ff::QueueReq *req,
+                                     ff::Empty *res) override;
 
-    grpc::Status List(grpc::ServerContext *ctx,
-                      const ff::Empty *req,
-                      grpc::ServerWriter<::ff::ListQueueRes> *writer) override;
+    grpc::ServerWriteReactor<ff::ListQueueRes> *List(grpc::CallbackServerContext *ctx,
+                                                     const ff::Empty *req) override;
 
-    grpc::Status GetQueue(grpc::ServerContext *ctx,
-                          const ff::QueueReq *req,
-                          ff::Empty *res) override;
+    grpc::ServerUnaryReactor *GetQueue(grpc::CallbackServerContext *ctx,
+                                       const ff::QueueReq *req,
+                                       ff::Empty *res) override;
+
+    grpc::ServerUnaryReactor *Share(grpc::CallbackServerContext *ctx,
+                                    const ff::QueueReq *req,
+                                    ff::QueueShareRes *res) override;
+
+    grpc::ServerUnaryReactor *QueueStats(grpc::CallbackServerContext *ctx,
+                                         const ff::QueueReq *req,
+                                         ff::QueueStatsRes *res) override;
+
+    grpc::ServerWriteReactor<ff::QueueStatsRes> *
+    AllQueueStats(grpc::CallbackServerContext *ctx,
+                  const ff::Empty *req) override;
 
 }; // end class QueueListImpl
 
@@ -0,0 +1,135 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _CONTROLLER_GRPCSERVER_REACTORS_HPP_
+#define _CONTROLLER_GRPCSERVER_REACTORS_HPP_
+
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+#include "grpcpp/grpcpp.h"
+
+#include "model/metrics.hpp"
+
+namespace Controller
+{
+
+namespace GRPCServer
+{
+
+// failed calls by status code
+inline void countStatus(const grpc::Status &status)
+{
+    if (!status.ok())
+    {
+        Model::Metrics::counter("ff_rpc_errors_total",
+            fmt::format("code=\"{}\"", static_cast<int>(status.error_code()))).add();
+    }
+}
+
+// finish a unary call of the callback API at once
+inline grpc::ServerUnaryReactor *
+finish(grpc::CallbackServerContext *ctx, const grpc::Status &status)
+{
+    countStatus(status);
+    grpc::ServerUnaryReactor *reactor = ctx->DefaultReactor();
+    reactor->Finish(status);
+    return reactor;
+}
+
+// Server streaming reply which is known when the call is handled,
+// the messages are written one by one and the reactor deletes itself
+// when the call is done.
+template<class Res>
+class ListReactor : public grpc::ServerWriteReactor<Res>
+{
+public:
+
+    explicit ListReactor(const grpc::Status &status)
+    {
+        countStatus(status);
+        this->Finish(status);
+    }
+
+    explicit ListReactor(std::vector<Res> &&replies)
+    {
+        write(std::move(replies), grpc::Status::OK);
+    }
+
+    void OnWriteDone(bool ok) override
+    {
+        if (!ok)
+        {
+            this->Finish(grpc::Status(grpc::StatusCode::CANCELLED, "Fail to write"));
+            return;
+        }
+
+        writeNext();
+    }
+
+    void OnDone() override
+    {
+        delete this;
+    }
+
+protected:
+
+    // for the replies which are known later, call write() once
+    ListReactor() {}
+
+    // write all replies, then finish the call with "status"
+    void write(std::vector<Res> &&replies, const grpc::Status &status)
+    {
+        countStatus(status);
+        m_replies = std::move(replies);
+        m_status = status;
+        writeNext();
+    }
+
+private:
+
+    std::vector<Res> m_replies;
+
+    size_t m_next = 0;
+
+    grpc::Status m_status;
+
+    void writeNext()
+    {
+        if (m_next == m_replies.size())
+        {
+            this->Finish(m_status);
+            return;
+        }
+
+        this->StartWrite(&m_replies[m_next++]);
+    }
+
+}; // end class ListReactor
+
+} // end namespace GRPCServer
+
+} // end namespace Controller
+
+#endif // _CONTROLLER_GRPCSERVER_REACTORS_HPP_
@@ -27,6 +27,7 @@
 #include "server.hpp"
 
 #include "controller/grpcserver/init.hpp"
+#include "controller/grpcserver/latencyinterceptor.hpp"
 
 namespace Controller
 {
@@ -54,12 +55,61 @@ uint_fast8_t Server::start()
                                  grpc::InsecureServerCredentials(),
                                  &actualPort);
 
+        std::string unixAddr("");
+        if (!GRPCServer::config.unixSocket.empty())
+        {
+            // local clients can skip the tcp loopback, a stale socket file
+            // left by the last run is removed by gRPC itself
+            unixAddr = "unix:" + GRPCServer::config.unixSocket;
+            builder.AddListeningPort(unixAddr,
+                                     grpc::InsecureServerCredentials());
+        }
+
+        // the services use the callback API, calls (also the long lived
+        // streams) are served by the threads of gRPC instead of one thread
+        // per call
+        if (GRPCServer::config.maxThreads)
+        {
+            grpc::ResourceQuota quota("FFSERVER");
+            quota.SetMaxThreads(static_cast<int>(GRPCServer::config.maxThreads));
+            builder.SetResourceQuota(quota);
+            spdlog::info("{}:{} Max threads: {}", __FILE__, __LINE__,
+                         GRPCServer::config.maxThreads);
+        }
+
+        // every call is timed by method, see LatencyInterceptor
+        std::vector<std::unique_ptr<
+            grpc::experimental::ServerInterceptorFactoryInterface>> interceptors;
+        interceptors.push_back(std::make_unique<LatencyInterceptorFactory>());
+        builder.experimental().SetInterceptorCreators(std::move(interceptors));
+
         builder.RegisterService(&m_accessImpl);
         builder.RegisterService(&m_queueImpl);
         builder.RegisterService(&m_queueListImpl);
+        builder.RegisterService(&m_statsImpl);
         m_server = builder.BuildAndStart();
+        if (!m_server)
+        {
+            spdlog::error("{}:{} Fail to build server", __FILE__, __LINE__);
+            return 1;
+        }
+
         spdlog::info("{}:{} Server is listening on {}", __FILE__, __LINE__,
                      listenAddr);
+        if (!unixAddr.empty())
+        {
+            spdlog::info("{}:{} Server is listening on {}", __FILE__, __LINE__,
+                         unixAddr);
+        }
+
+        if (GRPCServer::config.metricsPort &&
+            m_metricsServer.start(GRPCServer::config.metricsPort))
+        {
+            spdlog::error("{}:{} Fail to start metrics server", __FILE__, __LINE__);
+            m_server->Shutdown();
+            m_server = nullptr;
+            return 1;
+        }
 
         auto serveFn = [this]()
         {
@@ -70,6 +120,7 @@ uint_fast8_t Server::start()
         m_future = m_exitRequested.get_future();
         m_future.wait();
         m_server->Shutdown();
+        m_metricsServer.stop();
         m_thread = std::jthread();
         m_server = nullptr;
     }
@@ -32,8 +32,10 @@
 
 #include "controller/global/defines.hpp"
 #include "accessimpl.hpp"
+#include "metricsserver.hpp"
 #include "queueimpl.hpp"
 #include "queuelistimpl.hpp"
+#include "statsimpl.hpp"
 
 #include <future>
 
@@ -71,6 +73,10 @@ private:
 
     QueueListImpl m_queueListImpl;
 
+    StatsImpl m_statsImpl;
+
+    MetricsServer m_metricsServer;
+
 };
 
 } // end namespace GRPCServer
@@ -0,0 +1,85 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "controller/global/defines.hpp"
+#include "model/metrics.hpp"
+#include "reactors.hpp"
+
+#include "statsimpl.hpp"
+
+namespace Controller
+{
+
+namespace GRPCServer
+{
+
+grpc::ServerWriteReactor<ff::MetricRes> *
+StatsImpl::List(grpc::CallbackServerContext *ctx,
+                const ff::Empty *req)
+{
+    UNUSED(ctx);
+    UNUSED(req);
+
+    std::vector<Model::Metrics::Metric> metrics;
+    Model::Metrics::collect(metrics);
+
+    std::vector<ff::MetricRes> replies;
+    replies.reserve(metrics.size());
+    for (auto it = metrics.begin(); it != metrics.end(); ++it)
+    {
+        ff::MetricRes res;
+        res.set_type(it->type);
+        res.set_name(it->name);
+        res.set_labels(it->labels);
+        res.set_value(it->value);
+        if (it->type == MetricType_HISTOGRAM)
+        {
+            res.set_count(it->histogram.count);
+            res.set_sum(it->histogram.sum);
+            res.set_max(it->histogram.max);
+            res.set_p50(it->histogram.quantile(0.5));
+            res.set_p90(it->histogram.quantile(0.9));
+            res.set_p99(it->histogram.quantile(0.99));
+            res.set_p999(it->histogram.quantile(0.999));
+        }
+
+        replies.push_back(res);
+    }
+
+    return new ListReactor<ff::MetricRes>(std::move(replies));
+}
+
+grpc::ServerUnaryReactor *
+StatsImpl::Prometheus(grpc::CallbackServerContext *ctx,
+                      const ff::Empty *req,
+                      ff::PrometheusRes *res)
+{
+    UNUSED(req);
+    res->set_text(Model::Metrics::prometheus());
+    return finish(ctx, grpc::Status::OK);
+}
+
+} // end namespace GRPCServer
+
+} // end namespace Controller
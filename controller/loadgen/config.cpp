@@ -0,0 +1,186 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "cxxopts.hpp"
+#include "spdlog/spdlog.h"
+
+#include "config.h"
+#include "config.hpp"
+
+namespace Controller
+{
+
+namespace LoadGen
+{
+
+static const char *opNames[LoadOp_COUNT] =
+{
+    "add",
+    "list",
+    "details",
+    "running",
+    "output"
+};
+
+u8 Config::parse(Config *in, int argc, char **argv)
+{
+    if (!in || !argv)
+    {
+        spdlog::error("{}:{} you should never see this line", __FILE__, __LINE__);
+        return 1;
+    }
+
+    std::string mix;
+    try
+    {
+        cxxopts::Options options("ff-loadgen", "load generator for FF Server");
+        options.add_options()
+            ("a,address", "address to FF server, or unix:<path> for local server", cxxopts::value<std::string>(in->address)->default_value("127.0.0.1"))
+            ("p,port", "which port is FF Server listening", cxxopts::value<u16>(in->port)->default_value("12345"))
+            ("q,queue", "queue to use, created if it does not exist", cxxopts::value<std::string>(in->queue)->default_value("loadgen"))
+            ("c,channels", "number of connections", cxxopts::value<u32>(in->channels)->default_value("4"))
+            ("k,inflight", "number of calls in flight", cxxopts::value<u32>(in->inflight)->default_value("64"))
+            ("d,duration", "seconds to run", cxxopts::value<u32>(in->duration)->default_value("10"))
+            ("e,exec-name", "program of the added tasks", cxxopts::value<std::string>(in->execName)->default_value("true"))
+            ("m,mix", "weight of every call, e.g. add=1,list=4,details=4,running=1,output=0", cxxopts::value<std::string>(mix)->default_value(""))
+            ("L,log-level", "log level for spdlog", cxxopts::value<i32>(in->logLevel)->default_value("4"))
+            ("v,version", "print version")
+            ("h,help", "print help")
+            ;
+
+        auto result = options.parse(argc, argv);
+        if (result.count("help"))
+        {
+            fmt::print("{}", options.help());
+            return 2;
+        }
+
+        if (result.count("version"))
+        {
+            fmt::println("ff-loadgen version info:");
+            fmt::println("branch:  " FF_BRANCH);
+            fmt::println("commit:  " FF_COMMIT);
+            fmt::println("version: " FF_VERSION);
+            return 2;
+        }
+    }
+    catch (const cxxopts::exceptions::exception &e)
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, e.what());
+        return 1;
+    }
+
+    if (!in->channels || !in->inflight || !in->duration)
+    {
+        spdlog::error("{}:{} channels, inflight and duration must be greater than 0",
+                      __FILE__, __LINE__);
+        return 1;
+    }
+
+    if (in->queue.empty())
+    {
+        spdlog::error("{}:{} Queue name is empty", __FILE__, __LINE__);
+        return 1;
+    }
+
+    if (!mix.empty() && parseMix(mix, in->mix))
+    {
+        spdlog::error("{}:{} Invalid mix: {}", __FILE__, __LINE__, mix);
+        return 1;
+    }
+
+    return 0;
+}
+
+const char *Config::opName(size_t op)
+{
+    return op < LoadOp_COUNT ? opNames[op] : "unknown";
+}
+
+// private member functions
+u8 Config::parseMix(const std::string &in, std::array<u32, LoadOp_COUNT> &out)
+{
+    // the calls which are not given are not made
+    std::array<u32, LoadOp_COUNT> mix = {};
+    size_t begin(0), end(0);
+    while (begin < in.length())
+    {
+        end = in.find(',', begin);
+        if (end == std::string::npos)
+        {
+            end = in.length();
+        }
+
+        std::string token = in.substr(begin, end - begin);
+        begin = end + 1;
+
+        size_t eq = token.find('=');
+        if (eq == std::string::npos)
+        {
+            return 1;
+        }
+
+        std::string name = token.substr(0, eq);
+        size_t op(0);
+        for (; op < LoadOp_COUNT; ++op)
+        {
+            if (name == opNames[op])
+            {
+                break;
+            }
+        }
+
+        if (op == LoadOp_COUNT)
+        {
+            return 1;
+        }
+
+        try
+        {
+            mix[op] = static_cast<u32>(std::stoul(token.substr(eq + 1)));
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
+    u64 total(0);
+    for (auto weight : mix)
+    {
+        total += weight;
+    }
+
+    if (!total)
+    {
+        return 1;
+    }
+
+    out = mix;
+    return 0;
+}
+
+} // end namespace LoadGen
+
+} // end namespace Controller
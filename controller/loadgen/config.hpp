@@ -0,0 +1,92 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _CONTROLLER_LOADGEN_CONFIG_HPP_
+#define _CONTROLLER_LOADGEN_CONFIG_HPP_
+
+#include <array>
+#include <string>
+
+#include "spdlog/common.h"
+
+#include "controller/global/defines.hpp"
+
+#define LoadOp_ADD_TASK            0
+#define LoadOp_LIST_PENDING        1
+#define LoadOp_PENDING_DETAILS     2
+#define LoadOp_IS_RUNNING          3
+#define LoadOp_READ_CURRENT_OUTPUT 4
+#define LoadOp_COUNT               5
+
+namespace Controller
+{
+
+namespace LoadGen
+{
+
+class Config
+{
+public:
+
+    // 0 for success, 1 for error, 2 for help or version is printed
+    static u8 parse(Config *in, int argc, char **argv);
+
+    // name of every LoadOp_*, as used by "mix"
+    static const char *opName(size_t op);
+
+    std::string address = "127.0.0.1";
+
+    u16 port = 12345;
+
+    // created if it does not exist, tasks are added but it is not started
+    std::string queue = "loadgen";
+
+    // separate connections to the server
+    u32 channels = 4;
+
+    // calls in flight, every one has its own thread
+    u32 inflight = 64;
+
+    // seconds
+    u32 duration = 10;
+
+    // program of the added tasks
+    std::string execName = "true";
+
+    // relative weight of every LoadOp_*
+    std::array<u32, LoadOp_COUNT> mix = {1, 4, 4, 1, 0};
+
+    i32 logLevel = static_cast<i32>(spdlog::level::level_enum::err);
+
+private:
+
+    static u8 parseMix(const std::string &in, std::array<u32, LoadOp_COUNT> &out);
+
+}; // end class Config
+
+} // end namespace LoadGen
+
+} // end namespace Controller
+
+#endif // _CONTROLLER_LOADGEN_CONFIG_HPP_
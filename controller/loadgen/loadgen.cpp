@@ -0,0 +1,258 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <random>
+#include <thread>
+
+#include "spdlog/spdlog.h"
+
+#include "controller/global/global.hpp"
+#include "loadgen.hpp"
+
+namespace Controller
+{
+
+namespace LoadGen
+{
+
+LoadGen::LoadGen() :
+    m_keepRunning(false)
+{
+    m_latency.fill(nullptr);
+    for (auto it = m_errors.begin(); it != m_errors.end(); ++it)
+    {
+        it->store(0, std::memory_order_relaxed);
+    }
+}
+
+LoadGen::~LoadGen()
+{}
+
+u8 LoadGen::init(const Config &config)
+{
+    m_config = config;
+    m_queueLists.clear();
+    m_queues.clear();
+    for (u32 i = 0; i < m_config.channels; ++i)
+    {
+        std::shared_ptr<Model::DAO::IQueueList> queueList;
+        if (Global::grpcInit(queueList, m_config.address, m_config.port))
+        {
+            spdlog::error("{}:{} Fail to connect to server", __FILE__, __LINE__);
+            return 1;
+        }
+
+        auto queue = queueList->getQueue(m_config.queue);
+        if (queue == nullptr && !i)
+        {
+            if (queueList->createQueue(m_config.queue))
+            {
+                spdlog::error("{}:{} Fail to create queue {}", __FILE__, __LINE__,
+                              m_config.queue);
+                return 1;
+            }
+
+            queue = queueList->getQueue(m_config.queue);
+        }
+
+        if (queue == nullptr)
+        {
+            spdlog::error("{}:{} Fail to get queue {}", __FILE__, __LINE__,
+                          m_config.queue);
+            return 1;
+        }
+
+        m_queueLists.push_back(queueList);
+        m_queues.push_back(queue);
+    }
+
+    // PendingDetails needs a task to ask for
+    Model::Proc::Task task = newTask();
+    if (m_queues[0]->addTask(task))
+    {
+        spdlog::error("{}:{} Fail to add task", __FILE__, __LINE__);
+        return 1;
+    }
+
+    m_seedIDs.push_back(task.ID);
+    for (size_t op = 0; op < LoadOp_COUNT; ++op)
+    {
+        m_latency[op] = &Model::Metrics::histogram("ff_loadgen_us",
+            fmt::format("op=\"{}\"", Config::opName(op)));
+    }
+
+    return 0;
+}
+
+u8 LoadGen::run()
+{
+    fmt::println("{} calls in flight over {} channels for {} seconds",
+                 m_config.inflight, m_config.channels, m_config.duration);
+
+    m_keepRunning.store(true, std::memory_order_relaxed);
+    auto begin = std::chrono::steady_clock::now();
+    m_end = begin + std::chrono::seconds(m_config.duration);
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(m_config.inflight);
+        for (u32 i = 0; i < m_config.inflight; ++i)
+        {
+            threads.emplace_back(&LoadGen::worker, this, i);
+        }
+    }
+
+    std::chrono::duration<double> used = std::chrono::steady_clock::now() - begin;
+    report(used.count());
+    return 0;
+}
+
+void LoadGen::stop()
+{
+    m_keepRunning.store(false, std::memory_order_relaxed);
+}
+
+// private member functions
+void LoadGen::worker(size_t index)
+{
+    auto &queue = m_queues[index % m_queues.size()];
+    std::mt19937 gen(static_cast<std::mt19937::result_type>(index));
+    std::discrete_distribution<size_t> pickOp(m_config.mix.begin(), m_config.mix.end());
+
+    // the tasks this worker has added, besides the seed
+    std::vector<int> ids = m_seedIDs;
+    std::vector<int> list;
+    std::vector<std::string> output;
+    Model::Proc::Task task;
+
+    while (m_keepRunning.load(std::memory_order_relaxed) &&
+           std::chrono::steady_clock::now() < m_end)
+    {
+        size_t op = pickOp(gen);
+        u8 code(0);
+        auto begin = std::chrono::steady_clock::now();
+        switch (op)
+        {
+        case LoadOp_ADD_TASK:
+        {
+            task = newTask();
+            code = queue->addTask(task);
+            if (!code)
+            {
+                ids.push_back(task.ID);
+            }
+
+            break;
+        }
+        case LoadOp_LIST_PENDING:
+        {
+            code = queue->listPending(list);
+            break;
+        }
+        case LoadOp_PENDING_DETAILS:
+        {
+            std::uniform_int_distribution<size_t> pickID(0, ids.size() - 1);
+            code = queue->pendingDetails(ids[pickID(gen)], task);
+            break;
+        }
+        case LoadOp_IS_RUNNING:
+        {
+            // errors are not reported by IQueue
+            UNUSED(queue->isRunning());
+            break;
+        }
+        case LoadOp_READ_CURRENT_OUTPUT:
+        {
+            queue->readCurrentOutput(output);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        }
+
+        auto used = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin);
+        m_latency[op]->record(static_cast<u64>(used.count()));
+        if (code)
+        {
+            m_errors[op].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+Model::Proc::Task LoadGen::newTask() const
+{
+    Model::Proc::Task task;
+    task.execName = m_config.execName;
+    task.workDir = ".";
+    return task;
+}
+
+void LoadGen::report(double seconds) const
+{
+    Model::Metrics::HistogramSnapshot total, snapshot;
+    total.buckets.resize(Model::Metrics::Histogram::bucketCount, 0);
+    u64 errors(0);
+
+    fmt::println("{:<8} {:>10} {:>8} {:>12} {:>10} {:>10} {:>10} {:>10}",
+                 "call", "count", "errors", "calls/s", "p50 us", "p99 us", "p999 us",
+                 "max us");
+    auto print = [seconds](const char *name,
+                           const Model::Metrics::HistogramSnapshot &in,
+                           u64 errors)
+    {
+        fmt::println("{:<8} {:>10} {:>8} {:>12.1f} {:>10} {:>10} {:>10} {:>10}",
+                     name, in.count, errors, in.count / seconds,
+                     in.quantile(0.5), in.quantile(0.99), in.quantile(0.999), in.max);
+    };
+
+    for (size_t op = 0; op < LoadOp_COUNT; ++op)
+    {
+        m_latency[op]->snapshot(snapshot);
+        if (!snapshot.count)
+        {
+            continue;
+        }
+
+        u64 opErrors = m_errors[op].load(std::memory_order_relaxed);
+        print(Config::opName(op), snapshot, opErrors);
+
+        total.count += snapshot.count;
+        total.sum += snapshot.sum;
+        total.max = std::max(total.max, snapshot.max);
+        for (size_t i = 0; i < snapshot.buckets.size(); ++i)
+        {
+            total.buckets[i] += snapshot.buckets[i];
+        }
+
+        errors += opErrors;
+    }
+
+    print("total", total, errors);
+}
+
+} // end namespace LoadGen
+
+} // end namespace Controller
@@ -0,0 +1,95 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _CONTROLLER_LOADGEN_LOADGEN_HPP_
+#define _CONTROLLER_LOADGEN_LOADGEN_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "model/dao/iqueue.hpp"
+#include "model/dao/iqueuelist.hpp"
+#include "model/metrics.hpp"
+#include "config.hpp"
+
+namespace Controller
+{
+
+namespace LoadGen
+{
+
+// Drives a running server with "inflight" threads of blocking calls
+// through GRPCQueue, spread over "channels" connections, and reports the
+// throughput and latency of every kind of call.
+class LoadGen
+{
+public:
+
+    LoadGen();
+
+    ~LoadGen();
+
+    u8 init(const Config &config);
+
+    u8 run();
+
+    // may be called from a signal handler
+    void stop();
+
+private:
+
+    Config m_config;
+
+    std::atomic<bool> m_keepRunning;
+
+    // one per channel, their queue lists keep the connections
+    std::vector<std::shared_ptr<Model::DAO::IQueueList>> m_queueLists;
+
+    std::vector<std::shared_ptr<Model::DAO::IQueue>> m_queues;
+
+    // tasks added before the run, for PendingDetails
+    std::vector<int> m_seedIDs;
+
+    std::array<Model::Metrics::Histogram *, LoadOp_COUNT> m_latency;
+
+    std::array<std::atomic<u64>, LoadOp_COUNT> m_errors;
+
+    std::chrono::steady_clock::time_point m_end;
+
+    void worker(size_t index);
+
+    Model::Proc::Task newTask() const;
+
+    void report(double seconds) const;
+
+}; // end class LoadGen
+
+} // end namespace LoadGen
+
+} // end namespace Controller
+
+#endif // _CONTROLLER_LOADGEN_LOADGEN_HPP_
@@ -0,0 +1,60 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <csignal>
+
+#include "spdlog/spdlog.h"
+
+#include "controller/loadgen/config.hpp"
+#include "controller/loadgen/loadgen.hpp"
+
+static Controller::LoadGen::LoadGen loadGen;
+
+static void sighandler(int signum)
+{
+    UNUSED(signum);
+    loadGen.stop();
+}
+
+int main(int argc, char **argv)
+{
+    Controller::LoadGen::Config config;
+    u8 code = Controller::LoadGen::Config::parse(&config, argc, argv);
+    if (code)
+    {
+        return code == 2 ? 0 : 1;
+    }
+
+    spdlog::set_level(static_cast<spdlog::level::level_enum>(config.logLevel));
+    if (loadGen.init(config))
+    {
+        spdlog::error("{}:{} Fail to initialize", __FILE__, __LINE__);
+        return 1;
+    }
+
+    // stop early, the calls made so far are reported
+    signal(SIGINT,  sighandler);
+    signal(SIGTERM, sighandler);
+    return loadGen.run();
+}
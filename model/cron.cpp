@@ -0,0 +1,245 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <ctime>
+#include <sstream>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "cron.hpp"
+
+namespace Model
+{
+
+// the years to search before giving up, for expressions like "0 0 31 2 *"
+#define CRON_SEARCH_YEARS 5
+
+Cron::Cron() :
+    m_isDayAny(true),
+    m_isWeekdayAny(true)
+{}
+
+u8 Cron::parse(const std::string &in)
+{
+    std::istringstream stream(in);
+    std::vector<std::string> fields;
+    std::string field;
+    while (stream >> field)
+    {
+        fields.push_back(field);
+    }
+
+    if (fields.size() != 5)
+    {
+        spdlog::error("{}:{} Cron expression must have 5 fields: {}", __FILE__, __LINE__,
+                      in);
+        return 1;
+    }
+
+    std::bitset<60> bits;
+    bool isAny(false);
+    if (parseField(fields[0], 0, 59, bits, isAny))
+    {
+        return 1;
+    }
+
+    m_minute = bits;
+    if (parseField(fields[1], 0, 23, bits, isAny))
+    {
+        return 1;
+    }
+
+    m_hour = std::bitset<24>(bits.to_ullong());
+    if (parseField(fields[2], 1, 31, bits, m_isDayAny))
+    {
+        return 1;
+    }
+
+    m_day = std::bitset<32>(bits.to_ullong());
+    if (parseField(fields[3], 1, 12, bits, isAny))
+    {
+        return 1;
+    }
+
+    m_month = std::bitset<13>(bits.to_ullong());
+    if (parseField(fields[4], 0, 7, bits, m_isWeekdayAny))
+    {
+        return 1;
+    }
+
+    if (bits[7])
+    {
+        bits.set(0);
+    }
+
+    m_weekday = std::bitset<8>(bits.to_ullong());
+    return 0;
+}
+
+i64 Cron::next(i64 after) const
+{
+    time_t t = static_cast<time_t>(after);
+    struct tm tm;
+#ifdef _WIN32
+    if (localtime_s(&tm, &t))
+#else
+    if (!localtime_r(&t, &tm))
+#endif
+    {
+        spdlog::error("{}:{} Fail to convert time", __FILE__, __LINE__);
+        return -1;
+    }
+
+    // start from the next whole minute
+    tm.tm_sec = 0;
+    ++tm.tm_min;
+    tm.tm_isdst = -1;
+    i32 lastYear = tm.tm_year + CRON_SEARCH_YEARS;
+    while (1)
+    {
+        t = mktime(&tm);
+        if (t == static_cast<time_t>(-1) || tm.tm_year > lastYear)
+        {
+            return -1;
+        }
+
+        if (!m_month[tm.tm_mon + 1])
+        {
+            tm.tm_mon += 1;
+            tm.tm_mday = 1;
+            tm.tm_hour = 0;
+            tm.tm_min = 0;
+            tm.tm_isdst = -1;
+            continue;
+        }
+
+        bool isDay = m_day[tm.tm_mday];
+        bool isWeekday = m_weekday[tm.tm_wday];
+        bool isMatch;
+        if (m_isDayAny || m_isWeekdayAny)
+        {
+            isMatch = isDay && isWeekday;
+        }
+        else
+        {
+            isMatch = isDay || isWeekday;
+        }
+
+        if (!isMatch)
+        {
+            tm.tm_mday += 1;
+            tm.tm_hour = 0;
+            tm.tm_min = 0;
+            tm.tm_isdst = -1;
+            continue;
+        }
+
+        if (!m_hour[tm.tm_hour])
+        {
+            tm.tm_hour += 1;
+            tm.tm_min = 0;
+            tm.tm_isdst = -1;
+            continue;
+        }
+
+        if (!m_minute[tm.tm_min])
+        {
+            tm.tm_min += 1;
+            tm.tm_isdst = -1;
+            continue;
+        }
+
+        return static_cast<i64>(t);
+    }
+}
+
+// private member functions
+u8 Cron::parseField(const std::string &in, i32 min, i32 max,
+                    std::bitset<60> &out, bool &isAny)
+{
+    out.reset();
+    // like cron, "*/n" is unrestricted as well
+    isAny = (!in.empty() && in[0] == '*');
+
+    size_t begin(0), end(0);
+    std::string token;
+    while (begin <= in.length())
+    {
+        end = in.find(',', begin);
+        if (end == std::string::npos)
+        {
+            end = in.length();
+        }
+
+        token = in.substr(begin, end - begin);
+        begin = end + 1;
+
+        i32 first(min), last(max), step(1);
+        try
+        {
+            size_t slash = token.find('/');
+            if (slash != std::string::npos)
+            {
+                step = std::stoi(token.substr(slash + 1));
+                token = token.substr(0, slash);
+            }
+
+            if (token != "*")
+            {
+                size_t dash = token.find('-');
+                if (dash == std::string::npos)
+                {
+                    first = std::stoi(token);
+                    // "a/n" means from a to the max
+                    last = (slash == std::string::npos) ? first : max;
+                }
+                else
+                {
+                    first = std::stoi(token.substr(0, dash));
+                    last = std::stoi(token.substr(dash + 1));
+                }
+            }
+        }
+        catch (...)
+        {
+            spdlog::error("{}:{} Invalid cron field: {}", __FILE__, __LINE__, in);
+            return 1;
+        }
+
+        if (first < min || last > max || first > last || step < 1)
+        {
+            spdlog::error("{}:{} Invalid cron field: {}", __FILE__, __LINE__, in);
+            return 1;
+        }
+
+        for (i32 i = first; i <= last; i += step)
+        {
+            out.set(static_cast<size_t>(i));
+        }
+    }
+
+    return 0;
+}
+
+} // end namespace Model
@@ -0,0 +1,74 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _MODEL_CRON_HPP_
+#define _MODEL_CRON_HPP_
+
+#include <bitset>
+#include <string>
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+// 5 fields cron expression in local time: "minute hour day month weekday".
+// Every field accepts "*", numbers, ranges "a-b", lists "a,b" and steps "/n".
+// Weekday 0 and 7 are sunday. Like cron, when both day and weekday are
+// restricted a time matches if either of them matches.
+class Cron
+{
+public:
+
+    Cron();
+
+    u8 parse(const std::string &in);
+
+    // the first matching time after "after" (unix time in seconds),
+    // -1 if nothing matches in the next years
+    i64 next(i64 after) const;
+
+private:
+
+    std::bitset<60> m_minute;
+
+    std::bitset<24> m_hour;
+
+    std::bitset<32> m_day;
+
+    std::bitset<13> m_month;
+
+    std::bitset<8> m_weekday;
+
+    bool m_isDayAny;
+
+    bool m_isWeekdayAny;
+
+    static u8 parseField(const std::string &in, i32 min, i32 max,
+                         std::bitset<60> &out, bool &isAny);
+
+}; // end class Cron
+
+} // end namespace Model
+
+#endif // _MODEL_CRON_HPP_
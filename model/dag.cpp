@@ -0,0 +1,360 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+
+#include "dag.hpp"
+
+namespace Model
+{
+
+namespace DAG
+{
+
+typedef std::pair<std::string, i32> Key;
+
+class KeyHash
+{
+public:
+
+    size_t operator()(const Key &in) const
+    {
+        return std::hash<std::string>()(in.first) ^
+               (std::hash<i32>()(in.second) * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+class Queue
+{
+public:
+
+    Handler handler;
+
+    // callbacks running now
+    u32 running = 0;
+
+    bool isRemoved = false;
+};
+
+static std::mutex mutex;
+
+static std::condition_variable cond;
+
+static std::unordered_map<std::string, Queue> queues;
+
+// child to the number of parents it still waits for
+static std::unordered_map<Key, size_t, KeyHash> waiting;
+
+// parent to its children, a child may be listed after it is resolved
+static std::unordered_map<Key, std::vector<Key>, KeyHash> children;
+
+static Key toKey(const Proc::TaskRef &in)
+{
+    return std::make_pair(in.queue, in.ID);
+}
+
+// mutex is held, return true if the child is resolved by this parent
+static bool settle(const Key &child, bool success)
+{
+    auto it = waiting.find(child);
+    if (it == waiting.end())
+    {
+        // failed already or removed
+        return false;
+    }
+
+    if (success && --it->second)
+    {
+        return false;
+    }
+
+    waiting.erase(it);
+    return true;
+}
+
+// mutex is held by "lock", released while the callback is running
+static void resolve(std::unique_lock<std::mutex> &lock, const Key &child, bool success)
+{
+    auto it = queues.find(child.first);
+    if (it == queues.end() || it->second.isRemoved)
+    {
+        return;
+    }
+
+    Queue *queue = &it->second;
+    std::function<void (i32, bool)> cb = queue->handler.resolve;
+    ++queue->running;
+    lock.unlock();
+    cb(child.second, success);
+    lock.lock();
+
+    // removeQueue() waits for us, so the queue is still there
+    --queue->running;
+    cond.notify_all();
+}
+
+// mutex is held, remove one edge from parent to child
+static bool takeEdge(const Key &parent, const Key &child)
+{
+    auto it = children.find(parent);
+    if (it == children.end())
+    {
+        return false;
+    }
+
+    for (auto edge = it->second.begin(); edge != it->second.end(); ++edge)
+    {
+        if (*edge == child)
+        {
+            it->second.erase(edge);
+            if (it->second.empty())
+            {
+                children.erase(it);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static u8 stateImpl(std::unique_lock<std::mutex> &lock, const Key &task)
+{
+    auto it = queues.find(task.first);
+    if (it == queues.end() || it->second.isRemoved)
+    {
+        return TaskState_UNKNOWN;
+    }
+
+    Queue *queue = &it->second;
+    std::function<u8 (i32)> cb = queue->handler.state;
+    ++queue->running;
+    lock.unlock();
+    u8 ret = cb(task.second);
+    lock.lock();
+    --queue->running;
+    cond.notify_all();
+    return ret;
+}
+
+static void finishedImpl(std::unique_lock<std::mutex> &lock, const Key &task, bool success)
+{
+    auto it = children.find(task);
+    if (it == children.end())
+    {
+        return;
+    }
+
+    std::vector<Key> list = std::move(it->second);
+    children.erase(it);
+
+    std::vector<Key> resolved;
+    for (auto child = list.begin(); child != list.end(); ++child)
+    {
+        if (settle(*child, success))
+        {
+            resolved.push_back(*child);
+        }
+    }
+
+    for (auto child = resolved.begin(); child != resolved.end(); ++child)
+    {
+        resolve(lock, *child, success);
+    }
+}
+
+void addQueue(const std::string &name, const Handler &handler)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&]()
+    {
+        auto it = queues.find(name);
+        return it == queues.end() || !it->second.isRemoved;
+    });
+
+    Queue &queue = queues[name];
+    queue.handler = handler;
+
+    // children of other queues may be restored before this one,
+    // look at the parents they wait for
+    std::vector<Key> parents;
+    for (auto it = children.begin(); it != children.end(); ++it)
+    {
+        if (it->first.first == name)
+        {
+            parents.push_back(it->first);
+        }
+    }
+
+    for (auto it = parents.begin(); it != parents.end(); ++it)
+    {
+        // a recurring parent fails the children restored from before
+        // such a dependency was refused
+        u8 state = stateImpl(lock, *it);
+        if (state == TaskState_SUCCEEDED ||
+            state == TaskState_FAILED ||
+            state == TaskState_NOT_FOUND ||
+            state == TaskState_RECURRING)
+        {
+            finishedImpl(lock, *it, state == TaskState_SUCCEEDED);
+        }
+    }
+}
+
+void removeQueue(const std::string &name)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = queues.find(name);
+    if (it == queues.end())
+    {
+        return;
+    }
+
+    it->second.isRemoved = true;
+    cond.wait(lock, [&]()
+    {
+        return !it->second.running;
+    });
+
+    queues.erase(it);
+    for (auto child = waiting.begin(); child != waiting.end();)
+    {
+        if (child->first.first == name)
+        {
+            child = waiting.erase(child);
+        }
+        else
+        {
+            ++child;
+        }
+    }
+
+    cond.notify_all();
+}
+
+u8 renameQueue(const std::string &oldName, const std::string &newName)
+{
+    // a queue which is being removed still takes the name
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = queues.find(oldName);
+    if (it == queues.end() || it->second.isRemoved || queues.contains(newName))
+    {
+        spdlog::error("{}:{} Fail to rename queue {} to {}", __FILE__, __LINE__,
+            oldName, newName);
+        return 1;
+    }
+
+    // the node keeps its address, a running callback still finds it
+    auto node = queues.extract(it);
+    node.key() = newName;
+    queues.insert(std::move(node));
+
+    auto renameKey = [&](const Key &in)
+    {
+        return in.first == oldName ? std::make_pair(newName, in.second) : in;
+    };
+
+    std::unordered_map<Key, size_t, KeyHash> nextWaiting;
+    for (auto child = waiting.begin(); child != waiting.end(); ++child)
+    {
+        nextWaiting[renameKey(child->first)] = child->second;
+    }
+
+    std::unordered_map<Key, std::vector<Key>, KeyHash> nextChildren;
+    for (auto parent = children.begin(); parent != children.end(); ++parent)
+    {
+        std::vector<Key> &edges = nextChildren[renameKey(parent->first)];
+        for (auto child = parent->second.begin(); child != parent->second.end(); ++child)
+        {
+            edges.push_back(renameKey(*child));
+        }
+    }
+
+    waiting.swap(nextWaiting);
+    children.swap(nextChildren);
+    return 0;
+}
+
+u8 state(const Proc::TaskRef &task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return stateImpl(lock, toKey(task));
+}
+
+void add(const Proc::TaskRef &child, const std::vector<Proc::TaskRef> &parents)
+{
+    Key key = toKey(child);
+    std::unique_lock<std::mutex> lock(mutex);
+    if (parents.empty())
+    {
+        resolve(lock, key, true);
+        return;
+    }
+
+    // the edges first, so a parent finishing meanwhile is not missed
+    waiting[key] = parents.size();
+    for (auto it = parents.begin(); it != parents.end(); ++it)
+    {
+        children[toKey(*it)].push_back(key);
+    }
+
+    for (auto it = parents.begin(); it != parents.end(); ++it)
+    {
+        Key parent = toKey(*it);
+        u8 state = stateImpl(lock, parent);
+        if (state == TaskState_WAITING || state == TaskState_UNKNOWN)
+        {
+            continue;
+        }
+
+        // the parent may have reported itself in the meantime,
+        // a recurring one counts as failed
+        bool success = (state == TaskState_SUCCEEDED);
+        if (takeEdge(parent, key) && settle(key, success))
+        {
+            resolve(lock, key, success);
+        }
+    }
+}
+
+void remove(const Proc::TaskRef &child)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    waiting.erase(toKey(child));
+}
+
+void finished(const Proc::TaskRef &task, bool success)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    finishedImpl(lock, toKey(task), success);
+}
+
+} // end namespace DAG
+
+} // end namespace Model
@@ -0,0 +1,94 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _MODEL_DAG_HPP_
+#define _MODEL_DAG_HPP_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "controller/global/defines.hpp"
+#include "model/proc/task.hpp"
+
+// state of a task as seen by the graph
+#define TaskState_NOT_FOUND 0
+#define TaskState_WAITING   1
+#define TaskState_SUCCEEDED 2
+#define TaskState_FAILED    3
+// the queue is not added (yet)
+#define TaskState_UNKNOWN   4
+// a recurring task, it never finishes
+#define TaskState_RECURRING 5
+
+namespace Model
+{
+
+// Server wide dependency graph of the tasks, also across queues.
+// A task waiting for its parents is kept by its queue (table "blocked"),
+// the graph only counts the parents every such task still waits for and
+// keeps the edges from a parent to its children, so a finished task
+// touches its own children only.
+//
+// The callbacks run with no lock of the graph held, the callers must not
+// hold a lock the callbacks of any queue take.
+namespace DAG
+{
+
+class Handler
+{
+public:
+
+    // one of TaskState_*
+    std::function<u8 (i32)> state;
+
+    // called once for a waiting task: all of its parents have succeeded,
+    // or one of them has failed
+    std::function<void (i32, bool)> resolve;
+};
+
+void addQueue(const std::string &name, const Handler &handler);
+
+// after return no callback of the queue is running or will be called
+void removeQueue(const std::string &name);
+
+// the queue and the edges of its tasks are known by "newName" from now on,
+// return 1 if there is no such queue or "newName" is taken
+u8 renameQueue(const std::string &oldName, const std::string &newName);
+
+u8 state(const Proc::TaskRef &task);
+
+// the parents which have finished already are resolved before return,
+// so "resolve" of the child may be called from here
+void add(const Proc::TaskRef &child, const std::vector<Proc::TaskRef> &parents);
+
+void remove(const Proc::TaskRef &child);
+
+// the task has gone to "done" or is removed (success is false)
+void finished(const Proc::TaskRef &task, bool success);
+
+} // end namespace DAG
+
+} // end namespace Model
+
+#endif // _MODEL_DAG_HPP_
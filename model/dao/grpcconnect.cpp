@@ -66,15 +66,25 @@ u8 GRPCConnect::startConnect(const std::string &target,
         return ErrCode_OS_ERROR;
     }
 
+    // "unix:<path>" connects to the unix domain socket of a local server,
+    // the port is not used then
     std::string ip = target;
-    ip += ":";
-    ip += std::to_string(port);
+    if (ip.rfind("unix:", 0) != 0)
+    {
+        ip += ":";
+        ip += std::to_string(port);
+    }
     std::unique_ptr<ff::Access::Stub> stub;
 
     try
     {
-        token->channel = grpc::CreateChannel(ip,
-                                             grpc::InsecureChannelCredentials());
+        // every connection gets its own subchannel, otherwise channels to
+        // the same target share one TCP connection
+        grpc::ChannelArguments args;
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        token->channel = grpc::CreateCustomChannel(ip,
+                                                   grpc::InsecureChannelCredentials(),
+                                                   args);
 
         if (token->channel == nullptr)
         {
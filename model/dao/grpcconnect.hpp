@@ -56,6 +56,7 @@ public:
 
     u8 init() override;
 
+    // target is an ip or "unix:<path>" for a local server
     u8 startConnect(const std::string &target,
                     const i32 port = 0) override;
 
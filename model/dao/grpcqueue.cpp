@@ -188,6 +188,106 @@ u8 GRPCQueue::finishedDetails(const int id,
     return ErrCode_OS_ERROR;
 }
 
+u8 GRPCQueue::listScheduled(std::vector<int> &out)
+{
+    out.clear();
+    out.reserve(128);
+
+    ff::QueueReq req;
+    req.set_name(m_queueName);
+
+    grpc::ClientContext ctx;
+    ff::ListTaskRes res;
+
+    GRPCUtils::setupCtx(ctx);
+    auto reader = m_stub->ListScheduled(&ctx, req);
+    if (reader == nullptr)
+    {
+        spdlog::error("{}:{} reader is nullptr", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
+
+    while(reader->Read(&res))
+    {
+        out.push_back(res.id());
+    }
+
+    UNUSED(reader->Finish());
+    return ErrCode_OK;
+}
+
+u8 GRPCQueue::scheduledDetails(const int id,
+                               Proc::Task &out)
+{
+    ff::TaskDetailsReq req;
+    req.set_name(m_queueName);
+    req.set_id(id);
+
+    grpc::ClientContext ctx;
+    ff::TaskDetailsRes res;
+
+    GRPCUtils::setupCtx(ctx);
+    grpc::Status status = m_stub->ScheduledDetails(&ctx, req, &res);
+    if (status.ok())
+    {
+        buildTask(res, out);
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
+u8 GRPCQueue::listBlocked(std::vector<int> &out)
+{
+    out.clear();
+    out.reserve(128);
+
+    ff::QueueReq req;
+    req.set_name(m_queueName);
+
+    grpc::ClientContext ctx;
+    ff::ListTaskRes res;
+
+    GRPCUtils::setupCtx(ctx);
+    auto reader = m_stub->ListBlocked(&ctx, req);
+    if (reader == nullptr)
+    {
+        spdlog::error("{}:{} reader is nullptr", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
+
+    while(reader->Read(&res))
+    {
+        out.push_back(res.id());
+    }
+
+    UNUSED(reader->Finish());
+    return ErrCode_OK;
+}
+
+u8 GRPCQueue::blockedDetails(const int id,
+                             Proc::Task &out)
+{
+    ff::TaskDetailsReq req;
+    req.set_name(m_queueName);
+    req.set_id(id);
+
+    grpc::ClientContext ctx;
+    ff::TaskDetailsRes res;
+
+    GRPCUtils::setupCtx(ctx);
+    grpc::Status status = m_stub->BlockedDetails(&ctx, req, &res);
+    if (status.ok())
+    {
+        buildTask(res, out);
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
 u8 GRPCQueue::clearPending()
 {
     ff::QueueReq req;
@@ -226,6 +326,197 @@ u8 GRPCQueue::clearFinished()
     return ErrCode_OS_ERROR;
 }
 
+u8 GRPCQueue::taskHistory(const int id, std::vector<Proc::Attempt> &out)
+{
+    out.clear();
+
+    ff::TaskDetailsReq req;
+    req.set_name(m_queueName);
+    req.set_id(id);
+
+    grpc::ClientContext ctx;
+    ff::AttemptRes res;
+    Proc::Attempt attempt;
+
+    GRPCUtils::setupCtx(ctx);
+    auto reader = m_stub->TaskHistory(&ctx, req);
+    if (reader == nullptr)
+    {
+        spdlog::error("{}:{} reader is nullptr", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
+
+    while(reader->Read(&res))
+    {
+        attempt.attempt = res.attempt();
+        attempt.exitCode = res.exitcode();
+        attempt.endTime = res.endtime();
+        out.push_back(attempt);
+    }
+
+    grpc::Status status = reader->Finish();
+    if (status.ok())
+    {
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
+u8 GRPCQueue::historyStats(const HistoryFilter &in, HistoryStats &out)
+{
+    ff::HistoryStatsReq req;
+    req.set_name(m_queueName);
+    req.set_from(in.from);
+    req.set_to(in.to);
+    req.set_execname(in.execName);
+
+    grpc::ClientContext ctx;
+    ff::HistoryStatsRes res;
+
+    GRPCUtils::setupCtx(ctx);
+    grpc::Status status = m_stub->HistoryStats(&ctx, req, &res);
+    if (status.ok())
+    {
+        out.count = res.count();
+        out.succeeded = res.succeeded();
+        out.successRate = res.successrate();
+        out.p50 = res.p50();
+        out.p95 = res.p95();
+        out.p99 = res.p99();
+        out.cpuTime = res.cputime();
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
+u8 GRPCQueue::finishedOutput(const int id, std::string &out)
+{
+    out.clear();
+
+    ff::TaskDetailsReq req;
+    req.set_name(m_queueName);
+    req.set_id(id);
+
+    grpc::ClientContext ctx;
+    ff::Msg res;
+
+    GRPCUtils::setupCtx(ctx);
+    grpc::Status status = m_stub->FinishedOutput(&ctx, req, &res);
+    if (status.ok())
+    {
+        out = res.msg();
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
+u8 GRPCQueue::waitTasks(const std::vector<int> &ids,
+                        const bool any,
+                        const i64 deadline,
+                        const std::function<bool ()> &keepWaiting,
+                        std::vector<Proc::Task> &out)
+{
+    // the server stops waiting when this call is cancelled
+    UNUSED(keepWaiting);
+    out.clear();
+
+    ff::WaitTasksReq req;
+    req.set_name(m_queueName);
+    for (auto it = ids.begin(); it != ids.end(); ++it)
+    {
+        req.add_ids(*it);
+    }
+
+    req.set_any(any);
+    req.set_deadline(deadline);
+
+    grpc::ClientContext ctx;
+    ff::TaskDetailsRes res;
+    Proc::Task task;
+
+    if (deadline)
+    {
+        ctx.set_deadline(std::chrono::system_clock::time_point(
+                         std::chrono::seconds(deadline)) +
+                         std::chrono::milliseconds(FF_CLIENT_TIMEOUT * 1000));
+    }
+
+    auto reader = m_stub->WaitTasks(&ctx, req);
+    if (reader == nullptr)
+    {
+        spdlog::error("{}:{} reader is nullptr", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
+
+    while(reader->Read(&res))
+    {
+        buildTask(res, task);
+        out.push_back(task);
+    }
+
+    grpc::Status status = reader->Finish();
+    if (status.ok())
+    {
+        return ErrCode_OK;
+    }
+
+    if (status.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED)
+    {
+        return ErrCode_DEADLINE_EXCEEDED;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
+u8 GRPCQueue::watch(const std::function<bool ()> &keepWaiting,
+                    const std::function<bool (const Event &)> &onEvent)
+{
+    ff::QueueReq req;
+    req.set_name(m_queueName);
+
+    // no deadline, the stream is closed by the callbacks
+    grpc::ClientContext ctx;
+    ff::QueueEvent res;
+    Event event;
+
+    auto reader = m_stub->WatchQueue(&ctx, req);
+    if (reader == nullptr)
+    {
+        spdlog::error("{}:{} reader is nullptr", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
+
+    while(reader->Read(&res))
+    {
+        event.type = static_cast<u8>(res.type());
+        event.ID = res.id();
+        event.exitCode = res.exitcode();
+        event.isSuccess = res.issuccess();
+        event.time = res.time();
+        if (!keepWaiting() || !onEvent(event))
+        {
+            ctx.TryCancel();
+            break;
+        }
+    }
+
+    grpc::Status status = reader->Finish();
+    if (status.ok() || status.error_code() == grpc::StatusCode::CANCELLED)
+    {
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
 u8 GRPCQueue::currentTask(Proc::Task &out)
 {
     ff::QueueReq req;
@@ -259,6 +550,28 @@ u8 GRPCQueue::addTask(Proc::Task &in)
         req.add_args(*it);
     }
 
+    req.set_priority(in.priority);
+    req.set_notbefore(in.notBefore);
+    req.set_cron(in.cron);
+    req.set_maxretries(in.maxRetries);
+    req.set_backoff(in.backoff);
+    req.set_backoffmax(in.backoffMax);
+    req.set_timeout(in.timeout);
+    req.set_idleoutputtimeout(in.idleOutputTimeout);
+    req.set_idempotencykey(in.idempotencyKey);
+    for (auto it = in.dependsOn.begin(); it != in.dependsOn.end(); ++it)
+    {
+        ff::TaskDetailsReq *ref = req.add_dependson();
+        ref->set_name(it->queue);
+        ref->set_id(it->ID);
+    }
+    for (auto it = in.inputs.begin();
+         it != in.inputs.end();
+         ++it)
+    {
+        req.add_inputs(*it);
+    }
+
     grpc::ClientContext ctx;
     ff::ListTaskRes res;
 
@@ -296,6 +609,27 @@ u8 GRPCQueue::removeTask(const i32 in)
     return ErrCode_OK;
 }
 
+u8 GRPCQueue::setPriority(const i32 id, const i32 priority)
+{
+    ff::SetPriorityReq req;
+    req.set_name(m_queueName);
+    req.set_id(id);
+    req.set_priority(priority);
+
+    grpc::ClientContext ctx;
+    ff::Empty res;
+
+    GRPCUtils::setupCtx(ctx);
+    grpc::Status status = m_stub->SetPriority(&ctx, req, &res);
+    if (!status.ok())
+    {
+        GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+        return ErrCode_OS_ERROR;
+    }
+
+    return ErrCode_OK;
+}
+
 bool GRPCQueue::isRunning() const
 {
     ff::QueueReq req;
@@ -393,6 +727,41 @@ void GRPCQueue::buildTask(ff::TaskDetailsRes &res, Proc::Task &task)
 
     task.exitCode = res.exitcode();
     task.ID = res.id();
+    task.priority = res.priority();
+    task.notBefore = res.notbefore();
+    task.cron = res.cron();
+    task.isSuccess = res.issuccess();
+    task.maxRetries = res.maxretries();
+    task.backoff = res.backoff();
+    task.backoffMax = res.backoffmax();
+    task.attempt = res.attempt();
+    task.timeout = res.timeout();
+    task.idleOutputTimeout = res.idleoutputtimeout();
+    task.timedOut = res.timedout();
+    task.inputs.clear();
+    task.inputs.reserve(res.inputs_size());
+    for (auto it = res.inputs().begin(); it != res.inputs().end(); ++it)
+    {
+        task.inputs.push_back(*it);
+    }
+
+    task.cached = res.cached();
+    task.dependsOn.clear();
+    task.dependsOn.reserve(res.dependson_size());
+    Proc::TaskRef ref;
+    for (auto it = res.dependson().begin(); it != res.dependson().end(); ++it)
+    {
+        ref.queue = it->name();
+        ref.ID = it->id();
+        task.dependsOn.push_back(ref);
+    }
+
+    task.enqueueTime = res.enqueuetime();
+    task.startTime = res.starttime();
+    task.endTime = res.endtime();
+    task.waitTime = res.waittime();
+    task.runTime = res.runtime();
+    task.cpuTime = res.cputime();
 }
 
 } // end namespace DAO
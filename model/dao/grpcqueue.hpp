@@ -58,16 +58,44 @@ public:
     u8 finishedDetails(const int id,
                        Proc::Task &out) override;
 
+    u8 listScheduled(std::vector<int> &out) override;
+
+    u8 listBlocked(std::vector<int> &out) override;
+
+    u8 blockedDetails(const int id,
+                      Proc::Task &out) override;
+
+    u8 scheduledDetails(const int id,
+                        Proc::Task &out) override;
+
     u8 clearPending() override;
 
     u8 clearFinished() override;
 
+    u8 taskHistory(const int id,
+                   std::vector<Proc::Attempt> &out) override;
+
+    u8 historyStats(const HistoryFilter &in, HistoryStats &out) override;
+
+    u8 finishedOutput(const int id, std::string &out) override;
+
+    u8 waitTasks(const std::vector<int> &ids,
+                 const bool any,
+                 const i64 deadline,
+                 const std::function<bool ()> &keepWaiting,
+                 std::vector<Proc::Task> &out) override;
+
+    u8 watch(const std::function<bool ()> &keepWaiting,
+             const std::function<bool (const Event &)> &onEvent) override;
+
     u8 currentTask(Proc::Task &out) override;
 
     u8 addTask(Proc::Task &in) override;
 
     u8 removeTask(const i32 in) override;
 
+    u8 setPriority(const i32 id, const i32 priority) override;
+
     bool isRunning() const override;
 
     void readCurrentOutput(std::vector<std::string> &out) override;
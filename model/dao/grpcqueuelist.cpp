@@ -168,10 +168,10 @@ u8 GRPCQueueList::renameQueue(const std::string &oldName,
     return ErrCode_OS_ERROR;
 }
 
-std::shared_ptr<IQueue> GRPCQueueList::getQueue(const std::string &name)
+std::shared_ptr<IQueue> GRPCQueueList::getQueue(std::string_view name)
 {
     ff::QueueReq req;
-    req.set_name(name);
+    req.set_name(std::string(name));
 
     ff::Empty res;
     grpc::ClientContext ctx;
@@ -188,7 +188,7 @@ std::shared_ptr<IQueue> GRPCQueueList::getQueue(const std::string &name)
         }
 
         std::shared_ptr<Proc::IProc> proc = std::shared_ptr<Proc::IProc>(nullptr);
-        if (queue->init(m_conn, proc, name))
+        if (queue->init(m_conn, proc, req.name()))
         {
             spdlog::error("{}:{} Fail to initialize queue", __FILE__, __LINE__);
             delete queue;
@@ -202,6 +202,95 @@ std::shared_ptr<IQueue> GRPCQueueList::getQueue(const std::string &name)
     return nullptr;
 }
 
+u8 GRPCQueueList::queueShare(const std::string &name, Scheduler::Share &out)
+{
+    ff::QueueReq req;
+    req.set_name(name);
+
+    ff::QueueShareRes res;
+    grpc::ClientContext ctx;
+
+    GRPCUtils::setupCtx(ctx);
+    grpc::Status status = m_stub->Share(&ctx, req, &res);
+    if (status.ok())
+    {
+        out.weight = res.weight();
+        out.priority = res.priority();
+        out.consumed = res.consumed();
+        out.tasks = res.tasks();
+        out.running = res.running();
+        out.waiting = res.waiting();
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
+static void readStats(const ff::QueueStatsRes &in, QueueStats &out)
+{
+    out.name = in.name();
+    out.pending = in.pending();
+    out.finished = in.finished();
+    out.failed = in.failed();
+    out.running = in.running();
+    out.oldestPendingAge = in.oldestpendingage();
+    out.averageDuration = in.averageduration();
+}
+
+u8 GRPCQueueList::queueStats(const std::string &name, QueueStats &out)
+{
+    ff::QueueReq req;
+    req.set_name(name);
+
+    ff::QueueStatsRes res;
+    grpc::ClientContext ctx;
+
+    GRPCUtils::setupCtx(ctx);
+    grpc::Status status = m_stub->QueueStats(&ctx, req, &res);
+    if (status.ok())
+    {
+        readStats(res, out);
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
+u8 GRPCQueueList::allQueueStats(std::vector<QueueStats> &out)
+{
+    out.clear();
+
+    ff::Empty req;
+    ff::QueueStatsRes res;
+    grpc::ClientContext ctx;
+
+    GRPCUtils::setupCtx(ctx);
+    auto reader = m_stub->AllQueueStats(&ctx, req);
+    if (reader == nullptr)
+    {
+        spdlog::error("{}:{} reader is nullptr", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
+
+    QueueStats stats;
+    while (reader->Read(&res))
+    {
+        readStats(res, stats);
+        out.push_back(stats);
+    }
+
+    grpc::Status status = reader->Finish();
+    if (status.ok())
+    {
+        return ErrCode_OK;
+    }
+
+    GRPCUtils::buildErrMsg(__FILE__, __LINE__, status);
+    return ErrCode_OS_ERROR;
+}
+
 } // end namespace DAO
 
 } // end namespace Model
@@ -54,7 +54,13 @@ public:
     u8 renameQueue(const std::string &oldName,
                    const std::string &newName) override;
 
-    std::shared_ptr<IQueue> getQueue(const std::string &name) override;
+    std::shared_ptr<IQueue> getQueue(std::string_view name) override;
+
+    u8 queueShare(const std::string &name, Scheduler::Share &out) override;
+
+    u8 queueStats(const std::string &name, QueueStats &out) override;
+
+    u8 allQueueStats(std::vector<QueueStats> &out) override;
 
 private:
 
@@ -24,9 +24,12 @@
 #ifndef _MODEL_DAO_IQUEUE_HPP_
 #define _MODEL_DAO_IQUEUE_HPP_
 
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "model/eventbus.hpp"
 #include "model/proc/iproc.hpp"
 #include "model/proc/task.hpp"
 #include "iconnect.hpp"
@@ -37,6 +40,67 @@ namespace Model
 namespace DAO
 {
 
+class QueueStats
+{
+public:
+
+    std::string name;
+
+    u64 pending = 0;
+
+    u64 finished = 0;
+
+    // of finished
+    u64 failed = 0;
+
+    u32 running = 0;
+
+    // milliseconds since the oldest pending task was enqueued,
+    // 0 if nothing is pending
+    u64 oldestPendingAge = 0;
+
+    // run time per finished task, in milliseconds, tasks finished
+    // before run times were recorded are not counted
+    u64 averageDuration = 0;
+};
+
+// finished tasks to aggregate, see IQueue::historyStats()
+class HistoryFilter
+{
+public:
+
+    // unix time in milliseconds, the tasks which have ended in [from, to),
+    // widened to whole minutes, "to" is now if it is 0
+    i64 from = 0;
+
+    i64 to = 0;
+
+    // empty for all
+    std::string execName;
+};
+
+class HistoryStats
+{
+public:
+
+    u64 count = 0;
+
+    u64 succeeded = 0;
+
+    // succeeded / count, 0 if there is none
+    double successRate = 0;
+
+    // run time in milliseconds, within 12.5% (see Metrics::Histogram)
+    u64 p50 = 0;
+
+    u64 p95 = 0;
+
+    u64 p99 = 0;
+
+    // milliseconds of user + system cpu time
+    u64 cpuTime = 0;
+};
+
 class IQueue
 {
 public:
@@ -57,16 +121,59 @@ public:
     virtual u8 finishedDetails(const int id,
                                Proc::Task &out) = 0;
 
+    // delayed and recurring tasks, moved to pending when they are due
+    virtual u8 listScheduled(std::vector<int> &out) = 0;
+
+    virtual u8 scheduledDetails(const int id,
+                                Proc::Task &out) = 0;
+
+    // tasks waiting for the tasks they depend on
+    virtual u8 listBlocked(std::vector<int> &out) = 0;
+
+    virtual u8 blockedDetails(const int id,
+                              Proc::Task &out) = 0;
+
     virtual u8 clearPending() = 0;
 
     virtual u8 clearFinished() = 0;
 
+    // every run of the task, the retries included
+    virtual u8 taskHistory(const int id,
+                           std::vector<Proc::Attempt> &out) = 0;
+
+    // aggregates of the tasks in "done", from a rollup per minute and
+    // execName, so the cost depends on the window and not on the tasks
+    virtual u8 historyStats(const HistoryFilter &in, HistoryStats &out) = 0;
+
+    // output log of a finished task, kept by the queues with result cache
+    virtual u8 finishedOutput(const int id, std::string &out) = 0;
+
+    // block until all (or any) of the tasks are finished or removed and
+    // return the details of the finished ones, ErrCode_DEADLINE_EXCEEDED
+    // if deadline (unix time in seconds, 0 for none) comes first or
+    // keepWaiting becomes false
+    virtual u8 waitTasks(const std::vector<int> &ids,
+                         const bool any,
+                         const i64 deadline,
+                         const std::function<bool ()> &keepWaiting,
+                         std::vector<Proc::Task> &out) = 0;
+
+    // pass every event of this queue to onEvent until keepWaiting or
+    // onEvent returns false
+    virtual u8 watch(const std::function<bool ()> &keepWaiting,
+                     const std::function<bool (const Event &)> &onEvent) = 0;
+
     virtual u8 currentTask(Proc::Task &out) = 0;
 
     virtual u8 addTask(Proc::Task &in) = 0;
 
+    // remove a pending or a scheduled task
     virtual u8 removeTask(const i32 in) = 0;
 
+    // pending task with higher priority runs first, the same priority runs
+    // in order of enqueue
+    virtual u8 setPriority(const i32 id, const i32 priority) = 0;
+
     virtual bool isRunning() const = 0;
 
     virtual void readCurrentOutput(std::vector<std::string> &out) = 0;
@@ -25,8 +25,10 @@
 #define _MODEL_DAO_IQUEUELIST_HPP_
 
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "model/scheduler.hpp"
 #include "iconnect.hpp"
 #include "iqueue.hpp"
 
@@ -53,7 +55,15 @@ public:
     virtual u8 renameQueue(const std::string &oldName,
                            const std::string &newName) = 0;
 
-    virtual std::shared_ptr<IQueue> getQueue(const std::string &name) = 0;
+    virtual std::shared_ptr<IQueue> getQueue(std::string_view name) = 0;
+
+    // scheduler share and consumed time of the queue
+    virtual u8 queueShare(const std::string &name, Scheduler::Share &out) = 0;
+
+    // from counters kept in memory, without listing the tasks
+    virtual u8 queueStats(const std::string &name, QueueStats &out) = 0;
+
+    virtual u8 allQueueStats(std::vector<QueueStats> &out) = 0;
 
 protected:
 
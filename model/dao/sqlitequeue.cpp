@@ -21,15 +21,21 @@
  * SOFTWARE.
  */
 
-#ifdef _WIN32
-#define sleep(x) Sleep(x * 1000)
-#else
-#include "unistd.h"
-#endif
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <random>
 
 #include "spdlog/spdlog.h"
 
+#include "model/cron.hpp"
+#include "model/dag.hpp"
 #include "model/errmsg.hpp"
+#include "model/executor.hpp"
+#include "model/metrics.hpp"
+#include "model/scheduler.hpp"
+#include "model/timer.hpp"
 #include "sqlitequeue.hpp"
 
 #define UNUSED(x) static_cast<void>(x)
@@ -40,19 +46,241 @@ namespace Model
 namespace DAO
 {
 
-static std::unordered_map<std::string, std::string> dbColumnName;
+class DBColumn
+{
+public:
+
+    const char *name;
+
+    const char *type;
+
+    const char *constraint;
+
+    // columns added after the first release, they are appended to the tables
+    // of an old database with their default value
+    bool isAddable;
+};
+
+// column order of table "pending", "done", "scheduled" and "blocked"
+static const DBColumn dbColumns[] =
+{
+    {"execName", "TEXT", "NOT NULL", false},
+    {"args", "TEXT", "NOT NULL", false},
+    {"workDir", "TEXT", "NOT NULL", false},
+    {"ID", "INT", "NOT NULL PRIMARY KEY", false},
+    {"exitCode", "INT", "NOT NULL", false},
+    {"isSuccess", "INT", "NOT NULL", false},
+    {"priority", "INT", "NOT NULL DEFAULT 0", true},
+    {"notBefore", "INTEGER", "NOT NULL DEFAULT 0", true},
+    {"cron", "TEXT", "NOT NULL DEFAULT ''", true},
+    {"maxRetries", "INT", "NOT NULL DEFAULT 0", true},
+    {"backoff", "INT", "NOT NULL DEFAULT 0", true},
+    {"backoffMax", "INT", "NOT NULL DEFAULT 0", true},
+    {"attempt", "INT", "NOT NULL DEFAULT 0", true},
+    {"timeout", "INT", "NOT NULL DEFAULT 0", true},
+    {"idleOutputTimeout", "INT", "NOT NULL DEFAULT 0", true},
+    {"timedOut", "INT", "NOT NULL DEFAULT 0", true},
+    {"inputs", "TEXT", "NOT NULL DEFAULT ''", true},
+    {"cached", "INT", "NOT NULL DEFAULT 0", true},
+    {"dependsOn", "TEXT", "NOT NULL DEFAULT ''", true},
+    {"enqueueTime", "INTEGER", "NOT NULL DEFAULT 0", true},
+    {"startTime", "INTEGER", "NOT NULL DEFAULT 0", true},
+    {"endTime", "INTEGER", "NOT NULL DEFAULT 0", true},
+    {"waitTime", "INTEGER", "NOT NULL DEFAULT 0", true},
+    {"runTime", "INTEGER", "NOT NULL DEFAULT 0", true},
+    {"cpuTime", "INTEGER", "NOT NULL DEFAULT 0", true},
+};
+
+static const size_t dbColumnCount = sizeof(dbColumns) / sizeof(DBColumn);
+
+// key of the result cache, a hash of everything the result of a
+// deterministic task depends on; "material" is that everything itself,
+// the hash may collide, so a hit is compared against it
+static u8 resultKey(const Proc::Task &task, std::string &out, std::string &material)
+{
+    material.clear();
+    auto feed = [&material](const std::string &in)
+    {
+        // length prefixed, "ab" + "c" is not "a" + "bc"
+        material += std::to_string(in.size());
+        material += ':';
+        material += in;
+    };
+
+    feed(task.execName);
+    feed(std::to_string(task.args.size()));
+    for (auto it = task.args.begin(); it != task.args.end(); ++it)
+    {
+        feed(*it);
+    }
+
+    feed(task.workDir);
+    for (auto it = task.inputs.begin(); it != task.inputs.end(); ++it)
+    {
+        std::filesystem::path path(*it);
+        if (path.is_relative())
+        {
+            path = std::filesystem::path(task.workDir) / path;
+        }
+
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec)
+        {
+            spdlog::warn("{}:{} Fail to check input {}: {}", __FILE__, __LINE__,
+                *it, ec.message());
+            return 1;
+        }
+
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec)
+        {
+            spdlog::warn("{}:{} Fail to check input {}: {}", __FILE__, __LINE__,
+                *it, ec.message());
+            return 1;
+        }
+
+        feed(*it);
+        feed(std::to_string(size));
+        feed(std::to_string(mtime.time_since_epoch().count()));
+    }
+
+    // FNV-1a, 64 bits
+    u64 hash(14695981039346656037ULL);
+    for (auto it = material.begin(); it != material.end(); ++it)
+    {
+        hash ^= static_cast<unsigned char>(*it);
+        hash *= 1099511628211ULL;
+    }
+
+    out = fmt::format("{:016x}", hash);
+    return 0;
+}
+
+static const std::string &dbColumnList()
+{
+    static const std::string out = []()
+    {
+        std::string ret;
+        for (size_t i = 0; i < dbColumnCount; ++i)
+        {
+            if (i)
+            {
+                ret += ", ";
+            }
+
+            ret += dbColumns[i].name;
+        }
+
+        return ret;
+    }();
+
+    return out;
+}
+
+void HistoryRollup::add(const Proc::Task &in)
+{
+    ++count;
+    if (in.isSuccess)
+    {
+        ++succeeded;
+    }
+
+    cpuTime += static_cast<u64>(std::max<i64>(in.cpuTime, 0));
+    u64 value = static_cast<u64>(std::max<i64>(in.runTime, 0));
+    maxRunTime = std::max(maxRunTime, value);
+    ++runTime[Metrics::Histogram::bucketIndex(value)];
+}
+
+std::string HistoryRollup::encode() const
+{
+    std::string out;
+    for (auto it = runTime.begin(); it != runTime.end(); ++it)
+    {
+        if (!out.empty())
+        {
+            out += ",";
+        }
+
+        out += std::to_string(it->first) + ":" + std::to_string(it->second);
+    }
+
+    return out;
+}
+
+void HistoryRollup::decode(const std::string &in)
+{
+    runTime.clear();
+
+    size_t begin(0), end(0);
+    while (begin < in.length())
+    {
+        end = in.find(',', begin);
+        if (end == std::string::npos)
+        {
+            end = in.length();
+        }
 
-static std::mutex dbColumnNameMutex;
+        // written by encode() only
+        size_t colon = in.find(':', begin);
+        if (colon < end)
+        {
+            size_t bucket = std::stoull(in.substr(begin, colon - begin));
+            if (bucket < Metrics::Histogram::bucketCount)
+            {
+                runTime[bucket] += std::stoull(in.substr(colon + 1, end - colon - 1));
+            }
+        }
 
-static bool isDBColumnNameInit = false;
+        begin = end + 1;
+    }
+}
 
 SQLiteQueue::SQLiteQueue() :
-    m_token(nullptr)
+    m_token(nullptr),
+    m_looping(false),
+    m_isClosing(false),
+    m_retryTokens(FF_RETRY_BUDGET_MAX),
+    m_dedupCache(FF_DEDUP_CACHE_SIZE),
+    m_watchdogArmed(false),
+    m_timedOut(false),
+    m_timeoutTimer(0),
+    m_idleTimer(0),
+    m_killTimer(0),
+    m_lastWait(0),
+    m_pendingCount(0),
+    m_finishedCount(0),
+    m_failedCount(0),
+    m_oldestPending(0),
+    m_timedCount(0),
+    m_runTimeTotal(0)
 {}
 
 SQLiteQueue::~SQLiteQueue()
 {
+    // the callbacks removeQueue() waits for take m_nameMutex
+    std::string name = taskRef(0).queue;
+    if (!name.empty())
+    {
+        DAG::removeQueue(name);
+    }
+
+    {
+        // wait for the running promote(), the later ones return at once
+        std::unique_lock<std::mutex> lock(m_promoteMutex);
+        m_isClosing = true;
+    }
+
+    cancelTimers();
     stopImpl();
+
+    // the loop may still be finishing its last task
+    {
+        std::unique_lock<std::mutex> lock(m_loopMutex);
+        m_loopCond.wait(lock, [this]() { return !m_looping; });
+    }
+
+    Scheduler::removeQueue(this);
 }
 
 u8
@@ -84,20 +312,6 @@ SQLiteQueue::init(std::shared_ptr<IConnect> &connect,
         return ErrCode_OS_ERROR;
     }
 
-    {
-        std::unique_lock<std::mutex> lock(dbColumnNameMutex);
-        if (!isDBColumnNameInit)
-        {
-            dbColumnName["execName"] = "TEXT";
-            dbColumnName["args"] = "TEXT";
-            dbColumnName["workDir"] = "TEXT";
-            dbColumnName["ID"] = "INT";
-            dbColumnName["exitCode"] = "INT";
-            dbColumnName["isSuccess"] = "INT";
-            isDBColumnNameInit = true;
-        }
-    }
-
     if (connectToDB(connect->targetPath() + "/" + name + ".db"))
     {
         spdlog::error("{}:{} Fail to connect to SQLite.", __FILE__, __LINE__);
@@ -106,8 +320,41 @@ SQLiteQueue::init(std::shared_ptr<IConnect> &connect,
     }
 
     m_process = process;
+    m_name = name;
     m_isRunning.store(false, std::memory_order_relaxed);
     m_start.store(false, std::memory_order_relaxed);
+    m_isStopped.store(false, std::memory_order_relaxed);
+    m_useResultCache.store(false, std::memory_order_relaxed);
+    Scheduler::addQueue(this);
+
+    if (loadScheduled())
+    {
+        spdlog::error("{}:{} Fail to load scheduled tasks.", __FILE__, __LINE__);
+        {
+            std::unique_lock<std::mutex> lock(m_promoteMutex);
+            m_isClosing = true;
+        }
+
+        cancelTimers();
+        Scheduler::removeQueue(this);
+        m_token = nullptr;
+        m_name.clear();
+        return ErrCode_OS_ERROR;
+    }
+
+    DAG::Handler handler;
+    handler.state = [this](i32 id)
+    {
+        return taskState(id);
+    };
+
+    handler.resolve = [this](i32 id, bool isReady)
+    {
+        unblock(id, isReady);
+    };
+
+    DAG::addQueue(m_name, handler);
+    loadBlocked();
     return ErrCode_OK;
 }
 
@@ -139,167 +386,1686 @@ SQLiteQueue::finishedDetails(const int id,
     return taskDetails("done", id, out);
 }
 
-u8 SQLiteQueue::clearPending()
+u8 SQLiteQueue::listScheduled(std::vector<int> &out)
 {
     std::unique_lock<std::mutex> lock(m_token->mutex);
-    std::unique_lock<std::mutex> lock2(m_currentTaskMutex);
-    return clearTable("pending");
+    return listIDInTable("scheduled", out);
 }
 
-u8 SQLiteQueue::clearFinished()
+u8
+SQLiteQueue::scheduledDetails(const int id,
+                              Proc::Task &out)
 {
     std::unique_lock<std::mutex> lock(m_token->mutex);
-    return clearTable("done");
+    return taskDetails("scheduled", id, out);
 }
 
-u8 SQLiteQueue::currentTask(Proc::Task &out)
+u8 SQLiteQueue::listBlocked(std::vector<int> &out)
 {
-    if (!isRunning())
-    {
-        spdlog::error("{}:{} Queue is not running.", __FILE__, __LINE__);
-        return ErrCode_INVALID_ARGUMENT;
-    }
-
-    std::unique_lock<std::mutex> lock(m_currentTaskMutex);
-    out = m_currentTask;
-    return ErrCode_OK;
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    return listIDInTable("blocked", out);
 }
 
-u8 SQLiteQueue::addTask(Proc::Task &in)
+u8
+SQLiteQueue::blockedDetails(const int id,
+                            Proc::Task &out)
 {
     std::unique_lock<std::mutex> lock(m_token->mutex);
-    u8 code;
-    code = getID(in.ID);
-    if (code)
+    return taskDetails("blocked", id, out);
+}
+
+u8 SQLiteQueue::clearPending()
+{
+    std::vector<int> ids;
     {
-        spdlog::error("{}:{} Fail to get ID", __FILE__, __LINE__);
-        return ErrCode_OS_ERROR;
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        std::unique_lock<std::mutex> lock2(m_currentTaskMutex);
+        u8 code = listIDInTable("pending", ids);
+        if (code)
+        {
+            return code;
+        }
+
+        code = clearTable("pending");
+        if (code)
+        {
+            return code;
+        }
+
+        // the running task still goes to "done"
+        ids.erase(std::remove(ids.begin(), ids.end(), m_currentTask.ID), ids.end());
+    }
+
+    Event event;
+    event.type = EventType_PENDING_CLEARED;
+    m_events.publish(event);
+
+    // the dependents of the removed tasks fail
+    for (auto it = ids.begin(); it != ids.end(); ++it)
+    {
+        notifyWaiters(*it);
+        DAG::finished(taskRef(*it), false);
     }
 
-    return addTaskToTable("pending", in);
+    return ErrCode_OK;
 }
 
-u8 SQLiteQueue::removeTask(const i32 in)
+u8 SQLiteQueue::clearFinished()
 {
     std::unique_lock<std::mutex> lock(m_token->mutex);
-    return removeTaskFromPending(in, true);
-}
+    u8 code = clearTable("done");
+    if (code)
+    {
+        return code;
+    }
 
-bool SQLiteQueue::isRunning() const
-{
-    return m_isRunning.load(std::memory_order_relaxed);
-}
+    // keep the attempts of the tasks which will run again
+    if (execSQL("DELETE FROM history WHERE ID NOT IN "
+                "(SELECT ID FROM pending UNION SELECT ID FROM scheduled);"))
+    {
+        spdlog::error("{}:{} Fail to clear history", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
 
-void SQLiteQueue::readCurrentOutput(std::vector<std::string> &out)
-{
-    out.clear();
-    m_process->readCurrentOutput(out);
-}
+    if (execSQL("DELETE FROM outputLog WHERE ID NOT IN "
+                "(SELECT ID FROM pending UNION SELECT ID FROM scheduled);"))
+    {
+        spdlog::error("{}:{} Fail to clear output log", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
 
-u8 SQLiteQueue::start()
-{
-    if (isRunning())
+    if (execSQL("DELETE FROM historyRollup;"))
     {
-        spdlog::error("{}:{} Queue is running.", __FILE__, __LINE__);
-        return ErrCode_INVALID_ARGUMENT;
+        spdlog::error("{}:{} Fail to clear history rollup", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
     }
 
-    m_isRunning.store(true, std::memory_order_relaxed);
-    m_start.store(true, std::memory_order_relaxed);
-    m_thread = std::jthread(&SQLiteQueue::mainLoop, this);
+    Event event;
+    event.type = EventType_FINISHED_CLEARED;
+    m_events.publish(event);
     return ErrCode_OK;
 }
 
-void SQLiteQueue::stop()
-{
-    stopImpl();
-}
-
-// private member functions
-u8 SQLiteQueue::connectToDB(const std::string &path)
+u8 SQLiteQueue::finishedOutput(const int id, std::string &out)
 {
+    out.clear();
     std::unique_lock<std::mutex> lock(m_token->mutex);
-    u8 rcPending(0), rcDone(0), rcID(0);
+    u8 ret(ErrCode_OK);
 
-    if (sqlite3_open(path.c_str(), &m_token->db))
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT output FROM outputLog WHERE ID=?;", 40,
+        &m_token->stmt, NULL))
     {
-        spdlog::error("{}:{} Fail to open SQLite: {}", __FILE__, __LINE__,
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
             sqlite3_errmsg(m_token->db));
-        m_token->db = nullptr;
-        return 1;
+        goto exit;
     }
 
-    rcPending = verifyTable("pending");
-    if (rcPending == 1)
+    if (sqlite3_bind_int(m_token->stmt, 1, id))
     {
-        spdlog::error("{}:{} Fail to verifyTable: pending", __FILE__, __LINE__);
-        UNUSED(sqlite3_close(m_token->db));
-        m_token->db = nullptr;
-        return 1;
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
     }
 
-    rcDone = verifyTable("done");
-    if (rcPending == 1)
+    switch (sqlite3_step(m_token->stmt))
     {
-        spdlog::error("{}:{} Fail to verifyTable: done", __FILE__, __LINE__);
-        UNUSED(sqlite3_close(m_token->db));
-        m_token->db = nullptr;
-        return 1;
-    }
+    case SQLITE_ROW:
+    {
+        const void *blob = sqlite3_column_blob(m_token->stmt, 0);
+        int size = sqlite3_column_bytes(m_token->stmt, 0);
+        if (blob && size > 0)
+        {
+            out.assign(static_cast<const char *>(blob), size);
+        }
 
-    rcID = verifyID();
-    if (rcPending == 1)
+        break;
+    }
+    case SQLITE_DONE:
     {
-        spdlog::error("{}:{} Fail to verifyTable: ID", __FILE__, __LINE__);
-        UNUSED(sqlite3_close(m_token->db));
-        m_token->db = nullptr;
-        return 1;
+        spdlog::error("{}:{} No output log for ID: {}", __FILE__, __LINE__, id);
+        ret = ErrCode_NOT_FOUND;
+        break;
     }
-
-    // The all tables MUST not be exist (rcXXX == 2) in same time
-    // or all exist (rcXXX == 0) in the same time
-    if (rcPending != rcDone ||
-        rcPending != rcID ||
-        rcDone != rcID)
+    default:
     {
-        spdlog::error("{}:{} Fail to verifyTable", __FILE__, __LINE__);
-        UNUSED(sqlite3_close(m_token->db));
-        m_token->db = nullptr;
-        return 1;
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        break;
+    }
     }
 
-    return 0;
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
 }
 
-u8 SQLiteQueue::createTable(const std::string &name)
+u8 SQLiteQueue::taskHistory(const int id, std::vector<Proc::Attempt> &out)
 {
-    u8 ret(2);
-    std::string sql = "create table ";
-    sql += name;
-    sql += " ("
-        "execName text NOT NULL, "
-        "args text NOT NULL, "
-        "workDir text NOT NULL, "
-        "ID INT NOT NULL PRIMARY KEY, "
-        "exitCode INT NOT NULL, "
-        "isSuccess INT NOT NULL"
-        ");";
+    out.clear();
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    u8 ret(ErrCode_OK);
+    i32 rc(0);
+    Proc::Attempt attempt;
+
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT attempt, exitCode, endTimeMs FROM history WHERE ID=? ORDER BY attempt;", 77,
+        &m_token->stmt, NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_bind_int(m_token->stmt, 1, id))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    while (1)
+    {
+        rc = sqlite3_step(m_token->stmt);
+
+        if (rc == SQLITE_ROW)
+        {
+            attempt.attempt = sqlite3_column_int(m_token->stmt, 0);
+            attempt.exitCode = sqlite3_column_int(m_token->stmt, 1);
+            attempt.endTime = sqlite3_column_int64(m_token->stmt, 2);
+            out.push_back(attempt);
+        }
+        else if (rc == SQLITE_DONE)
+        {
+            break;
+        }
+        else
+        {
+            // other error
+            ret = ErrCode_OS_ERROR;
+            spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+                sqlite3_errmsg(m_token->db));
+            goto exit;
+        }
+    }
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+u8 SQLiteQueue::historyStats(const HistoryFilter &in, HistoryStats &out)
+{
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"history_stats\"");
+
+    out = HistoryStats();
+    i64 to = in.to;
+    if (!to)
+    {
+        to = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    if (in.from < 0 || to <= in.from)
+    {
+        spdlog::error("{}:{} Invalid time window", __FILE__, __LINE__);
+        return ErrCode_INVALID_ARGUMENT;
+    }
+
+    // every minute which overlaps the window
+    std::string sql = "SELECT count, succeeded, cpuTime, maxRunTime, runTime "
+                      "FROM historyRollup WHERE minute >= ? AND minute <= ?";
+    if (!in.execName.empty())
+    {
+        sql += " AND execName = ?";
+    }
+
+    sql += ";";
+
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    Metrics::Scope scope(latency);
+    u8 ret(ErrCode_OK);
+    i32 rc(0);
+    HistoryRollup row;
+    Metrics::HistogramSnapshot runTime;
+    runTime.buckets.resize(Metrics::Histogram::bucketCount);
+
+    if (sqlite3_prepare_v2(m_token->db,
+        sql.c_str(), sql.length(),
+        &m_token->stmt, NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_bind_int64(m_token->stmt, 1, in.from / 60000) ||
+        sqlite3_bind_int64(m_token->stmt, 2, (to - 1) / 60000) ||
+        (!in.execName.empty() &&
+         sqlite3_bind_text(m_token->stmt, 3, in.execName.c_str(), in.execName.length(), NULL)))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    while (1)
+    {
+        rc = sqlite3_step(m_token->stmt);
+
+        if (rc == SQLITE_ROW)
+        {
+            out.count += static_cast<u64>(sqlite3_column_int64(m_token->stmt, 0));
+            out.succeeded += static_cast<u64>(sqlite3_column_int64(m_token->stmt, 1));
+            out.cpuTime += static_cast<u64>(sqlite3_column_int64(m_token->stmt, 2));
+            runTime.max = std::max(runTime.max,
+                static_cast<u64>(sqlite3_column_int64(m_token->stmt, 3)));
+            row.decode(reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 4)));
+            for (auto it = row.runTime.begin(); it != row.runTime.end(); ++it)
+            {
+                runTime.buckets[it->first] += it->second;
+                runTime.count += it->second;
+            }
+        }
+        else if (rc == SQLITE_DONE)
+        {
+            break;
+        }
+        else
+        {
+            // other error
+            ret = ErrCode_OS_ERROR;
+            spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+                sqlite3_errmsg(m_token->db));
+            goto exit;
+        }
+    }
+
+    if (out.count)
+    {
+        out.successRate = static_cast<double>(out.succeeded) /
+                          static_cast<double>(out.count);
+    }
+
+    out.p50 = runTime.quantile(0.5);
+    out.p95 = runTime.quantile(0.95);
+    out.p99 = runTime.quantile(0.99);
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+bool TaskWaiter::isReady() const
+{
+    return any ? !finished.empty() : (finished.size() == tasks.size());
+}
+
+u8 SQLiteQueue::waitTasks(const std::vector<int> &ids,
+                          const bool any,
+                          const i64 deadline,
+                          const std::function<bool ()> &keepWaiting,
+                          std::vector<Proc::Task> &out)
+{
+    out.clear();
+    TaskWaiter waiter;
+    waiter.tasks.assign(ids.begin(), ids.end());
+    waiter.any = any;
+    u8 code = addWaiter(waiter);
+    if (code)
+    {
+        return code;
+    }
+
+    bool isReady(false);
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        while (!(isReady = waiter.isReady()))
+        {
+            auto now = std::chrono::system_clock::now();
+            if (deadline && now >= std::chrono::system_clock::time_point(
+                std::chrono::seconds(deadline)))
+            {
+                break;
+            }
+
+            if (!keepWaiting())
+            {
+                break;
+            }
+
+            // wake up once in a while to see if the caller is still there
+            auto until = now + std::chrono::seconds(1);
+            if (deadline)
+            {
+                until = std::min(until, std::chrono::system_clock::time_point(
+                    std::chrono::seconds(deadline)));
+            }
+
+            waiter.cond.wait_until(lock, until);
+        }
+
+        removeWaiter(waiter);
+    }
+
+    finishedTasks(waiter, out);
+    return isReady ? ErrCode_OK : ErrCode_DEADLINE_EXCEEDED;
+}
+
+u64 SQLiteQueue::waitTasksAsync(const std::vector<int> &ids,
+                                const bool any,
+                                const i64 deadline,
+                                const std::function<void (u8, std::vector<Proc::Task> &)> &onDone)
+{
+    auto waiter = std::make_shared<TaskWaiter>();
+    waiter->tasks.assign(ids.begin(), ids.end());
+    waiter->any = any;
+    waiter->onDone = onDone;
+
+    u64 handle(0);
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        handle = ++m_lastWait;
+        waiter->handle = handle;
+        m_asyncWaiters[handle] = waiter;
+    }
+
+    u8 code = addWaiter(*waiter);
+    if (code)
+    {
+        // a task finished meanwhile may have answered already
+        bool isAnswered(false);
+        {
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            isAnswered = !m_asyncWaiters.erase(handle);
+        }
+
+        if (!isAnswered)
+        {
+            std::vector<Proc::Task> out;
+            onDone(code, out);
+        }
+
+        return handle;
+    }
+
+    bool isReady(false);
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        isReady = waiter->isReady();
+    }
+
+    if (isReady)
+    {
+        finishWait(handle, ErrCode_OK, false);
+        return handle;
+    }
+
+    if (!deadline)
+    {
+        return handle;
+    }
+
+    u64 timer = Timer::add(deadline, [this, handle]()
+    {
+        finishWait(handle, ErrCode_DEADLINE_EXCEEDED, true);
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        if (m_asyncWaiters.count(handle))
+        {
+            waiter->timer = timer;
+            return handle;
+        }
+    }
+
+    // finished before the timer is known
+    Timer::cancel(timer);
+    return handle;
+}
+
+void SQLiteQueue::cancelWait(const u64 handle)
+{
+    finishWait(handle, ErrCode_DEADLINE_EXCEEDED, false);
+}
+
+u8 SQLiteQueue::stats(QueueStats &out)
+{
+    out.pending = m_pendingCount.load(std::memory_order_relaxed);
+    out.finished = m_finishedCount.load(std::memory_order_relaxed);
+    out.failed = m_failedCount.load(std::memory_order_relaxed);
+
+    i64 oldest = m_oldestPending.load(std::memory_order_relaxed);
+    if (oldest < 0)
+    {
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        if (m_oldestPending.load(std::memory_order_relaxed) < 0 &&
+            loadOldestPending())
+        {
+            spdlog::error("{}:{} Fail to find the oldest pending task", __FILE__, __LINE__);
+            return ErrCode_OS_ERROR;
+        }
+
+        oldest = m_oldestPending.load(std::memory_order_relaxed);
+    }
+
+    out.oldestPendingAge = 0;
+    if (oldest > 0)
+    {
+        i64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        out.oldestPendingAge = static_cast<u64>(std::max<i64>(now - oldest, 0));
+    }
+
+    Scheduler::Share share;
+    if (Scheduler::share(this, share))
+    {
+        spdlog::error("{}:{} Fail to get share", __FILE__, __LINE__);
+        return ErrCode_OS_ERROR;
+    }
+
+    out.running = share.running;
+
+    u64 timed = m_timedCount.load(std::memory_order_relaxed);
+    out.averageDuration = timed ?
+        m_runTimeTotal.load(std::memory_order_relaxed) / timed : 0;
+    return ErrCode_OK;
+}
+
+u8 SQLiteQueue::rename(const std::string &name)
+{
+    // held across the graph, so no ref is made with the old name meanwhile
+    std::unique_lock<std::mutex> lock(m_nameMutex);
+    if (DAG::renameQueue(m_name, name))
+    {
+        spdlog::error("{}:{} Fail to rename queue {} to {}", __FILE__, __LINE__,
+            m_name, name);
+        return ErrCode_ALREADY_EXISTS;
+    }
+
+    m_name = name;
+    return ErrCode_OK;
+}
+
+EventBus &SQLiteQueue::eventBus()
+{
+    return m_events;
+}
+
+u8 SQLiteQueue::addWaiter(TaskWaiter &waiter)
+{
+    std::sort(waiter.tasks.begin(), waiter.tasks.end());
+    waiter.tasks.erase(std::unique(waiter.tasks.begin(), waiter.tasks.end()),
+                       waiter.tasks.end());
+    if (waiter.tasks.empty())
+    {
+        spdlog::error("{}:{} No task to wait for", __FILE__, __LINE__);
+        return ErrCode_INVALID_ARGUMENT;
+    }
+
+    {
+        // register before looking at the tables, a task finished in between
+        // is not missed
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        for (auto it = waiter.tasks.begin(); it != waiter.tasks.end(); ++it)
+        {
+            m_waiters[*it].push_back(&waiter);
+        }
+    }
+
+    for (auto it = waiter.tasks.begin(); it != waiter.tasks.end(); ++it)
+    {
+        u8 state = taskState(*it);
+        if (state == TaskState_NOT_FOUND)
+        {
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            removeWaiter(waiter);
+            spdlog::error("{}:{} No such ID: {}", __FILE__, __LINE__, *it);
+            return ErrCode_NOT_FOUND;
+        }
+
+        if (state != TaskState_WAITING)
+        {
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            waiter.finished.insert(*it);
+        }
+    }
+
+    return ErrCode_OK;
+}
+
+void SQLiteQueue::removeWaiter(TaskWaiter &waiter)
+{
+    for (auto it = waiter.tasks.begin(); it != waiter.tasks.end(); ++it)
+    {
+        auto waiters = m_waiters.find(*it);
+        if (waiters == m_waiters.end())
+        {
+            continue;
+        }
+
+        auto &list = waiters->second;
+        list.erase(std::remove(list.begin(), list.end(), &waiter), list.end());
+        if (list.empty())
+        {
+            m_waiters.erase(waiters);
+        }
+    }
+}
+
+void SQLiteQueue::finishedTasks(const TaskWaiter &waiter, std::vector<Proc::Task> &out)
+{
+    // addWaiter() may still be filling it in
+    std::unordered_set<i32> finished;
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        finished = waiter.finished;
+    }
+
+    out.clear();
+    Proc::Task task;
+    for (auto it = waiter.tasks.begin(); it != waiter.tasks.end(); ++it)
+    {
+        // a removed task is not in "done"
+        if (!finished.count(*it) || taskState(*it) == TaskState_NOT_FOUND)
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        if (!taskDetails("done", *it, task))
+        {
+            out.push_back(task);
+        }
+    }
+}
+
+void SQLiteQueue::finishWait(const u64 handle, const u8 code, const bool isTimer)
+{
+    std::shared_ptr<TaskWaiter> waiter;
+    u64 timer(0);
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        auto it = m_asyncWaiters.find(handle);
+        if (it == m_asyncWaiters.end())
+        {
+            return;
+        }
+
+        waiter = it->second;
+        m_asyncWaiters.erase(it);
+        removeWaiter(*waiter);
+        timer = waiter->timer;
+    }
+
+    // a timer cannot cancel itself
+    if (timer && !isTimer)
+    {
+        Timer::cancel(timer);
+    }
+
+    std::vector<Proc::Task> out;
+    finishedTasks(*waiter, out);
+
+    // the last one, the caller may release this queue from here
+    waiter->onDone(code, out);
+}
+
+u8 SQLiteQueue::watch(const std::function<bool ()> &keepWaiting,
+                      const std::function<bool (const Event &)> &onEvent)
+{
+    auto subscription = m_events.subscribe();
+    Event event;
+    while (keepWaiting())
+    {
+        // wake up once in a while to see if the caller is still there
+        if (subscription->pop(event, std::chrono::milliseconds(1000)))
+        {
+            continue;
+        }
+
+        if (!onEvent(event))
+        {
+            break;
+        }
+    }
+
+    m_events.unsubscribe(subscription);
+    return ErrCode_OK;
+}
+
+void SQLiteQueue::notifyWaiters(const i32 id)
+{
+    std::vector<u64> ready;
+    {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        auto it = m_waiters.find(id);
+        if (it == m_waiters.end())
+        {
+            return;
+        }
+
+        for (auto waiter = it->second.begin(); waiter != it->second.end(); ++waiter)
+        {
+            (*waiter)->finished.insert(id);
+            if ((*waiter)->handle)
+            {
+                if ((*waiter)->isReady())
+                {
+                    ready.push_back((*waiter)->handle);
+                }
+
+                continue;
+            }
+
+            (*waiter)->cond.notify_all();
+        }
+    }
+
+    // the callbacks run without any lock held
+    for (auto it = ready.begin(); it != ready.end(); ++it)
+    {
+        finishWait(*it, ErrCode_OK, false);
+    }
+}
+
+u8 SQLiteQueue::currentTask(Proc::Task &out)
+{
+    if (!isRunning())
+    {
+        spdlog::error("{}:{} Queue is not running.", __FILE__, __LINE__);
+        return ErrCode_INVALID_ARGUMENT;
+    }
+
+    std::unique_lock<std::mutex> lock(m_currentTaskMutex);
+    out = m_currentTask;
+    return ErrCode_OK;
+}
+
+u8 SQLiteQueue::addTask(Proc::Task &in)
+{
+    i64 now = static_cast<i64>(time(nullptr));
+    if (!in.cron.empty())
+    {
+        Cron cron;
+        if (cron.parse(in.cron))
+        {
+            spdlog::error("{}:{} Invalid cron: {}", __FILE__, __LINE__, in.cron);
+            return ErrCode_INVALID_ARGUMENT;
+        }
+
+        in.notBefore = cron.next(std::max(now, in.notBefore));
+        if (in.notBefore < 0)
+        {
+            spdlog::error("{}:{} Cron never matches: {}", __FILE__, __LINE__, in.cron);
+            return ErrCode_INVALID_ARGUMENT;
+        }
+    }
+
+    bool isBlocked = !in.dependsOn.empty();
+    if (isBlocked && !in.cron.empty())
+    {
+        spdlog::error("{}:{} A recurring task cannot depend on other tasks",
+            __FILE__, __LINE__);
+        return ErrCode_INVALID_ARGUMENT;
+    }
+
+    Proc::TaskRef self = taskRef(in.ID);
+    for (auto it = in.dependsOn.begin(); it != in.dependsOn.end(); ++it)
+    {
+        if (it->queue.empty())
+        {
+            it->queue = self.queue;
+        }
+
+        // takes the db lock of the queue of the parent
+        u8 state = DAG::state(*it);
+        if (state == TaskState_NOT_FOUND || state == TaskState_UNKNOWN)
+        {
+            spdlog::error("{}:{} No such task: {}:{}", __FILE__, __LINE__,
+                it->queue, it->ID);
+            return ErrCode_NOT_FOUND;
+        }
+
+        // the recurring task stays scheduled, the child would wait forever
+        if (state == TaskState_RECURRING)
+        {
+            spdlog::error("{}:{} A task cannot depend on a recurring task: {}:{}",
+                __FILE__, __LINE__, it->queue, it->ID);
+            return ErrCode_INVALID_ARGUMENT;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    u8 code;
+    bool hasKey = !in.idempotencyKey.empty();
+    if (hasKey)
+    {
+        code = findDedupKey(in.idempotencyKey, now, in.ID);
+        if (code != ErrCode_NOT_FOUND)
+        {
+            // submitted before within the window, answer with the original ID
+            return code;
+        }
+
+        // the task and its key are added together or not at all
+        if (execSQL("BEGIN;"))
+        {
+            return ErrCode_OS_ERROR;
+        }
+    }
+
+    code = getID(in.ID);
+    if (code)
+    {
+        spdlog::error("{}:{} Fail to get ID", __FILE__, __LINE__);
+        code = ErrCode_OS_ERROR;
+    }
+    else
+    {
+        code = addTaskToTable(isBlocked ? "blocked" :
+                              (in.notBefore <= now) ? "pending" : "scheduled", in);
+    }
+
+    if (hasKey && !code &&
+        (addDedupKey(in.idempotencyKey, in.ID, now) || execSQL("COMMIT;")))
+    {
+        code = ErrCode_OS_ERROR;
+    }
+
+    if (code)
+    {
+        if (hasKey)
+        {
+            rollback();
+        }
+
+        return code;
+    }
+
+    if (hasKey)
+    {
+        m_dedupCache.put(in.idempotencyKey, std::make_pair(in.ID, now));
+    }
+
+    // before DAG::add(), which may finish the task already
+    Event event;
+    event.type = EventType_ADDED;
+    event.ID = in.ID;
+    m_events.publish(event);
+
+    static Metrics::Counter &added = Metrics::counter("ff_tasks_added_total");
+    added.add();
+
+    if (isBlocked)
+    {
+        // the parents finished already resolve the task at once
+        lock.unlock();
+        DAG::add(taskRef(in.ID), in.dependsOn);
+        return ErrCode_OK;
+    }
+
+    if (in.notBefore > now)
+    {
+        armTimer(in.ID, in.notBefore);
+    }
+
+    return ErrCode_OK;
+}
+
+u8 SQLiteQueue::removeTask(const i32 in)
+{
+    u8 code(ErrCode_OK);
+    {
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        code = removeTaskFromPending(in, true);
+        if (code)
+        {
+            return code;
+        }
+
+        if (sqlite3_changes(m_token->db))
+        {
+            goto removed;
+        }
+
+        code = execSQL("delete from scheduled where ID=" + std::to_string(in) + ";");
+        if (code)
+        {
+            spdlog::error("{}:{} Fail to remove scheduled task", __FILE__, __LINE__);
+            return ErrCode_OS_ERROR;
+        }
+
+        if (sqlite3_changes(m_token->db))
+        {
+            // the timer callback takes the db lock
+            lock.unlock();
+            cancelTimer(in);
+            goto removed;
+        }
+
+        code = execSQL("delete from blocked where ID=" + std::to_string(in) + ";");
+        if (code)
+        {
+            spdlog::error("{}:{} Fail to remove blocked task", __FILE__, __LINE__);
+            return ErrCode_OS_ERROR;
+        }
+
+        if (!sqlite3_changes(m_token->db))
+        {
+            spdlog::error("{}:{} No such ID: {}", __FILE__, __LINE__, in);
+            return ErrCode_NOT_FOUND;
+        }
+
+        lock.unlock();
+        DAG::remove(taskRef(in));
+    }
+
+removed:
+
+    Event event;
+    event.type = EventType_REMOVED;
+    event.ID = in;
+    m_events.publish(event);
+    notifyWaiters(in);
+
+    // the dependents of a removed task fail
+    DAG::finished(taskRef(in), false);
+    return ErrCode_OK;
+}
+
+u8 SQLiteQueue::setPriority(const i32 id, const i32 priority)
+{
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    u8 ret(ErrCode_OK);
+
+    if (sqlite3_prepare_v2(m_token->db,
+        "update pending set priority=? where ID=?;", 41,
+        &m_token->stmt, NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_bind_int(m_token->stmt, 1, priority) ||
+        sqlite3_bind_int(m_token->stmt, 2, id))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_step(m_token->stmt) != SQLITE_DONE)
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to update priority: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (!sqlite3_changes(m_token->db))
+    {
+        ret = ErrCode_NOT_FOUND;
+        spdlog::error("{}:{} No such ID in pending: {}", __FILE__, __LINE__, id);
+    }
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+bool SQLiteQueue::isRunning() const
+{
+    return m_isRunning.load(std::memory_order_relaxed);
+}
+
+void SQLiteQueue::readCurrentOutput(std::vector<std::string> &out)
+{
+    out.clear();
+    m_process->readCurrentOutput(out);
+}
+
+u8 SQLiteQueue::start()
+{
+    m_isStopped.store(false, std::memory_order_relaxed);
+    return startImpl();
+}
+
+u8 SQLiteQueue::startImpl()
+{
+    // the timer thread may start the queue as well
+    std::unique_lock<std::mutex> lock(m_loopMutex);
+    if (m_isRunning.exchange(true, std::memory_order_relaxed))
+    {
+        spdlog::error("{}:{} Queue is running.", __FILE__, __LINE__);
+        return ErrCode_INVALID_ARGUMENT;
+    }
+
+    m_start.store(true, std::memory_order_relaxed);
+
+    // a loop which is winding down after stop() goes on instead
+    if (!m_looping)
+    {
+        m_looping = true;
+        mainLoop();
+    }
+
+    return ErrCode_OK;
+}
+
+void SQLiteQueue::stop()
+{
+    m_isStopped.store(true, std::memory_order_relaxed);
+    stopImpl();
+}
+
+u8 SQLiteQueue::setAffinity(const Proc::Affinity &in)
+{
+    if (m_process->setAffinity(in))
+    {
+        spdlog::error("{}:{} Fail to set affinity.", __FILE__, __LINE__);
+        return ErrCode_INVALID_ARGUMENT;
+    }
+
+    return ErrCode_OK;
+}
+
+void SQLiteQueue::setResultCache(const bool in)
+{
+    m_useResultCache.store(in, std::memory_order_relaxed);
+}
+
+// private member functions
+u8 SQLiteQueue::connectToDB(const std::string &path)
+{
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    u8 rcPending(0), rcDone(0), rcID(0);
+
+    if (sqlite3_open(path.c_str(), &m_token->db))
+    {
+        spdlog::error("{}:{} Fail to open SQLite: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    rcPending = verifyTable("pending");
+    if (rcPending == 1)
+    {
+        spdlog::error("{}:{} Fail to verifyTable: pending", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    rcDone = verifyTable("done");
+    if (rcDone == 1)
+    {
+        spdlog::error("{}:{} Fail to verifyTable: done", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    rcID = verifyID();
+    if (rcID == 1)
+    {
+        spdlog::error("{}:{} Fail to verifyTable: ID", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    // added after the first release, may be created in an existing database
+    if (verifyTable("scheduled") == 1)
+    {
+        spdlog::error("{}:{} Fail to verifyTable: scheduled", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    if (verifyTable("blocked") == 1)
+    {
+        spdlog::error("{}:{} Fail to verifyTable: blocked", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    // The all tables MUST not be exist (rcXXX == 2) in same time
+    // or all exist (rcXXX == 0) in the same time
+    if (rcPending != rcDone ||
+        rcPending != rcID ||
+        rcDone != rcID)
+    {
+        spdlog::error("{}:{} Fail to verifyTable", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    // one row per run of a task, the end time in unix milliseconds like
+    // the one in "done"
+    if (migrateHistory() ||
+        execSQL("CREATE TABLE IF NOT EXISTS history ("
+                "ID INT NOT NULL, "
+                "attempt INT NOT NULL, "
+                "exitCode INT NOT NULL, "
+                "endTimeMs INTEGER NOT NULL"
+                ");"))
+    {
+        spdlog::error("{}:{} Fail to create table: history", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    // idempotency keys of the submissions, see addTask()
+    if (execSQL("CREATE TABLE IF NOT EXISTS dedup ("
+                "key TEXT NOT NULL PRIMARY KEY, "
+                "ID INT NOT NULL, "
+                "createdAt INTEGER NOT NULL"
+                ");"))
+    {
+        spdlog::error("{}:{} Fail to create table: dedup", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    // the rows of an old database have no key material to compare with,
+    // it is a cache only, start over
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT material FROM resultCache;", 33,
+        &m_token->stmt, NULL))
+    {
+        UNUSED(execSQL("DROP TABLE IF EXISTS resultCache;"));
+    }
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+
+    // key is the hash of a task definition and its inputs, material is
+    // what is hashed, only successful runs are kept
+    if (execSQL("CREATE TABLE IF NOT EXISTS resultCache ("
+                "key TEXT NOT NULL PRIMARY KEY, "
+                "exitCode INT NOT NULL, "
+                "output BLOB NOT NULL, "
+                "createdAt INTEGER NOT NULL, "
+                "material BLOB NOT NULL"
+                ");") ||
+        execSQL("CREATE TABLE IF NOT EXISTS outputLog ("
+                "ID INT NOT NULL PRIMARY KEY, "
+                "output BLOB NOT NULL"
+                ");"))
+    {
+        spdlog::error("{}:{} Fail to create table: resultCache", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    if (createRollup())
+    {
+        spdlog::error("{}:{} Fail to create table: historyRollup", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    if (createIndex())
+    {
+        spdlog::error("{}:{} Fail to create index", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    if (loadStats())
+    {
+        spdlog::error("{}:{} Fail to load stats", __FILE__, __LINE__);
+        UNUSED(sqlite3_close(m_token->db));
+        m_token->db = nullptr;
+        return 1;
+    }
+
+    return 0;
+}
+
+u8 SQLiteQueue::execSQL(const std::string &sql)
+{
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"exec\"");
+    Metrics::Scope scope(latency);
+
+    u8 ret(0);
+    if (sqlite3_prepare_v2(m_token->db,
+        sql.c_str(), sql.length(),
+        &m_token->stmt, NULL))
+    {
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    if (sqlite3_step(m_token->stmt) != SQLITE_DONE)
+    {
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+    }
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+void SQLiteQueue::rollback()
+{
+    UNUSED(execSQL("ROLLBACK;"));
+    if (loadStats())
+    {
+        spdlog::error("{}:{} Fail to load stats", __FILE__, __LINE__);
+    }
+}
+
+u8 SQLiteQueue::createIndex()
+{
+    // mainLoopInit() picks the next task by an index seek,
+    // the ID is the enqueue order of the tasks with the same priority
+    return execSQL("CREATE INDEX IF NOT EXISTS pendingPriority "
+                   "ON pending (priority DESC, ID);") ||
+           execSQL("CREATE INDEX IF NOT EXISTS pendingEnqueueTime "
+                   "ON pending (enqueueTime);") ||
+           execSQL("CREATE INDEX IF NOT EXISTS doneStartTime ON done (startTime);") ||
+           execSQL("CREATE INDEX IF NOT EXISTS doneEndTime ON done (endTime);") ||
+           execSQL("CREATE INDEX IF NOT EXISTS historyID ON history (ID);") ||
+           execSQL("CREATE INDEX IF NOT EXISTS dedupCreatedAt ON dedup (createdAt);");
+}
+
+u8 SQLiteQueue::loadStats()
+{
+    // once per start and after a rollback, the counters are kept in step
+    // from here on
+    u8 ret(0);
+    std::string sql = "SELECT (SELECT COUNT(*) FROM pending), "
+                      "COUNT(*), COALESCE(SUM(isSuccess = 0), 0), "
+                      "COALESCE(SUM(startTime > 0), 0), "
+                      "COALESCE(SUM(CASE WHEN startTime > 0 THEN runTime END), 0) "
+                      "FROM done;";
+
+    if (sqlite3_prepare_v2(m_token->db,
+        sql.c_str(), sql.length(),
+        &m_token->stmt, NULL))
+    {
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    if (sqlite3_step(m_token->stmt) != SQLITE_ROW)
+    {
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    m_pendingCount.store(static_cast<u64>(sqlite3_column_int64(m_token->stmt, 0)),
+                         std::memory_order_relaxed);
+    m_finishedCount.store(static_cast<u64>(sqlite3_column_int64(m_token->stmt, 1)),
+                          std::memory_order_relaxed);
+    m_failedCount.store(static_cast<u64>(sqlite3_column_int64(m_token->stmt, 2)),
+                        std::memory_order_relaxed);
+    m_timedCount.store(static_cast<u64>(sqlite3_column_int64(m_token->stmt, 3)),
+                       std::memory_order_relaxed);
+    m_runTimeTotal.store(static_cast<u64>(sqlite3_column_int64(m_token->stmt, 4)),
+                         std::memory_order_relaxed);
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    if (ret)
+    {
+        return ret;
+    }
+
+    return loadOldestPending();
+}
+
+u8 SQLiteQueue::loadOldestPending()
+{
+    // an index seek, tasks of an old database have no enqueue time
+    u8 ret(0);
+    std::string sql = "SELECT COALESCE(MIN(enqueueTime), 0) FROM pending "
+                      "WHERE enqueueTime > 0;";
+
+    if (sqlite3_prepare_v2(m_token->db,
+        sql.c_str(), sql.length(),
+        &m_token->stmt, NULL))
+    {
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    if (sqlite3_step(m_token->stmt) != SQLITE_ROW)
+    {
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    m_oldestPending.store(sqlite3_column_int64(m_token->stmt, 0),
+                          std::memory_order_relaxed);
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+u8 SQLiteQueue::migrateHistory()
+{
+    // a history of an older version has "endTime" in seconds
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT endTime FROM history;", 28,
+        &m_token->stmt, NULL))
+    {
+        // no history yet or migrated already
+        UNUSED(sqlite3_finalize(m_token->stmt));
+        m_token->stmt = nullptr;
+        return 0;
+    }
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    if (execSQL("BEGIN;"))
+    {
+        return 1;
+    }
+
+    if (execSQL("ALTER TABLE history RENAME COLUMN endTime TO endTimeMs;") ||
+        execSQL("UPDATE history SET endTimeMs = endTimeMs * 1000;") ||
+        execSQL("COMMIT;"))
+    {
+        UNUSED(execSQL("ROLLBACK;"));
+        return 1;
+    }
+
+    spdlog::info("{}:{} Migrate the end time of history to milliseconds", __FILE__, __LINE__);
+    return 0;
+}
+
+u8 SQLiteQueue::createRollup()
+{
+    // a database of an older version has "done" without a rollup
+    bool isNew(false);
+    u8 ret(0);
+    i32 rc(0);
+    Proc::Task task;
+    std::map<std::pair<i64, std::string>, HistoryRollup> rows;
+
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='historyRollup';", 79,
+        &m_token->stmt, NULL))
+    {
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    if (sqlite3_step(m_token->stmt) != SQLITE_ROW)
+    {
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    isNew = !sqlite3_column_int(m_token->stmt, 0);
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+
+    // minute is the unix time in minutes the tasks have ended,
+    // runTime is HistoryRollup::encode()
+    if (execSQL("CREATE TABLE IF NOT EXISTS historyRollup ("
+                "minute INTEGER NOT NULL, "
+                "execName TEXT NOT NULL, "
+                "count INTEGER NOT NULL, "
+                "succeeded INTEGER NOT NULL, "
+                "cpuTime INTEGER NOT NULL, "
+                "maxRunTime INTEGER NOT NULL, "
+                "runTime TEXT NOT NULL, "
+                "PRIMARY KEY (minute, execName)"
+                ");") ||
+        execSQL("CREATE INDEX IF NOT EXISTS historyRollupExecName "
+                "ON historyRollup (execName, minute);"))
+    {
+        spdlog::error("{}:{} Fail to create table: historyRollup", __FILE__, __LINE__);
+        return 1;
+    }
+
+    if (!isNew)
+    {
+        return 0;
+    }
+
+    // once, tasks finished before the times were recorded have no end time
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT execName, isSuccess, endTime, runTime, cpuTime FROM done WHERE endTime > 0;", 82,
+        &m_token->stmt, NULL))
+    {
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        ret = 1;
+        goto exit;
+    }
+
+    while (1)
+    {
+        rc = sqlite3_step(m_token->stmt);
+
+        if (rc == SQLITE_ROW)
+        {
+            task.execName = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 0));
+            task.isSuccess = sqlite3_column_int(m_token->stmt, 1);
+            task.endTime = sqlite3_column_int64(m_token->stmt, 2);
+            task.runTime = sqlite3_column_int64(m_token->stmt, 3);
+            task.cpuTime = sqlite3_column_int64(m_token->stmt, 4);
+            rows[std::make_pair(task.endTime / 60000, task.execName)].add(task);
+        }
+        else if (rc == SQLITE_DONE)
+        {
+            break;
+        }
+        else
+        {
+            // other error
+            spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+                sqlite3_errmsg(m_token->db));
+            ret = 1;
+            goto exit;
+        }
+    }
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    for (auto it = rows.begin(); it != rows.end(); ++it)
+    {
+        if (writeRollup(it->first.first, it->first.second, it->second))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+u8 SQLiteQueue::addHistory(const Proc::Task &in, const i64 endTimeMs)
+{
+    return execSQL("insert into history values(" +
+                   std::to_string(in.ID) + "," +
+                   std::to_string(in.attempt) + "," +
+                   std::to_string(in.exitCode) + "," +
+                   std::to_string(endTimeMs) + ");");
+}
+
+u8 SQLiteQueue::addToRollup(const Proc::Task &in)
+{
+    i64 minute = in.endTime / 60000;
+    HistoryRollup row;
+    u8 code = readRollup(minute, in.execName, row);
+    if (code && code != ErrCode_NOT_FOUND)
+    {
+        return code;
+    }
+
+    row.add(in);
+    return writeRollup(minute, in.execName, row);
+}
+
+u8 SQLiteQueue::readRollup(const i64 minute,
+                           const std::string &execName,
+                           HistoryRollup &out)
+{
+    u8 ret(ErrCode_OK);
+
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT count, succeeded, cpuTime, maxRunTime, runTime FROM historyRollup "
+        "WHERE minute=? AND execName=?;", 103,
+        &m_token->stmt, NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_bind_int64(m_token->stmt, 1, minute) ||
+        sqlite3_bind_text(m_token->stmt, 2, execName.c_str(), execName.length(), NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    switch (sqlite3_step(m_token->stmt))
+    {
+    case SQLITE_ROW:
+    {
+        out.count = static_cast<u64>(sqlite3_column_int64(m_token->stmt, 0));
+        out.succeeded = static_cast<u64>(sqlite3_column_int64(m_token->stmt, 1));
+        out.cpuTime = static_cast<u64>(sqlite3_column_int64(m_token->stmt, 2));
+        out.maxRunTime = static_cast<u64>(sqlite3_column_int64(m_token->stmt, 3));
+        out.decode(reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 4)));
+        break;
+    }
+    case SQLITE_DONE:
+    {
+        ret = ErrCode_NOT_FOUND;
+        break;
+    }
+    default:
+    {
+        // other error
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        break;
+    }
+    }
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+u8 SQLiteQueue::writeRollup(const i64 minute,
+                            const std::string &execName,
+                            const HistoryRollup &in)
+{
+    u8 ret(ErrCode_OK);
+    std::string runTime = in.encode();
+
+    if (sqlite3_prepare_v2(m_token->db,
+        "INSERT OR REPLACE INTO historyRollup VALUES(?,?,?,?,?,?,?);", 59,
+        &m_token->stmt, NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_bind_int64(m_token->stmt, 1, minute) ||
+        sqlite3_bind_text(m_token->stmt, 2, execName.c_str(), execName.length(), NULL) ||
+        sqlite3_bind_int64(m_token->stmt, 3, static_cast<i64>(in.count)) ||
+        sqlite3_bind_int64(m_token->stmt, 4, static_cast<i64>(in.succeeded)) ||
+        sqlite3_bind_int64(m_token->stmt, 5, static_cast<i64>(in.cpuTime)) ||
+        sqlite3_bind_int64(m_token->stmt, 6, static_cast<i64>(in.maxRunTime)) ||
+        sqlite3_bind_text(m_token->stmt, 7, runTime.c_str(), runTime.length(), NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_step(m_token->stmt) != SQLITE_DONE)
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+u8 SQLiteQueue::findDedupKey(const std::string &key, const i64 now, i32 &out)
+{
+    std::pair<i32, i64> *hit = m_dedupCache.get(key);
+    if (hit)
+    {
+        if (now - hit->second < FF_DEDUP_WINDOW)
+        {
+            out = hit->first;
+            return ErrCode_OK;
+        }
+
+        m_dedupCache.erase(key);
+        return ErrCode_NOT_FOUND;
+    }
+
+    u8 ret(ErrCode_NOT_FOUND);
+    if (sqlite3_prepare_v2(m_token->db,
+        "SELECT ID, createdAt FROM dedup WHERE key=? AND createdAt>?;", 60,
+        &m_token->stmt, NULL))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    if (sqlite3_bind_text(m_token->stmt, 1, key.c_str(), key.length(), NULL) ||
+        sqlite3_bind_int64(m_token->stmt, 2, now - FF_DEDUP_WINDOW))
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
+
+    switch (sqlite3_step(m_token->stmt))
+    {
+    case SQLITE_ROW:
+    {
+        out = sqlite3_column_int(m_token->stmt, 0);
+        m_dedupCache.put(key, std::make_pair(out,
+            static_cast<i64>(sqlite3_column_int64(m_token->stmt, 1))));
+        ret = ErrCode_OK;
+        break;
+    }
+    case SQLITE_DONE:
+    {
+        break;
+    }
+    default:
+    {
+        ret = ErrCode_OS_ERROR;
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        break;
+    }
+    }
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+u8 SQLiteQueue::addDedupKey(const std::string &key, const i32 id, const i64 now)
+{
+    // keys out of the window are free to use again
+    if (execSQL("DELETE FROM dedup WHERE createdAt<=" +
+                std::to_string(now - FF_DEDUP_WINDOW) + ";"))
+    {
+        return 1;
+    }
+
+    u8 ret(0);
+    if (sqlite3_prepare_v2(m_token->db,
+        "INSERT INTO dedup VALUES(?,?,?);", 32,
+        &m_token->stmt, NULL))
+    {
+        ret = 1;
+        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+        goto exit;
+    }
 
-    if (sqlite3_prepare_v2(m_token->db,
-        sql.c_str(),
-        sql.length(),
-        &m_token->stmt, NULL))
+    if (sqlite3_bind_text(m_token->stmt, 1, key.c_str(), key.length(), NULL) ||
+        sqlite3_bind_int(m_token->stmt, 2, id) ||
+        sqlite3_bind_int64(m_token->stmt, 3, now))
     {
+        ret = 1;
         spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
             sqlite3_errmsg(m_token->db));
-        ret = 1;
         goto exit;
     }
 
     if (sqlite3_step(m_token->stmt) != SQLITE_DONE)
     {
-        spdlog::error("{}:{} Fail to create table", __FILE__, __LINE__);
         ret = 1;
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
     }
 
 exit:
@@ -309,6 +2075,36 @@ exit:
     return ret;
 }
 
+u8 SQLiteQueue::createTable(const std::string &name)
+{
+    std::string sql = "create table ";
+    sql += name;
+    sql += " (";
+    for (size_t i = 0; i < dbColumnCount; ++i)
+    {
+        if (i)
+        {
+            sql += ", ";
+        }
+
+        sql += dbColumns[i].name;
+        sql += " ";
+        sql += dbColumns[i].type;
+        sql += " ";
+        sql += dbColumns[i].constraint;
+    }
+
+    sql += ");";
+
+    if (execSQL(sql))
+    {
+        spdlog::error("{}:{} Fail to create table", __FILE__, __LINE__);
+        return 1;
+    }
+
+    return 2;
+}
+
 u8 SQLiteQueue::verifyTable(const std::string &name)
 {
     u8 ret(0);
@@ -316,6 +2112,8 @@ u8 SQLiteQueue::verifyTable(const std::string &name)
     i32 rc(0);
     std::string colName, colType;
     std::string sql;
+    std::vector<bool> isFound(dbColumnCount, false);
+    size_t index(0);
     if (sqlite3_prepare_v2(m_token->db,
         "SELECT name FROM sqlite_master WHERE type='table' AND name=?;", 61,
         &m_token->stmt, NULL))
@@ -392,7 +2190,18 @@ u8 SQLiteQueue::verifyTable(const std::string &name)
             colName = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 1));
             colType = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 2));
 
-            if (dbColumnName[colName] != colType)
+            for (index = 0; index < dbColumnCount; ++index)
+            {
+                if (colName == dbColumns[index].name)
+                {
+                    break;
+                }
+            }
+
+            // older versions declared the text columns in lower case
+            if (index == dbColumnCount ||
+                isFound[index] ||
+                sqlite3_stricmp(colType.c_str(), dbColumns[index].type))
             {
                 spdlog::error("{}:{} Invalid name & type: {} , {}", __FILE__, __LINE__,
                     colName,
@@ -401,6 +2210,7 @@ u8 SQLiteQueue::verifyTable(const std::string &name)
                 goto exit;
             }
 
+            isFound[index] = true;
             ++rowCount;
         }
         else if (rc == SQLITE_DONE)
@@ -417,12 +2227,44 @@ u8 SQLiteQueue::verifyTable(const std::string &name)
         }
     }
 
-    if (rowCount != 6)
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+
+    // upgrade the table of an old database
+    for (index = 0; index < dbColumnCount; ++index)
     {
-        spdlog::error("{}:{} Invalid table", __FILE__, __LINE__);
-        ret = 1;
+        if (isFound[index])
+        {
+            continue;
+        }
+
+        if (!dbColumns[index].isAddable)
+        {
+            spdlog::error("{}:{} Invalid table, missing column: {}", __FILE__, __LINE__,
+                dbColumns[index].name);
+            return 1;
+        }
+
+        sql = "ALTER TABLE " + name + " ADD COLUMN ";
+        sql += dbColumns[index].name;
+        sql += " ";
+        sql += dbColumns[index].type;
+        sql += " ";
+        sql += dbColumns[index].constraint;
+        sql += ";";
+        if (execSQL(sql))
+        {
+            spdlog::error("{}:{} Fail to add column {} to table {}", __FILE__, __LINE__,
+                dbColumns[index].name, name);
+            return 1;
+        }
+
+        spdlog::info("{}:{} Add column {} to table {}", __FILE__, __LINE__,
+            dbColumns[index].name, name);
     }
 
+    return 0;
+
 exit:
 
     UNUSED(sqlite3_finalize(m_token->stmt));
@@ -637,6 +2479,10 @@ exit:
 
 u8 SQLiteQueue::clearTable(const std::string &name)
 {
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"clear\"");
+    Metrics::Scope scope(latency);
+
     std::string sql = "";
     u8 ret(ErrCode_OK);
 
@@ -658,6 +2504,20 @@ u8 SQLiteQueue::clearTable(const std::string &name)
         ret = ErrCode_OS_ERROR;
         spdlog::error("{}:{} Fail to clear table: {}", __FILE__, __LINE__,
             name);
+        goto exit;
+    }
+
+    if (name == "pending")
+    {
+        m_pendingCount.store(0, std::memory_order_relaxed);
+        m_oldestPending.store(0, std::memory_order_relaxed);
+    }
+    else if (name == "done")
+    {
+        m_finishedCount.store(0, std::memory_order_relaxed);
+        m_failedCount.store(0, std::memory_order_relaxed);
+        m_timedCount.store(0, std::memory_order_relaxed);
+        m_runTimeTotal.store(0, std::memory_order_relaxed);
     }
 
 exit:
@@ -670,6 +2530,10 @@ exit:
 u8 SQLiteQueue::listIDInTable(const std::string &name,
                               std::vector<int> &out)
 {
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"list\"");
+    Metrics::Scope scope(latency);
+
     out.clear();
     out.reserve(128);
 
@@ -720,9 +2584,13 @@ u8 SQLiteQueue::taskDetails(const std::string &name,
                             const i32 id,
                             Proc::Task &out)
 {
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"details\"");
+    Metrics::Scope scope(latency);
+
     i32 rc(0);
     i32 rowCount(0);
-    std::string sql = "SELECT * FROM " + name + " WHERE ID=?;";
+    std::string sql = "SELECT " + dbColumnList() + " FROM " + name + " WHERE ID=?;";
     u8 ret(ErrCode_OK);
 
     if (sqlite3_prepare_v2(m_token->db,
@@ -749,14 +2617,7 @@ u8 SQLiteQueue::taskDetails(const std::string &name,
 
         if (rc == SQLITE_ROW)
         {
-            out.execName = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 0));
-            splitString(reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 1)),
-                out.args);
-            out.workDir = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 2));
-            out.ID = sqlite3_column_int(m_token->stmt, 3);
-            out.exitCode = sqlite3_column_int(m_token->stmt, 4);
-            out.isSuccess = sqlite3_column_int(m_token->stmt, 5);
-
+            readTask(out);
             ++rowCount;
         }
         else if (rc == SQLITE_DONE)
@@ -790,10 +2651,29 @@ exit:
 u8 SQLiteQueue::addTaskToTable(const std::string &name,
                                const Proc::Task &in)
 {
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"insert\"");
+    Metrics::Scope scope(latency);
+
     std::string args = "";
-    std::string sql = "insert into " + name + " ";
-    sql += "values(?,?,?,?,?,?);";
+    std::string inputs = "";
+    std::string dependsOn = "";
+    i64 enqueueTime = in.enqueueTime;
+    i64 startTime = in.startTime;
+    i64 endTime = in.endTime;
+    i64 waitTime = in.waitTime;
+    i64 runTime = in.runTime;
+    i64 cpuTime = in.cpuTime;
+    std::string sql = "insert into " + name + " (" + dbColumnList() + ") ";
+    sql += "values(";
+    for (size_t i = 0; i < dbColumnCount; ++i)
+    {
+        sql += i ? ",?" : "?";
+    }
+
+    sql += ");";
     u8 ret(ErrCode_OK);
+    i32 col(0);
 
     if (sqlite3_prepare_v2(m_token->db,
         sql.c_str(), sql.length(),
@@ -805,7 +2685,49 @@ u8 SQLiteQueue::addTaskToTable(const std::string &name,
         goto exit;
     }
 
-    if (sqlite3_bind_text(m_token->stmt, 1, in.execName.c_str(), in.execName.length(), NULL))
+    // same order as dbColumns
+    args = concatString(in.args);
+    inputs = concatString(in.inputs);
+    dependsOn = concatRefs(in.dependsOn);
+
+    // the time since it is ready to run, kept when it moves on to "done",
+    // the times of an earlier run of a retried task are dropped
+    if (name == "pending")
+    {
+        enqueueTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        startTime = 0;
+        endTime = 0;
+        waitTime = 0;
+        runTime = 0;
+        cpuTime = 0;
+    }
+
+    if (sqlite3_bind_text(m_token->stmt, ++col, in.execName.c_str(), in.execName.length(), NULL) ||
+        sqlite3_bind_text(m_token->stmt, ++col, args.c_str(), args.length(), NULL) ||
+        sqlite3_bind_text(m_token->stmt, ++col, in.workDir.c_str(), in.workDir.length(), NULL) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.ID) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.exitCode) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.isSuccess) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.priority) ||
+        sqlite3_bind_int64(m_token->stmt, ++col, in.notBefore) ||
+        sqlite3_bind_text(m_token->stmt, ++col, in.cron.c_str(), in.cron.length(), NULL) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.maxRetries) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.backoff) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.backoffMax) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.attempt) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.timeout) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.idleOutputTimeout) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.timedOut) ||
+        sqlite3_bind_text(m_token->stmt, ++col, inputs.c_str(), inputs.length(), NULL) ||
+        sqlite3_bind_int(m_token->stmt, ++col, in.cached) ||
+        sqlite3_bind_text(m_token->stmt, ++col, dependsOn.c_str(), dependsOn.length(), NULL) ||
+        sqlite3_bind_int64(m_token->stmt, ++col, enqueueTime) ||
+        sqlite3_bind_int64(m_token->stmt, ++col, startTime) ||
+        sqlite3_bind_int64(m_token->stmt, ++col, endTime) ||
+        sqlite3_bind_int64(m_token->stmt, ++col, waitTime) ||
+        sqlite3_bind_int64(m_token->stmt, ++col, runTime) ||
+        sqlite3_bind_int64(m_token->stmt, ++col, cpuTime))
     {
         ret = ErrCode_OS_ERROR;
         spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
@@ -813,64 +2735,448 @@ u8 SQLiteQueue::addTaskToTable(const std::string &name,
         goto exit;
     }
 
-    args = concatString(in.args);
-    if (sqlite3_bind_text(m_token->stmt, 2, args.c_str(), args.length(), NULL))
+    if (sqlite3_step(m_token->stmt) != SQLITE_DONE)
     {
         ret = ErrCode_OS_ERROR;
-        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
-            sqlite3_errmsg(m_token->db));
+        spdlog::error("{}:{} Fail to insert task to table {}", __FILE__, __LINE__,
+            name);
         goto exit;
     }
 
-    if (sqlite3_bind_text(m_token->stmt, 3, in.workDir.c_str(), in.workDir.length(), NULL))
+    if (name == "pending")
     {
-        ret = ErrCode_OS_ERROR;
-        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
-            sqlite3_errmsg(m_token->db));
-        goto exit;
+        // the newest one, it is the oldest only if there is no other
+        // (or the others have no enqueue time)
+        if (!m_pendingCount.fetch_add(1, std::memory_order_relaxed) ||
+            !m_oldestPending.load(std::memory_order_relaxed))
+        {
+            m_oldestPending.store(enqueueTime, std::memory_order_relaxed);
+        }
+    }
+    else if (name == "done")
+    {
+        m_finishedCount.fetch_add(1, std::memory_order_relaxed);
+        if (!in.isSuccess)
+        {
+            m_failedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (startTime > 0)
+        {
+            m_timedCount.fetch_add(1, std::memory_order_relaxed);
+            m_runTimeTotal.fetch_add(static_cast<u64>(std::max<i64>(runTime, 0)),
+                                     std::memory_order_relaxed);
+        }
     }
 
-    if (sqlite3_bind_int(m_token->stmt, 4, in.ID))
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+void SQLiteQueue::readTask(Proc::Task &out)
+{
+    // same order as dbColumns
+    i32 col(0);
+    out.execName = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, col++));
+    splitString(reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, col++)),
+        out.args);
+    out.workDir = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, col++));
+    out.ID = sqlite3_column_int(m_token->stmt, col++);
+    out.exitCode = sqlite3_column_int(m_token->stmt, col++);
+    out.isSuccess = sqlite3_column_int(m_token->stmt, col++);
+    out.priority = sqlite3_column_int(m_token->stmt, col++);
+    out.notBefore = sqlite3_column_int64(m_token->stmt, col++);
+    out.cron = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, col++));
+    out.maxRetries = sqlite3_column_int(m_token->stmt, col++);
+    out.backoff = sqlite3_column_int(m_token->stmt, col++);
+    out.backoffMax = sqlite3_column_int(m_token->stmt, col++);
+    out.attempt = sqlite3_column_int(m_token->stmt, col++);
+    out.timeout = sqlite3_column_int(m_token->stmt, col++);
+    out.idleOutputTimeout = sqlite3_column_int(m_token->stmt, col++);
+    out.timedOut = sqlite3_column_int(m_token->stmt, col++);
+    std::string inputs = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, col++));
+    out.inputs.clear();
+    if (!inputs.empty())
+    {
+        splitString(inputs, out.inputs);
+    }
+
+    out.cached = sqlite3_column_int(m_token->stmt, col++);
+    splitRefs(reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, col++)),
+        out.dependsOn);
+    out.enqueueTime = sqlite3_column_int64(m_token->stmt, col++);
+    out.startTime = sqlite3_column_int64(m_token->stmt, col++);
+    out.endTime = sqlite3_column_int64(m_token->stmt, col++);
+    out.waitTime = sqlite3_column_int64(m_token->stmt, col++);
+    out.runTime = sqlite3_column_int64(m_token->stmt, col++);
+    out.cpuTime = sqlite3_column_int64(m_token->stmt, col++);
+}
+
+void SQLiteQueue::armTimer(const i32 id, const i64 when)
+{
+    std::unique_lock<std::mutex> lock(m_timerMutex);
+    m_timers[id] = Timer::add(when, [this, id]()
+    {
+        promote(id);
+    });
+}
+
+void SQLiteQueue::cancelTimer(const i32 id)
+{
+    u64 timer(0);
+    {
+        std::unique_lock<std::mutex> lock(m_timerMutex);
+        auto it = m_timers.find(id);
+        if (it == m_timers.end())
+        {
+            return;
+        }
+
+        timer = it->second;
+        m_timers.erase(it);
+    }
+
+    // may wait for the callback, which takes m_timerMutex
+    Timer::cancel(timer);
+}
+
+void SQLiteQueue::cancelTimers()
+{
+    std::unordered_map<i32, u64> timers;
+    {
+        std::unique_lock<std::mutex> lock(m_timerMutex);
+        timers.swap(m_timers);
+    }
+
+    for (auto it = timers.begin(); it != timers.end(); ++it)
+    {
+        Timer::cancel(it->second);
+    }
+}
+
+u8 SQLiteQueue::loadScheduled()
+{
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    std::vector<int> ids;
+    if (listIDInTable("scheduled", ids))
+    {
+        return 1;
+    }
+
+    // a time in the past fires on the next tick, so a task missed while the
+    // server was down runs once
+    Proc::Task task;
+    for (auto it = ids.begin(); it != ids.end(); ++it)
+    {
+        if (taskDetails("scheduled", *it, task))
+        {
+            return 1;
+        }
+
+        armTimer(task.ID, task.notBefore);
+    }
+
+    return 0;
+}
+
+Proc::TaskRef SQLiteQueue::taskRef(const i32 id)
+{
+    Proc::TaskRef ret;
+    {
+        std::unique_lock<std::mutex> lock(m_nameMutex);
+        ret.queue = m_name;
+    }
+
+    ret.ID = id;
+    return ret;
+}
+
+u8 SQLiteQueue::taskState(const i32 id)
+{
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    u8 ret(TaskState_NOT_FOUND);
+
+    // 2 for running, waiting for a retry or for its own parents,
+    // 3 for recurring, only the scheduled row of such a task has a cron
+    std::string sql = "SELECT isSuccess FROM done WHERE ID=?1 "
+                      "UNION ALL SELECT 2 FROM pending WHERE ID=?1 "
+                      "UNION ALL SELECT CASE WHEN cron='' THEN 2 ELSE 3 END "
+                      "FROM scheduled WHERE ID=?1 "
+                      "UNION ALL SELECT 2 FROM blocked WHERE ID=?1 LIMIT 1;";
+    if (sqlite3_prepare_v2(m_token->db,
+        sql.c_str(), sql.length(),
+        &m_token->stmt, NULL) ||
+        sqlite3_bind_int(m_token->stmt, 1, id))
     {
-        ret = ErrCode_OS_ERROR;
         spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
             sqlite3_errmsg(m_token->db));
+        // keep the dependents waiting
+        ret = TaskState_WAITING;
         goto exit;
     }
 
-    if (sqlite3_bind_int(m_token->stmt, 5, in.exitCode))
+    switch (sqlite3_step(m_token->stmt))
     {
-        ret = ErrCode_OS_ERROR;
-        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+    case SQLITE_ROW:
+    {
+        switch (sqlite3_column_int(m_token->stmt, 0))
+        {
+        case 0:
+            ret = TaskState_FAILED;
+            break;
+        case 1:
+            ret = TaskState_SUCCEEDED;
+            break;
+        case 3:
+            ret = TaskState_RECURRING;
+            break;
+        default:
+            ret = TaskState_WAITING;
+            break;
+        }
+
+        break;
+    }
+    case SQLITE_DONE:
+    {
+        break;
+    }
+    default:
+    {
+        spdlog::error("{}:{} Fail to execute sql: {}", __FILE__, __LINE__,
             sqlite3_errmsg(m_token->db));
-        goto exit;
+        ret = TaskState_WAITING;
+        break;
+    }
+    }
+
+exit:
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+    return ret;
+}
+
+void SQLiteQueue::unblock(const i32 id, const bool isReady)
+{
+    std::unique_lock<std::mutex> promoteLock(m_promoteMutex);
+    if (m_isClosing)
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        Proc::Task task;
+        if (taskDetails("blocked", id, task))
+        {
+            // removed
+            return;
+        }
+
+        std::string table = "done";
+        if (isReady)
+        {
+            table = (task.notBefore > static_cast<i64>(time(nullptr))) ?
+                    "scheduled" : "pending";
+        }
+        else
+        {
+            spdlog::warn("{}:{} Task {} is cancelled, one of its parents has failed",
+                __FILE__, __LINE__, id);
+            task.exitCode = -1;
+            task.isSuccess = false;
+            task.endTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        if (execSQL("BEGIN;"))
+        {
+            return;
+        }
+
+        if (addTaskToTable(table, task) ||
+            execSQL("delete from blocked where ID=" + std::to_string(id) + ";"))
+        {
+            spdlog::error("{}:{} Fail to unblock task {}", __FILE__, __LINE__, id);
+            rollback();
+            return;
+        }
+
+        if (!isReady)
+        {
+            // recorded like a task which has run and failed, the task itself is
+            // cancelled either way
+            if (addHistory(task, task.endTime))
+            {
+                spdlog::error("{}:{} Fail to add history", __FILE__, __LINE__);
+            }
+
+            if (addToRollup(task))
+            {
+                spdlog::error("{}:{} Fail to add task to history rollup", __FILE__, __LINE__);
+            }
+        }
+
+        if (execSQL("COMMIT;"))
+        {
+            spdlog::error("{}:{} Fail to unblock task {}", __FILE__, __LINE__, id);
+            rollback();
+            return;
+        }
+
+        if (!isReady)
+        {
+            Event event;
+            event.type = EventType_FINISHED;
+            event.ID = id;
+            event.exitCode = task.exitCode;
+            m_events.publish(event);
+        }
+
+        if (table == "scheduled")
+        {
+            armTimer(id, task.notBefore);
+        }
+    }
+
+    promoteLock.unlock();
+    if (!isReady)
+    {
+        notifyWaiters(id);
+
+        // fail the whole subtree
+        DAG::finished(taskRef(id), false);
+        return;
+    }
+
+    if (!m_isStopped.load(std::memory_order_relaxed) && !isRunning())
+    {
+        UNUSED(startImpl());
+    }
+}
+
+void SQLiteQueue::loadBlocked()
+{
+    std::vector<Proc::Task> tasks;
+    {
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        std::vector<int> ids;
+        if (listIDInTable("blocked", ids))
+        {
+            spdlog::error("{}:{} Fail to list blocked tasks", __FILE__, __LINE__);
+            return;
+        }
+
+        Proc::Task task;
+        for (auto it = ids.begin(); it != ids.end(); ++it)
+        {
+            if (!taskDetails("blocked", *it, task))
+            {
+                tasks.push_back(task);
+            }
+        }
+    }
+
+    // the parents in the queues not loaded yet are checked when they are
+    for (auto it = tasks.begin(); it != tasks.end(); ++it)
+    {
+        DAG::add(taskRef(it->ID), it->dependsOn);
+    }
+}
+
+void SQLiteQueue::promote(const i32 id)
+{
+    std::unique_lock<std::mutex> promoteLock(m_promoteMutex);
+    if (m_isClosing)
+    {
+        return;
     }
 
-    if (sqlite3_bind_int(m_token->stmt, 6, in.isSuccess))
-    {
-        ret = ErrCode_OS_ERROR;
-        spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
-            sqlite3_errmsg(m_token->db));
-        goto exit;
+    {
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        Proc::Task task;
+        if (taskDetails("scheduled", id, task))
+        {
+            // removed
+            return;
+        }
+
+        i64 now = static_cast<i64>(time(nullptr));
+        i64 next(-1);
+        if (!task.cron.empty())
+        {
+            Cron cron;
+            if (!cron.parse(task.cron))
+            {
+                // skip the fires missed while the server was down
+                next = cron.next(now);
+            }
+        }
+
+        if (execSQL("BEGIN;"))
+        {
+            return;
+        }
+
+        // a recurring task runs as a new task each time, a delayed one or
+        // a retry keeps its ID
+        Proc::Task toRun = task;
+        toRun.cron = "";
+        if ((next >= 0 && getID(toRun.ID)) ||
+            addTaskToTable("pending", toRun))
+        {
+            spdlog::error("{}:{} Fail to promote task {}", __FILE__, __LINE__, id);
+            rollback();
+            return;
+        }
+
+        std::string sql;
+        if (next < 0)
+        {
+            sql = "delete from scheduled where ID=" + std::to_string(id) + ";";
+        }
+        else
+        {
+            sql = "update scheduled set notBefore=" + std::to_string(next) +
+                  " where ID=" + std::to_string(id) + ";";
+        }
+
+        if (execSQL(sql) || execSQL("COMMIT;"))
+        {
+            spdlog::error("{}:{} Fail to promote task {}", __FILE__, __LINE__, id);
+            rollback();
+            return;
+        }
+
+        if (next < 0)
+        {
+            std::unique_lock<std::mutex> lock(m_timerMutex);
+            m_timers.erase(id);
+        }
+        else
+        {
+            armTimer(id, next);
+        }
     }
 
-    if (sqlite3_step(m_token->stmt) != SQLITE_DONE)
+    // a stopped queue stays stopped, the task waits in pending
+    if (!m_isStopped.load(std::memory_order_relaxed) && !isRunning())
     {
-        ret = ErrCode_OS_ERROR;
-        spdlog::error("{}:{} Fail to insert task to table {}", __FILE__, __LINE__,
-            name);
+        UNUSED(startImpl());
     }
-
-exit:
-
-    UNUSED(sqlite3_finalize(m_token->stmt));
-    m_token->stmt = nullptr;
-    return ret;
 }
 
 u8 SQLiteQueue::removeTaskFromPending(const i32 id,
                                       const bool needCheckCurrentTask)
 {
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"remove\"");
+    Metrics::Scope scope(latency);
+
     u8 ret(ErrCode_OK);
     if (needCheckCurrentTask)
     {
@@ -904,6 +3210,15 @@ u8 SQLiteQueue::removeTaskFromPending(const i32 id,
     {
         ret = ErrCode_NOT_FOUND;
         spdlog::error("{}:{} Fail to remove task", __FILE__, __LINE__);
+        goto exit;
+    }
+
+    // the running task is gone already if pending has been cleared
+    if (sqlite3_changes(m_token->db))
+    {
+        // the oldest may be the one removed, stats() looks it up again
+        bool isEmpty = (m_pendingCount.fetch_sub(1, std::memory_order_relaxed) == 1);
+        m_oldestPending.store(isEmpty ? 0 : -1, std::memory_order_relaxed);
     }
 
 exit:
@@ -951,8 +3266,51 @@ exit:
     return out;
 }
 
+void SQLiteQueue::splitRefs(const std::string &in, std::vector<Proc::TaskRef> &out)
+{
+    out.clear();
+    if (in.empty())
+    {
+        return;
+    }
+
+    std::vector<std::string> refs;
+    splitString(in, refs);
+    Proc::TaskRef ref;
+    for (auto it = refs.begin(); it != refs.end(); ++it)
+    {
+        // queue names may contain ':'
+        size_t pos = it->rfind(':');
+        if (pos == std::string::npos)
+        {
+            spdlog::error("{}:{} Invalid dependency: {}", __FILE__, __LINE__, *it);
+            continue;
+        }
+
+        ref.queue = it->substr(0, pos);
+        ref.ID = static_cast<i32>(strtol(it->c_str() + pos + 1, nullptr, 10));
+        out.push_back(ref);
+    }
+}
+
+std::string SQLiteQueue::concatRefs(const std::vector<Proc::TaskRef> &in)
+{
+    std::vector<std::string> refs;
+    refs.reserve(in.size());
+    for (auto it = in.begin(); it != in.end(); ++it)
+    {
+        refs.push_back(it->queue + ":" + std::to_string(it->ID));
+    }
+
+    return concatString(refs);
+}
+
 u8 SQLiteQueue::getID(i32 &out)
 {
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"id\"");
+    Metrics::Scope scope(latency);
+
     i32 rc(0);
     i32 rowCount(0);
     i32 oldValue(0), newValue(0);
@@ -1041,43 +3399,111 @@ exit:
     return ret;
 }
 
-void SQLiteQueue::mainLoop()
+Executor::Job SQLiteQueue::mainLoop()
 {
-    while (m_start.load(std::memory_order_relaxed))
+    // every wait below suspends the coroutine, the queue holds no thread
+    // while it is waiting for a slot or for its task
+    while (keepLooping())
     {
-        if (mainLoopInit())
+        if (co_await Executor::call([this]() { return mainLoopInit(); }))
         {
             continue;
         }
 
+        // a deterministic task which has succeeded before is not run again
+        std::string key, material;
+        if (m_useResultCache.load(std::memory_order_relaxed) &&
+            !resultKey(m_currentTask, key, material))
+        {
+            if (!co_await Executor::call([this, &key, &material]()
+                {
+                    return finishFromCache(key, material);
+                }))
+            {
+                co_await Executor::call([this]() { mainLoopFin(); });
+                continue;
+            }
+        }
+
+        // wait for a free slot of the host
+        if (co_await Executor::callback([this](Executor::Callback::Done done)
+            {
+                Scheduler::acquire(this, m_start, std::move(done));
+            }))
+        {
+            std::unique_lock<std::mutex> lock(m_currentTaskMutex);
+            m_currentTask = Proc::Task();
+            continue;
+        }
+
         // invoke process
+        markStarted();
+        auto begin = std::chrono::steady_clock::now();
         if (m_process->start(m_currentTask))
         {
             spdlog::error("{}:{} Fail to start process.", __FILE__, __LINE__);
-            mainLoopFin();
+            Scheduler::release(this, std::chrono::steady_clock::now() - begin);
+            co_await Executor::call([this]() { mainLoopFin(); });
             m_start.store(false, std::memory_order_relaxed);
             continue;
         }
 
-        while(m_process->isRunning())
+        armWatchdog(m_currentTask);
+        co_await Executor::callback([this](Executor::Callback::Done done)
+        {
+            m_process->onExited([done]() { done(0); });
+        });
+
+        bool timedOut = disarmWatchdog();
+        auto used = std::chrono::steady_clock::now() - begin;
+        Scheduler::release(this, used);
+        {
+            std::unique_lock<std::mutex> lock(m_currentTaskMutex);
+            m_currentTask.timedOut = timedOut;
+            m_currentTask.runTime =
+                std::chrono::duration_cast<std::chrono::milliseconds>(used).count();
+        }
+
+        if (!key.empty())
         {
-            sleep(1);
+            co_await Executor::call([this, &key, &material]() { saveResult(key, material); });
         }
 
-        mainLoopFin();
-    } // end while (m_start.load(std::memory_order_relaxed))
+        co_await Executor::call([this]() { mainLoopFin(); });
+    } // end while (keepLooping())
+
+    // "this" may be gone here
+} // end Executor::Job SQLiteQueue::mainLoop()
+
+bool SQLiteQueue::keepLooping()
+{
+    std::unique_lock<std::mutex> lock(m_loopMutex);
+    if (m_start.load(std::memory_order_relaxed))
+    {
+        return true;
+    }
 
     m_isRunning.store(false, std::memory_order_relaxed);
-} // end void DirQueue::mainLoop()
+    m_looping = false;
+    m_loopCond.notify_all();
+    return false;
+}
 
 u8 SQLiteQueue::mainLoopInit()
 {
-    // find the task in pending list
+    static Metrics::Histogram &latency =
+        Metrics::histogram("ff_sqlite_duration_us", "op=\"next\"");
+    static Metrics::Histogram &queued = Metrics::histogram("ff_task_queued_us");
+
+    // find the task with the highest priority in pending list
     std::unique_lock<std::mutex> lock(m_token->mutex);
+    Metrics::Scope scope(latency);
     u8 ret(0);
+    std::string sql = "SELECT " + dbColumnList() +
+                      " FROM pending ORDER BY priority DESC, ID LIMIT 1;";
 
     if (sqlite3_prepare_v2(m_token->db,
-        "SELECT * FROM pending limit 1;", 30,
+        sql.c_str(), sql.length(),
         &m_token->stmt, NULL))
     {
         spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
@@ -1091,13 +3517,21 @@ u8 SQLiteQueue::mainLoopInit()
     case SQLITE_ROW:
     {
         std::unique_lock<std::mutex> lock(m_currentTaskMutex);
-        m_currentTask.execName = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 0));
-        splitString(reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 1)),
-            m_currentTask.args);
-        m_currentTask.workDir = reinterpret_cast<const char *>(sqlite3_column_text(m_token->stmt, 2));
-        m_currentTask.ID = sqlite3_column_int(m_token->stmt, 3);
-        m_currentTask.exitCode = sqlite3_column_int(m_token->stmt, 4);
-        m_currentTask.isSuccess = sqlite3_column_int(m_token->stmt, 5);
+        readTask(m_currentTask);
+
+        // tasks of an old database have no enqueue time
+        if (m_currentTask.enqueueTime > 0)
+        {
+            i64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            queued.record(static_cast<u64>(
+                std::max<i64>(now - m_currentTask.enqueueTime, 0)) * 1000);
+        }
+
+        Event event;
+        event.type = EventType_STARTED;
+        event.ID = m_currentTask.ID;
+        m_events.publish(event);
         break;
     }
     case SQLITE_DONE:
@@ -1127,19 +3561,70 @@ exit:
     return ret;
 }
 
+void SQLiteQueue::markStarted()
+{
+    i64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::unique_lock<std::mutex> lock(m_currentTaskMutex);
+    m_currentTask.startTime = now;
+
+    // tasks of an old database have no enqueue time
+    if (m_currentTask.enqueueTime > 0)
+    {
+        m_currentTask.waitTime = std::max<i64>(now - m_currentTask.enqueueTime, 0);
+    }
+}
+
 void SQLiteQueue::mainLoopFin()
 {
+    i32 id(0);
+    bool isSuccess(false);
+    if (moveToDone(id, isSuccess))
+    {
+        return;
+    }
+
+    notifyWaiters(id);
+
+    // without any lock, the dependents may be in this queue
+    DAG::finished(taskRef(id), isSuccess);
+}
+
+u8 SQLiteQueue::moveToDone(i32 &id, bool &isSuccess)
+{
+    // in the same order as clearPending(), which runs on another thread
+    std::unique_lock<std::mutex> dbLock(m_token->mutex);
     std::unique_lock<std::mutex> lock(m_currentTaskMutex);
-    if (m_process->exitCode(m_currentTask.exitCode))
+    if (!m_currentTask.cached && m_process->exitCode(m_currentTask.exitCode))
     {
         spdlog::error("{}:{} Fail to get exit code.", __FILE__, __LINE__);
         m_start.store(false, std::memory_order_relaxed);
         m_currentTask = Proc::Task();
-        return;
+        return 1;
+    }
+
+    if (!m_currentTask.cached && m_process->cpuTime(m_currentTask.cpuTime))
+    {
+        spdlog::warn("{}:{} Fail to get cpu time.", __FILE__, __LINE__);
+        m_currentTask.cpuTime = 0;
+    }
+
+    m_currentTask.isSuccess = (m_currentTask.exitCode == 0);
+    i64 nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (m_currentTask.startTime > 0)
+    {
+        m_currentTask.endTime = nowMs;
     }
 
     // write task details to done list
-    std::unique_lock<std::mutex> dbLock(m_token->mutex);
+    i64 now = static_cast<i64>(time(nullptr));
+    if (addHistory(m_currentTask, nowMs))
+    {
+        // the attempt is lost, but the task itself goes on
+        spdlog::error("{}:{} Fail to add history", __FILE__, __LINE__);
+    }
+
     u8 code(ErrCode_OK);
     code = removeTaskFromPending(m_currentTask.ID, false);
     if (code == ErrCode_INVALID_ARGUMENT ||
@@ -1148,7 +3633,28 @@ void SQLiteQueue::mainLoopFin()
         spdlog::error("{}:{} Fail to remove task from pending", __FILE__, __LINE__);
         m_start.store(false, std::memory_order_relaxed);
         m_currentTask = Proc::Task();
-        return;
+        return 1;
+    }
+
+    if (!m_currentTask.isSuccess && shouldRetry(m_currentTask))
+    {
+        i64 delay = retryDelay(m_currentTask);
+        ++m_currentTask.attempt;
+        m_currentTask.notBefore = now + delay;
+        if (!addTaskToTable("scheduled", m_currentTask))
+        {
+            static Metrics::Counter &retried =
+                Metrics::counter("ff_tasks_retried_total");
+            retried.add();
+            spdlog::info("{}:{} Retry task {} in {} seconds, attempt {}", __FILE__, __LINE__,
+                m_currentTask.ID, delay, m_currentTask.attempt);
+            armTimer(m_currentTask.ID, m_currentTask.notBefore);
+            m_currentTask = Proc::Task();
+            return 1;
+        }
+
+        spdlog::error("{}:{} Fail to schedule retry", __FILE__, __LINE__);
+        --m_currentTask.attempt;
     }
 
     if (addTaskToTable("done", m_currentTask))
@@ -1156,10 +3662,314 @@ void SQLiteQueue::mainLoopFin()
         spdlog::error("{}:{} Fail to add task to done list", __FILE__, __LINE__);
         m_start.store(false, std::memory_order_relaxed);
         m_currentTask = Proc::Task();
-        return;
+        return 1;
+    }
+
+    if (m_currentTask.endTime > 0 && addToRollup(m_currentTask))
+    {
+        // the task itself is finished
+        spdlog::error("{}:{} Fail to add task to history rollup", __FILE__, __LINE__);
     }
 
+    id = m_currentTask.ID;
+    isSuccess = m_currentTask.isSuccess;
+
+    Event event;
+    event.type = EventType_FINISHED;
+    event.ID = id;
+    event.exitCode = m_currentTask.exitCode;
+    event.isSuccess = isSuccess;
+    m_events.publish(event);
+
+    static Metrics::Counter &succeeded =
+        Metrics::counter("ff_tasks_finished_total", "result=\"success\"");
+    static Metrics::Counter &failed =
+        Metrics::counter("ff_tasks_finished_total", "result=\"failure\"");
+    (isSuccess ? succeeded : failed).add();
+
     m_currentTask = Proc::Task();
+    return 0;
+}
+
+void SQLiteQueue::armWatchdog(const Proc::Task &task)
+{
+    std::unique_lock<std::mutex> lock(m_watchdogMutex);
+    m_watchdogArmed = true;
+    m_timedOut = false;
+    i64 now = static_cast<i64>(time(nullptr));
+    i32 id = task.ID;
+    if (task.timeout > 0)
+    {
+        m_timeoutTimer = Timer::add(now + task.timeout, [this, id]()
+        {
+            std::unique_lock<std::mutex> lock(m_watchdogMutex);
+            if (!m_watchdogArmed || m_timedOut)
+            {
+                return;
+            }
+
+            spdlog::warn("{}:{} Task {} is timed out", __FILE__, __LINE__, id);
+            terminateTask(id);
+        });
+    }
+
+    if (task.idleOutputTimeout > 0)
+    {
+        i32 idle = task.idleOutputTimeout;
+        m_idleTimer = Timer::add(now + idle, [this, id, idle]()
+        {
+            checkIdleOutput(id, idle);
+        });
+    }
+}
+
+bool SQLiteQueue::disarmWatchdog()
+{
+    bool ret(false);
+    u64 timers[3];
+    {
+        // no callback arms a new timer after this
+        std::unique_lock<std::mutex> lock(m_watchdogMutex);
+        m_watchdogArmed = false;
+        ret = m_timedOut;
+        timers[0] = m_timeoutTimer;
+        timers[1] = m_idleTimer;
+        timers[2] = m_killTimer;
+        m_timeoutTimer = 0;
+        m_idleTimer = 0;
+        m_killTimer = 0;
+    }
+
+    // may wait for the callbacks, which take m_watchdogMutex
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (timers[i])
+        {
+            Timer::cancel(timers[i]);
+        }
+    }
+
+    return ret;
+}
+
+void SQLiteQueue::checkIdleOutput(const i32 id, const i32 idle)
+{
+    std::unique_lock<std::mutex> lock(m_watchdogMutex);
+    if (!m_watchdogArmed || m_timedOut)
+    {
+        return;
+    }
+
+    i64 last = m_process->lastOutputTime();
+    if (static_cast<i64>(time(nullptr)) - last < idle)
+    {
+        // there was output meanwhile, check again "idle" seconds after it
+        m_idleTimer = Timer::add(last + idle, [this, id, idle]()
+        {
+            checkIdleOutput(id, idle);
+        });
+
+        return;
+    }
+
+    spdlog::warn("{}:{} Task {} has no output for {} seconds",
+        __FILE__, __LINE__, id, idle);
+    terminateTask(id);
+}
+
+void SQLiteQueue::terminateTask(const i32 id)
+{
+    m_timedOut = true;
+    if (m_process->terminate(false))
+    {
+        spdlog::error("{}:{} Fail to terminate task {}", __FILE__, __LINE__, id);
+    }
+
+    // the task has a grace period to clean up before it is killed
+    m_killTimer = Timer::add(static_cast<i64>(time(nullptr)) + FF_KILL_GRACE_PERIOD,
+        [this, id]()
+    {
+        std::unique_lock<std::mutex> lock(m_watchdogMutex);
+        if (!m_watchdogArmed)
+        {
+            return;
+        }
+
+        spdlog::warn("{}:{} Kill task {}", __FILE__, __LINE__, id);
+        if (m_process->terminate(true))
+        {
+            spdlog::error("{}:{} Fail to kill task {}", __FILE__, __LINE__, id);
+        }
+    });
+}
+
+u8 SQLiteQueue::finishFromCache(const std::string &key, const std::string &material)
+{
+    // only the loop thread writes m_currentTask
+    i32 id = m_currentTask.ID;
+    i32 exitCode(0);
+    {
+        std::unique_lock<std::mutex> lock(m_token->mutex);
+        u8 ret(1);
+        if (sqlite3_prepare_v2(m_token->db,
+            "SELECT exitCode, material FROM resultCache WHERE key=?;", 55,
+            &m_token->stmt, NULL))
+        {
+            spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+                sqlite3_errmsg(m_token->db));
+            goto exit;
+        }
+
+        if (sqlite3_bind_text(m_token->stmt, 1, key.c_str(), key.length(), NULL))
+        {
+            spdlog::error("{}:{} Fail to build prepared statment: {}", __FILE__, __LINE__,
+                sqlite3_errmsg(m_token->db));
+            goto exit;
+        }
+
+        if (sqlite3_step(m_token->stmt) == SQLITE_ROW)
+        {
+            exitCode = sqlite3_column_int(m_token->stmt, 0);
+            const char *data = static_cast<const char *>(
+                sqlite3_column_blob(m_token->stmt, 1));
+            std::string saved(data ? data : "", sqlite3_column_bytes(m_token->stmt, 1));
+            if (saved != material)
+            {
+                // another task with the same hash, run this one
+                spdlog::warn("{}:{} Result cache collision for task {}",
+                    __FILE__, __LINE__, id);
+                goto exit;
+            }
+
+            ret = 0;
+        }
+
+exit:
+
+        UNUSED(sqlite3_finalize(m_token->stmt));
+        m_token->stmt = nullptr;
+        if (ret)
+        {
+            return ret;
+        }
+
+        // the key is hex digits only
+        if (execSQL("INSERT OR REPLACE INTO outputLog SELECT " +
+                    std::to_string(id) + ", output FROM resultCache WHERE key='" +
+                    key + "';"))
+        {
+            spdlog::error("{}:{} Fail to copy output log", __FILE__, __LINE__);
+        }
+    }
+
+    spdlog::info("{}:{} Task {} is finished from the result cache",
+        __FILE__, __LINE__, id);
+    markStarted();
+    std::unique_lock<std::mutex> lock(m_currentTaskMutex);
+    m_currentTask.exitCode = exitCode;
+    m_currentTask.cached = true;
+    return 0;
+}
+
+void SQLiteQueue::saveResult(const std::string &key, const std::string &material)
+{
+    i32 exitCode(0);
+    if (m_process->exitCode(exitCode))
+    {
+        return;
+    }
+
+    std::string output;
+    m_process->outputLog(output);
+
+    std::unique_lock<std::mutex> lock(m_token->mutex);
+    i64 now = static_cast<i64>(time(nullptr));
+    if (sqlite3_prepare_v2(m_token->db,
+        "INSERT OR REPLACE INTO outputLog VALUES(?,?);", 45,
+        &m_token->stmt, NULL) ||
+        sqlite3_bind_int(m_token->stmt, 1, m_currentTask.ID) ||
+        sqlite3_bind_blob(m_token->stmt, 2, output.data(), output.size(), NULL) ||
+        sqlite3_step(m_token->stmt) != SQLITE_DONE)
+    {
+        spdlog::error("{}:{} Fail to save output log: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+    }
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+
+    // a failed or timed out run may be a transient error
+    if (exitCode || m_currentTask.timedOut)
+    {
+        return;
+    }
+
+    if (sqlite3_prepare_v2(m_token->db,
+        "INSERT OR REPLACE INTO resultCache VALUES(?,?,?,?,?);", 53,
+        &m_token->stmt, NULL) ||
+        sqlite3_bind_text(m_token->stmt, 1, key.c_str(), key.length(), NULL) ||
+        sqlite3_bind_int(m_token->stmt, 2, exitCode) ||
+        sqlite3_bind_blob(m_token->stmt, 3, output.data(), output.size(), NULL) ||
+        sqlite3_bind_int64(m_token->stmt, 4, now) ||
+        sqlite3_bind_blob(m_token->stmt, 5, material.data(), material.size(), NULL) ||
+        sqlite3_step(m_token->stmt) != SQLITE_DONE)
+    {
+        spdlog::error("{}:{} Fail to save result: {}", __FILE__, __LINE__,
+            sqlite3_errmsg(m_token->db));
+    }
+
+    UNUSED(sqlite3_finalize(m_token->stmt));
+    m_token->stmt = nullptr;
+}
+
+bool SQLiteQueue::shouldRetry(const Proc::Task &task)
+{
+    // every first run earns a part of a retry, so retries stay a bounded
+    // share of the load when every task of the queue fails
+    if (!task.attempt)
+    {
+        m_retryTokens = std::min(m_retryTokens + FF_RETRY_BUDGET_PERCENT / 100.0,
+                                 static_cast<double>(FF_RETRY_BUDGET_MAX));
+    }
+
+    if (task.attempt >= task.maxRetries)
+    {
+        return false;
+    }
+
+    if (m_retryTokens < 1)
+    {
+        spdlog::warn("{}:{} Retry budget is exhausted, task {} is not retried",
+            __FILE__, __LINE__, task.ID);
+        return false;
+    }
+
+    m_retryTokens -= 1;
+    return true;
+}
+
+i64 SQLiteQueue::retryDelay(const Proc::Task &task)
+{
+    if (task.backoff <= 0)
+    {
+        return 0;
+    }
+
+    // a per task max may be above the server default
+    i64 max = (task.backoffMax > 0) ? task.backoffMax : FF_RETRY_MAX_BACKOFF;
+    i64 delay = task.backoff;
+    for (i32 i = 0; i < task.attempt && delay < max; ++i)
+    {
+        delay *= 2;
+    }
+
+    delay = std::min(delay, max);
+
+    // half fixed, half random, so the tasks failed together do not
+    // come back together
+    static thread_local std::minstd_rand engine(std::random_device{}());
+    std::uniform_int_distribution<i64> dist(0, delay / 2);
+    return delay - delay / 2 + dist(engine);
 }
 
 void SQLiteQueue::stopImpl()
@@ -1171,6 +3981,7 @@ void SQLiteQueue::stopImpl()
     }
 
     m_start.store(false, std::memory_order_relaxed);
+    Scheduler::cancel(this);
     m_process->stop();
     m_isRunning.store(false, std::memory_order_relaxed);
 }
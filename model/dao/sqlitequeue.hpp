@@ -25,9 +25,16 @@
 #define _MODEL_DAO_SQLITEQUEUE_HPP_
 
 #include <atomic>
+#include <condition_variable>
+#include <map>
 #include <mutex>
-#include <thread>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
+#include "model/executor.hpp"
+#include "model/lrucache.hpp"
 #include "sqliteconnect.hpp"
 #include "iqueue.hpp"
 
@@ -37,6 +44,55 @@ namespace Model
 namespace DAO
 {
 
+// a caller of waitTasks() or waitTasksAsync()
+class TaskWaiter
+{
+public:
+
+    std::vector<i32> tasks;
+
+    bool any = false;
+
+    // the tasks which are finished or removed
+    std::unordered_set<i32> finished;
+
+    std::condition_variable cond;
+
+    // waitTasksAsync() only
+    u64 handle = 0;
+
+    std::function<void (u8, std::vector<Proc::Task> &)> onDone;
+
+    u64 timer = 0;
+
+    bool isReady() const;
+};
+
+// a row of table "historyRollup", the tasks of one execName which have
+// ended within the same minute
+class HistoryRollup
+{
+public:
+
+    u64 count = 0;
+
+    u64 succeeded = 0;
+
+    u64 cpuTime = 0;
+
+    u64 maxRunTime = 0;
+
+    // bucket of Metrics::Histogram to count of the run times
+    std::map<size_t, u64> runTime;
+
+    void add(const Proc::Task &);
+
+    // "bucket:count,bucket:count", only the buckets which are not empty
+    std::string encode() const;
+
+    void decode(const std::string &);
+};
+
 class SQLiteQueue: public IQueue
 {
 public:
@@ -59,16 +115,44 @@ public:
     virtual u8 finishedDetails(const int id,
                                Proc::Task &out) override;
 
+    virtual u8 listScheduled(std::vector<int> &out) override;
+
+    virtual u8 scheduledDetails(const int id,
+                                Proc::Task &out) override;
+
+    virtual u8 listBlocked(std::vector<int> &out) override;
+
+    virtual u8 blockedDetails(const int id,
+                              Proc::Task &out) override;
+
     virtual u8 clearPending() override;
 
     virtual u8 clearFinished() override;
 
+    virtual u8 taskHistory(const int id,
+                           std::vector<Proc::Attempt> &out) override;
+
+    virtual u8 historyStats(const HistoryFilter &in, HistoryStats &out) override;
+
+    virtual u8 finishedOutput(const int id, std::string &out) override;
+
+    virtual u8 waitTasks(const std::vector<int> &ids,
+                         const bool any,
+                         const i64 deadline,
+                         const std::function<bool ()> &keepWaiting,
+                         std::vector<Proc::Task> &out) override;
+
+    virtual u8 watch(const std::function<bool ()> &keepWaiting,
+                     const std::function<bool (const Event &)> &onEvent) override;
+
     virtual u8 currentTask(Proc::Task &out) override;
 
     virtual u8 addTask(Proc::Task &in) override;
 
     virtual u8 removeTask(const i32 in) override;
 
+    virtual u8 setPriority(const i32 id, const i32 priority) override;
+
     virtual bool isRunning() const override;
 
     virtual void readCurrentOutput(std::vector<std::string> &out) override;
@@ -77,10 +161,44 @@ public:
 
     virtual void stop() override;
 
+    // server side only, forwarded to the process of this queue
+    u8 setAffinity(const Proc::Affinity &in);
+
+    // finish a task which has succeeded with the same definition and
+    // inputs before without running it again
+    void setResultCache(const bool in);
+
+    // server side only, waitTasks() without blocking: "onDone" is called
+    // once, from the thread which finishes the last task, from the timer
+    // thread at the deadline or from cancelWait(), return the handle for
+    // cancelWait()
+    u64 waitTasksAsync(const std::vector<int> &ids,
+                       const bool any,
+                       const i64 deadline,
+                       const std::function<void (u8, std::vector<Proc::Task> &)> &onDone);
+
+    // "onDone" is called with ErrCode_DEADLINE_EXCEEDED if it is not yet
+    void cancelWait(const u64 handle);
+
+    // server side only, for subscribers which must not block
+    EventBus &eventBus();
+
+    // server side only, "name" is not set
+    u8 stats(QueueStats &out);
+
+    // called by SQLiteQueueList::renameQueue(), the refs to the tasks of
+    // this queue use the new name from now on
+    u8 rename(const std::string &name);
+
 private:
 
     std::shared_ptr<SQLiteToken> m_token;
 
+    // guards m_name, which changes with rename()
+    std::mutex m_nameMutex;
+
+    std::string m_name;
+
     std::mutex m_currentTaskMutex;
 
     Proc::Task m_currentTask;
@@ -89,12 +207,121 @@ private:
 
     std::atomic<bool> m_start;
 
-    std::jthread m_thread;
+    // stopped by the user, due scheduled tasks do not start the queue
+    std::atomic<bool> m_isStopped;
+
+    std::atomic<bool> m_useResultCache;
+
+    // the loop is a coroutine on Executor, m_looping is true while it is
+    // alive (also while it is winding down after stop())
+    std::mutex m_loopMutex;
+
+    std::condition_variable m_loopCond;
+
+    bool m_looping;
+
+    std::mutex m_timerMutex;
+
+    std::mutex m_promoteMutex;
+
+    // guarded by m_promoteMutex
+    bool m_isClosing;
+
+    // retry budget, guarded by m_token->mutex
+    double m_retryTokens;
+
+    // ID in table "scheduled" to timer id
+    std::unordered_map<i32, u64> m_timers;
+
+    // recent idempotency keys to (ID, createdAt) in front of table "dedup",
+    // guarded by m_token->mutex
+    LRUCache<std::string, std::pair<i32, i64>> m_dedupCache;
+
+    // timeouts of the running task
+    std::mutex m_watchdogMutex;
+
+    // guarded by m_watchdogMutex, timer id 0 for none
+    bool m_watchdogArmed;
+
+    bool m_timedOut;
+
+    u64 m_timeoutTimer;
+
+    u64 m_idleTimer;
+
+    u64 m_killTimer;
+
+    std::mutex m_waitMutex;
+
+    // task ID to the callers of waitTasks() waiting for it,
+    // guarded by m_waitMutex
+    std::unordered_map<i32, std::vector<TaskWaiter *>> m_waiters;
+
+    // handle to the waiters of waitTasksAsync(), guarded by m_waitMutex
+    std::unordered_map<u64, std::shared_ptr<TaskWaiter>> m_asyncWaiters;
+
+    u64 m_lastWait;
+
+    EventBus m_events;
+
+    // counters of stats(), changed with the tables under m_token->mutex
+    // and loaded from them by loadStats()
+    std::atomic<u64> m_pendingCount;
+
+    std::atomic<u64> m_finishedCount;
+
+    std::atomic<u64> m_failedCount;
+
+    // enqueue time of the oldest pending task, 0 for none,
+    // -1 if it is to be looked up again
+    std::atomic<i64> m_oldestPending;
+
+    // finished tasks with a recorded run, and the sum of their run time
+    // in milliseconds, for the average of stats()
+    std::atomic<u64> m_timedCount;
+
+    std::atomic<u64> m_runTimeTotal;
 
     u8 connectToDB(const std::string &);
 
+    u8 execSQL(const std::string &);
+
+    // m_token->mutex must be held, the counters changed within the
+    // transaction are loaded again
+    void rollback();
+
     u8 createTable(const std::string &);
 
+    u8 createIndex();
+
+    // m_token->mutex must be held
+    u8 loadStats();
+
+    // m_token->mutex must be held
+    u8 loadOldestPending();
+
+    // the end time of table "history" was in seconds before
+    u8 migrateHistory();
+
+    // create table "historyRollup", filled from "done" if it is new
+    u8 createRollup();
+
+    // add an attempt of a task to table "history"
+    u8 addHistory(const Proc::Task &, const i64 endTimeMs);
+
+    // add a task which has moved to "done" to its row of the rollup
+    u8 addToRollup(const Proc::Task &);
+
+    // ErrCode_NOT_FOUND if there is no row yet
+    u8 readRollup(const i64, const std::string &, HistoryRollup &);
+
+    u8 writeRollup(const i64, const std::string &, const HistoryRollup &);
+
+    // ErrCode_NOT_FOUND if the key is not used within FF_DEDUP_WINDOW
+    u8 findDedupKey(const std::string &, const i64, i32 &);
+
+    u8 addDedupKey(const std::string &, const i32, const i64);
+
     u8 verifyTable(const std::string &);
 
     u8 verifyID();
@@ -109,20 +336,97 @@ private:
 
     u8 addTaskToTable(const std::string &, const Proc::Task &);
 
+    // read a row selected with dbColumnList() from m_token->stmt
+    void readTask(Proc::Task &);
+
+    void armTimer(const i32, const i64);
+
+    void cancelTimer(const i32);
+
+    void cancelTimers();
+
+    u8 loadScheduled();
+
+    Proc::TaskRef taskRef(const i32);
+
+    // for DAG, one of TaskState_*
+    u8 taskState(const i32);
+
+    // move a blocked task to "pending" (or "scheduled" if it is not due),
+    // or to "done" as failed if one of its parents has failed
+    void unblock(const i32, const bool);
+
+    void loadBlocked();
+
+    // the task is in "done" or removed, wake up its waiters
+    void notifyWaiters(const i32);
+
+    // register the waiter for its tasks and mark the finished ones,
+    // ErrCode_NOT_FOUND if one of them does not exist
+    u8 addWaiter(TaskWaiter &);
+
+    // m_waitMutex must be held
+    void removeWaiter(TaskWaiter &);
+
+    void finishedTasks(const TaskWaiter &, std::vector<Proc::Task> &);
+
+    // call "onDone" of the async waiter if it is still registered
+    void finishWait(const u64, const u8, const bool);
+
+    // move a due task from "scheduled" to "pending"
+    void promote(const i32);
+
+    u8 startImpl();
+
     u8 removeTaskFromPending(const i32, const bool);
 
     void splitString(const std::string &, std::vector<std::string> &);
 
     std::string concatString(const std::vector<std::string> &);
 
+    // "queue:ID" joined like concatString()
+    void splitRefs(const std::string &, std::vector<Proc::TaskRef> &);
+
+    std::string concatRefs(const std::vector<Proc::TaskRef> &);
+
     u8 getID(i32 &);
 
-    void mainLoop();
+    Executor::Job mainLoop();
+
+    // return false and mark the loop as gone if it is not started again
+    bool keepLooping();
 
     u8 mainLoopInit();
 
+    // set the start time of the current task and how long it has waited
+    void markStarted();
+
     void mainLoopFin();
 
+    // return 0 if the current task is in "done"
+    u8 moveToDone(i32 &, bool &);
+
+    void armWatchdog(const Proc::Task &);
+
+    // return true if the task was terminated by the watchdog
+    bool disarmWatchdog();
+
+    void checkIdleOutput(const i32, const i32);
+
+    // m_watchdogMutex must be held
+    void terminateTask(const i32);
+
+    // return 0 if the current task is finished from the result cache,
+    // the key material of the hit must match, not only the key
+    u8 finishFromCache(const std::string &, const std::string &);
+
+    void saveResult(const std::string &, const std::string &);
+
+    bool shouldRetry(const Proc::Task &);
+
+    // seconds to wait before the next attempt
+    i64 retryDelay(const Proc::Task &);
+
     void stopImpl();
 
 }; // end class DirToken
@@ -27,24 +27,20 @@
 #include "spdlog/spdlog.h"
 
 #include "model/errmsg.hpp"
+#include "model/proc/procfactory.hpp"
 
 #include "sqlitequeue.hpp"
 #include "sqlitequeuelist.hpp"
 #include "dirutils.hpp"
 
-#if (defined _WIN32)
-#include "model/proc/winproc.hpp"
-#elif (defined __linux__)
-#include "model/proc/linuxproc.hpp"
-#endif
-
 namespace Model
 {
 
 namespace DAO
 {
 
-SQLiteQueueList::SQLiteQueueList()
+SQLiteQueueList::SQLiteQueueList() :
+    m_queueList(std::make_shared<const QueueMap>())
 {}
 
 SQLiteQueueList::~SQLiteQueueList()
@@ -68,7 +64,7 @@ SQLiteQueueList::init(std::shared_ptr<IConnect> &connect)
     // create queue
     std::error_code ec;
     std::string fileName;
-    m_queueList.clear();
+    m_queueList.store(std::make_shared<const QueueMap>());
     m_conn = connect;
     for (const auto& entry : std::filesystem::directory_iterator(connect->targetPath()))
     {
@@ -105,7 +101,7 @@ SQLiteQueueList::init(std::shared_ptr<IConnect> &connect)
             spdlog::error("{}:{} Fail to create queue: {}", __FILE__, __LINE__,
                           name);
             m_conn = nullptr;
-            m_queueList.clear();
+            m_queueList.store(std::make_shared<const QueueMap>());
             return ErrCode_OS_ERROR;
         }
     }
@@ -115,11 +111,16 @@ SQLiteQueueList::init(std::shared_ptr<IConnect> &connect)
 
 u8 SQLiteQueueList::createQueue(const std::string &name)
 {
-#ifdef _WIN32
-    Proc::WinProc *proc = new (std::nothrow) Proc::WinProc();
-#else
-    Proc::LinuxProc *proc = new (std::nothrow) Proc::LinuxProc();
-#endif
+    // held until the queue is added, the database of an existing queue
+    // must not be opened twice
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+    if (m_queueList.load()->contains(name))
+    {
+        spdlog::error("{}:{} Queue already exists: {}", __FILE__, __LINE__, name);
+        return ErrCode_ALREADY_EXISTS;
+    }
+
+    Proc::IProc *proc = Proc::Factory::create();
     if (!proc)
     {
         spdlog::error("{}:{} Fail to allocate memory", __FILE__, __LINE__);
@@ -149,16 +150,20 @@ u8 SQLiteQueueList::createQueue(const std::string &name)
         return ErrCode_OS_ERROR;
     }
 
-    m_queueList[name] = std::shared_ptr<IQueue>(queue);
+    std::shared_ptr<IQueue> queuePtr = std::shared_ptr<IQueue>(queue);
+    auto next = std::make_shared<QueueMap>(*m_queueList.load());
+    (*next)[name] = queuePtr;
+    m_queueList.store(next);
     return ErrCode_OK;
 }
 
 u8 SQLiteQueueList::listQueue(std::vector<std::string> &out)
 {
+    auto queueList = snapshot();
     out.clear();
-    out.reserve(m_queueList.size());
-    for (auto it = m_queueList.begin();
-         it != m_queueList.end();
+    out.reserve(queueList->size());
+    for (auto it = queueList->begin();
+         it != queueList->end();
          ++it)
     {
         out.push_back(it->first);
@@ -175,13 +180,16 @@ u8 SQLiteQueueList::listQueue(std::vector<std::string> &out)
 
 u8 SQLiteQueueList::deleteQueue(const std::string &name)
 {
-    if (!m_queueList.erase(name))
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+    auto next = std::make_shared<QueueMap>(*m_queueList.load());
+    if (!next->erase(name))
     {
         spdlog::error("{}:{} No such queue: {}", __FILE__, __LINE__,
             name);
         return ErrCode_NOT_FOUND;
     }
 
+    m_queueList.store(next);
     return ErrCode_OK;
 }
 
@@ -189,14 +197,38 @@ u8
 SQLiteQueueList::renameQueue(const std::string &oldName,
                              const std::string &newName)
 {
-    for (auto &it : m_queueList)
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+    auto next = std::make_shared<QueueMap>(*m_queueList.load());
+    auto it = next->find(oldName);
+    if (it != next->end())
     {
-        if (it.first == oldName)
+        if (next->contains(newName))
         {
-            m_queueList[newName] = it.second;
-            m_queueList.erase(oldName);
-            return ErrCode_OK;
+            spdlog::error("{}:{} Queue already exists: {}", __FILE__, __LINE__,
+                newName);
+            return ErrCode_ALREADY_EXISTS;
         }
+
+        std::shared_ptr<IQueue> queue = it->second;
+
+        // the dependency graph knows the queue by its name as well
+        auto sqliteQueue = std::dynamic_pointer_cast<SQLiteQueue>(queue);
+        if (sqliteQueue == nullptr)
+        {
+            spdlog::error("{}:{} Invalid queue: {}", __FILE__, __LINE__, oldName);
+            return ErrCode_OS_ERROR;
+        }
+
+        u8 code = sqliteQueue->rename(newName);
+        if (code)
+        {
+            return code;
+        }
+
+        next->erase(it);
+        (*next)[newName] = queue;
+        m_queueList.store(next);
+        return ErrCode_OK;
     }
 
     spdlog::error("{}:{} No such queue: {}", __FILE__, __LINE__,
@@ -205,12 +237,85 @@ SQLiteQueueList::renameQueue(const std::string &oldName,
 }
 
 std::shared_ptr<IQueue>
-SQLiteQueueList::getQueue(const std::string &name)
+SQLiteQueueList::getQueue(std::string_view name)
 {
-    auto it = m_queueList.find(name);
-    if (it == m_queueList.end()) return nullptr;
+    auto queueList = snapshot();
+    auto it = queueList->find(name);
+    if (it == queueList->end()) return nullptr;
     return it->second;
+}
+
+u8 SQLiteQueueList::queueShare(const std::string &name, Scheduler::Share &out)
+{
+    auto queueList = snapshot();
+    auto it = queueList->find(name);
+    if (it == queueList->end())
+    {
+        spdlog::error("{}:{} No such queue: {}", __FILE__, __LINE__, name);
+        return ErrCode_NOT_FOUND;
+    }
+
+    // the scheduler knows the queue by its SQLiteQueue address
+    auto queue = std::dynamic_pointer_cast<SQLiteQueue>(it->second);
+    if (queue == nullptr || Scheduler::share(queue.get(), out))
+    {
+        spdlog::error("{}:{} Fail to get share of queue: {}", __FILE__, __LINE__,
+                      name);
+        return ErrCode_OS_ERROR;
+    }
+
+    return ErrCode_OK;
+}
 
+u8 SQLiteQueueList::queueStats(const std::string &name, QueueStats &out)
+{
+    auto queueList = snapshot();
+    auto it = queueList->find(name);
+    if (it == queueList->end())
+    {
+        spdlog::error("{}:{} No such queue: {}", __FILE__, __LINE__, name);
+        return ErrCode_NOT_FOUND;
+    }
+
+    auto queue = std::dynamic_pointer_cast<SQLiteQueue>(it->second);
+    if (queue == nullptr || queue->stats(out))
+    {
+        spdlog::error("{}:{} Fail to get stats of queue: {}", __FILE__, __LINE__,
+                      name);
+        return ErrCode_OS_ERROR;
+    }
+
+    out.name = name;
+    return ErrCode_OK;
+}
+
+u8 SQLiteQueueList::allQueueStats(std::vector<QueueStats> &out)
+{
+    auto queueList = snapshot();
+    out.clear();
+    out.reserve(queueList->size());
+    for (auto it = queueList->begin(); it != queueList->end(); ++it)
+    {
+        auto queue = std::dynamic_pointer_cast<SQLiteQueue>(it->second);
+        QueueStats stats;
+        if (queue == nullptr || queue->stats(stats))
+        {
+            spdlog::error("{}:{} Fail to get stats of queue: {}", __FILE__, __LINE__,
+                          it->first);
+            return ErrCode_OS_ERROR;
+        }
+
+        stats.name = it->first;
+        out.push_back(std::move(stats));
+    }
+
+    return ErrCode_OK;
+}
+
+// private member functions
+std::shared_ptr<const SQLiteQueueList::QueueMap> SQLiteQueueList::snapshot() const
+{
+    return m_queueList.load(std::memory_order_acquire);
 }
 
 } // end namespace DAO
@@ -24,6 +24,9 @@
 #ifndef _MODEL_DAO_SQLITEQUEUELIST_HPP_
 #define _MODEL_DAO_SQLITEQUEUELIST_HPP_
 
+#include <atomic>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
 
 #include "iqueuelist.hpp"
@@ -54,12 +57,41 @@ public:
                    const std::string &newName) override;
 
     std::shared_ptr<IQueue>
-    getQueue(const std::string &name) override;
+    getQueue(std::string_view name) override;
+
+    u8 queueShare(const std::string &name, Scheduler::Share &out) override;
+
+    u8 queueStats(const std::string &name, QueueStats &out) override;
+
+    u8 allQueueStats(std::vector<QueueStats> &out) override;
 
 private:
 
-    std::unordered_map<std::string,
-    std::shared_ptr<IQueue>> m_queueList;
+    // lets the map be searched by std::string_view without a copy
+    class NameHash
+    {
+    public:
+
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const
+        {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    typedef std::unordered_map<std::string, std::shared_ptr<IQueue>,
+                               NameHash, std::equal_to<>> QueueMap;
+
+    // read-copy-update: every rpc looks up its queue in the current
+    // snapshot without taking a lock, create, delete and rename copy the
+    // map under m_writeMutex and publish the copy. A deleted queue lives
+    // until the last reader holding it is done.
+    std::atomic<std::shared_ptr<const QueueMap>> m_queueList;
+
+    std::mutex m_writeMutex;
+
+    std::shared_ptr<const QueueMap> snapshot() const;
 };
 
 } // end namespace DAO
@@ -41,6 +41,7 @@ void init()
     table[ErrCode_ALREADY_EXISTS] = grpc::StatusCode::ALREADY_EXISTS;
     table[ErrCode_OUT_OF_RANGE] = grpc::StatusCode::OUT_OF_RANGE;
     table[ErrCode_OS_ERROR] = grpc::StatusCode::INTERNAL;
+    table[ErrCode_DEADLINE_EXCEEDED] = grpc::StatusCode::DEADLINE_EXCEEDED;
 }
 
 grpc::Status toGRPCStatus(u8 code, const std::string &msg)
@@ -39,6 +39,7 @@
 #define ErrCode_ALREADY_EXISTS   3
 #define ErrCode_OUT_OF_RANGE     4
 #define ErrCode_OS_ERROR         5
+#define ErrCode_DEADLINE_EXCEEDED 6
 
 namespace Model
 {
@@ -0,0 +1,136 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <ctime>
+
+#include "config.h"
+
+#include "eventbus.hpp"
+
+namespace Model
+{
+
+Event::Event() :
+    type(EventType_RESYNC),
+    ID(0),
+    exitCode(0),
+    isSuccess(false),
+    time(0)
+{}
+
+Subscription::Subscription(size_t capacity,
+                           const std::function<void ()> &onPush) :
+    m_onPush(onPush),
+    m_capacity(capacity ? capacity : 1),
+    m_isDropped(false)
+{}
+
+void Subscription::push(const Event &in)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_events.size() >= m_capacity)
+        {
+            m_events.pop_front();
+            m_isDropped = true;
+        }
+
+        m_events.push_back(in);
+    }
+
+    m_cond.notify_one();
+    if (m_onPush)
+    {
+        m_onPush();
+    }
+}
+
+u8 Subscription::pop(Event &out, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_cond.wait_for(lock, timeout, [this]()
+    {
+        return !m_events.empty();
+    }))
+    {
+        return 1;
+    }
+
+    popLocked(out);
+    return 0;
+}
+
+u8 Subscription::tryPop(Event &out)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_events.empty())
+    {
+        return 1;
+    }
+
+    popLocked(out);
+    return 0;
+}
+
+void Subscription::popLocked(Event &out)
+{
+    if (m_isDropped)
+    {
+        // the marker takes no room, the subscriber is told before it sees
+        // the first event after the gap
+        m_isDropped = false;
+        out = Event();
+        out.time = static_cast<i64>(::time(nullptr));
+        return;
+    }
+
+    out = m_events.front();
+    m_events.pop_front();
+}
+
+std::shared_ptr<Subscription>
+EventBus::subscribe(const std::function<void ()> &onPush)
+{
+    auto ret = std::make_shared<Subscription>(FF_WATCH_QUEUE_SIZE, onPush);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_subscriptions.push_back(ret);
+    return ret;
+}
+
+void EventBus::unsubscribe(const std::shared_ptr<Subscription> &in)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_subscriptions.remove(in);
+}
+
+void EventBus::publish(Event in)
+{
+    in.time = static_cast<i64>(::time(nullptr));
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it)
+    {
+        (*it)->push(in);
+    }
+}
+
+} // end namespace Model
@@ -0,0 +1,134 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _MODEL_EVENTBUS_HPP_
+#define _MODEL_EVENTBUS_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "controller/global/defines.hpp"
+
+// some events are dropped, the subscriber should read the lists again
+#define EventType_RESYNC           0
+#define EventType_ADDED            1
+#define EventType_STARTED          2
+#define EventType_FINISHED         3
+#define EventType_REMOVED          4
+#define EventType_PENDING_CLEARED  5
+#define EventType_FINISHED_CLEARED 6
+
+namespace Model
+{
+
+class Event
+{
+public:
+
+    Event();
+
+    // one of EventType_*
+    u8 type;
+
+    // 0 for the events not about a single task
+    i32 ID;
+
+    // EventType_FINISHED only
+    i32 exitCode;
+
+    bool isSuccess;
+
+    // unix time in seconds
+    i64 time;
+
+}; // end class Event
+
+// Bounded queue of the events for one subscriber. When it is full the oldest
+// event is dropped and the next pop() returns EventType_RESYNC first.
+class Subscription
+{
+public:
+
+    // "onPush" is called after every push with no lock of the subscription
+    // held, for the subscribers which cannot block in pop()
+    Subscription(size_t capacity, const std::function<void ()> &onPush);
+
+    void push(const Event &in);
+
+    // return 1 if nothing is queued until "timeout"
+    u8 pop(Event &out, std::chrono::milliseconds timeout);
+
+    // return 1 if nothing is queued
+    u8 tryPop(Event &out);
+
+private:
+
+    const std::function<void ()> m_onPush;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_cond;
+
+    std::deque<Event> m_events;
+
+    size_t m_capacity;
+
+    bool m_isDropped;
+
+    // m_mutex must be held and m_events must not be empty
+    void popLocked(Event &out);
+
+}; // end class Subscription
+
+// Fan out of the events of a queue. publish() never blocks on a slow
+// subscriber, so it may be called with the locks of the queue held.
+class EventBus
+{
+public:
+
+    std::shared_ptr<Subscription>
+    subscribe(const std::function<void ()> &onPush = nullptr);
+
+    // after return "onPush" of the subscription is neither running nor
+    // called again
+    void unsubscribe(const std::shared_ptr<Subscription> &in);
+
+    // "time" is filled in here
+    void publish(Event in);
+
+private:
+
+    std::mutex m_mutex;
+
+    std::list<std::shared_ptr<Subscription>> m_subscriptions;
+
+}; // end class EventBus
+
+} // end namespace Model
+
+#endif // _MODEL_EVENTBUS_HPP_
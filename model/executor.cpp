@@ -0,0 +1,283 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <config.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "executor.hpp"
+
+namespace Model
+{
+
+namespace Executor
+{
+
+using TimePoint = std::chrono::steady_clock::time_point;
+
+static std::mutex mutex;
+
+static std::condition_variable cond;
+
+// notified when a timer callback has returned
+static std::condition_variable timerCond;
+
+static std::vector<std::jthread> threads;
+
+static bool keepRunning(false);
+
+static std::deque<std::function<void ()>> jobs;
+
+static u64 nextID(1);
+
+// ordered by deadline, then by id
+static std::map<std::pair<TimePoint, u64>, std::function<void ()>> timers;
+
+static std::unordered_map<u64, TimePoint> deadlines;
+
+// ids of the timer callbacks which are running
+static std::unordered_set<u64> firing;
+
+static void run(std::function<void ()> &job)
+{
+    try
+    {
+        job();
+    }
+    catch (...)
+    {
+        spdlog::error("{}:{} Executor job throws", __FILE__, __LINE__);
+    }
+}
+
+static void mainLoop()
+{
+    std::function<void ()> job;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (keepRunning)
+    {
+        // due timers first, a flood of jobs must not hold them back
+        if (!timers.empty() &&
+            timers.begin()->first.first <= std::chrono::steady_clock::now())
+        {
+            auto it = timers.begin();
+            u64 id = it->first.second;
+            job = std::move(it->second);
+            timers.erase(it);
+            deadlines.erase(id);
+            firing.insert(id);
+
+            lock.unlock();
+            run(job);
+            job = nullptr;
+            lock.lock();
+
+            firing.erase(id);
+            timerCond.notify_all();
+            continue;
+        }
+
+        if (!jobs.empty())
+        {
+            job = std::move(jobs.front());
+            jobs.pop_front();
+
+            lock.unlock();
+            run(job);
+            job = nullptr;
+            lock.lock();
+            continue;
+        }
+
+        if (timers.empty())
+        {
+            cond.wait(lock);
+            continue;
+        }
+
+        // a copy, the timer may be cancelled while waiting
+        TimePoint next = timers.begin()->first.first;
+        cond.wait_until(lock, next);
+    }
+}
+
+u8 init()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (keepRunning)
+    {
+        spdlog::error("{}:{} Executor is running", __FILE__, __LINE__);
+        return 1;
+    }
+
+    keepRunning = true;
+    try
+    {
+        for (u32 i = 0; i < FF_EXECUTOR_THREADS; ++i)
+        {
+            threads.push_back(std::jthread(mainLoop));
+        }
+    }
+    catch (...)
+    {
+        spdlog::error("{}:{} Fail to start executor threads", __FILE__, __LINE__);
+        keepRunning = false;
+        cond.notify_all();
+        lock.unlock();
+        threads.clear();
+        return 1;
+    }
+
+    spdlog::info("{}:{} Executor threads: {}", __FILE__, __LINE__, threads.size());
+    return 0;
+}
+
+void fin()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        keepRunning = false;
+        cond.notify_all();
+    }
+
+    // joined by jthread
+    threads.clear();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!jobs.empty() || !timers.empty())
+    {
+        spdlog::debug("{}:{} Drop {} jobs and {} timers", __FILE__, __LINE__,
+                      jobs.size(), timers.size());
+    }
+
+    jobs.clear();
+    timers.clear();
+    deadlines.clear();
+}
+
+void post(std::function<void ()> job)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs.push_back(std::move(job));
+    cond.notify_one();
+}
+
+u64 at(TimePoint when, std::function<void ()> cb)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    u64 id = nextID++;
+    bool isFirst = timers.empty() || when < timers.begin()->first.first;
+    timers.emplace(std::make_pair(when, id), std::move(cb));
+    deadlines.emplace(id, when);
+
+    // the thread waiting for the first timer has to wait for less
+    if (isFirst)
+    {
+        cond.notify_one();
+    }
+
+    return id;
+}
+
+void cancel(u64 id)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = deadlines.find(id);
+    if (it != deadlines.end())
+    {
+        timers.erase(std::make_pair(it->second, id));
+        deadlines.erase(it);
+        return;
+    }
+
+    timerCond.wait(lock, [id]() { return !firing.contains(id); });
+}
+
+Job Job::promise_type::get_return_object() noexcept
+{
+    return Job();
+}
+
+void Job::promise_type::unhandled_exception() noexcept
+{
+    // the loops do not throw, a frame left half way cannot be resumed
+    spdlog::critical("{}:{} Coroutine throws", __FILE__, __LINE__);
+    std::terminate();
+}
+
+Sleep::Sleep(std::chrono::steady_clock::duration delay) :
+    m_delay(delay)
+{}
+
+bool Sleep::await_ready() const noexcept
+{
+    return m_delay.count() <= 0;
+}
+
+void Sleep::await_suspend(std::coroutine_handle<> handle)
+{
+    UNUSED(at(std::chrono::steady_clock::now() + m_delay,
+              [handle]() { handle.resume(); }));
+}
+
+Callback::Callback(std::function<void (Done)> start) :
+    m_start(std::move(start)),
+    m_code(0)
+{}
+
+bool Callback::await_ready() const noexcept
+{
+    return false;
+}
+
+void Callback::await_suspend(std::coroutine_handle<> handle)
+{
+    // "done" may be called before "start" returns, the coroutine may then
+    // be running (and this awaiter gone) on another thread already
+    std::function<void (Done)> start = std::move(m_start);
+    start([this, handle](u8 code)
+    {
+        m_code = code;
+        post([handle]() { handle.resume(); });
+    });
+}
+
+u8 Callback::await_resume() const noexcept
+{
+    return m_code;
+}
+
+} // end namespace Executor
+
+} // end namespace Model
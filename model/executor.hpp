@@ -0,0 +1,221 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _MODEL_EXECUTOR_HPP_
+#define _MODEL_EXECUTOR_HPP_
+
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+// Server wide pool of FF_EXECUTOR_THREADS threads running the queue loops as
+// C++20 coroutines. A loop which waits (for a slot, for its task to exit, for
+// a timer) is a suspended coroutine and costs neither a thread nor polling,
+// the one which wakes it up only posts it back to the pool.
+namespace Executor
+{
+
+// start the threads, jobs posted before are kept
+u8 init();
+
+// jobs which are not started yet are dropped
+void fin();
+
+// run "job" on one of the threads
+void post(std::function<void ()> job);
+
+// run "cb" on one of the threads once "when" has passed,
+// return the timer id for cancel(), never 0
+u64 at(std::chrono::steady_clock::time_point when, std::function<void ()> cb);
+
+// after return the callback is neither pending nor running,
+// must not be called from the callback of the same timer
+void cancel(u64 id);
+
+// a coroutine which is started on the pool and frees itself when it returns,
+// nobody waits for it
+class Job
+{
+public:
+
+    class promise_type
+    {
+    public:
+
+        Job get_return_object() noexcept;
+
+        auto initial_suspend() noexcept
+        {
+            class Schedule
+            {
+            public:
+
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> handle)
+                {
+                    post([handle]() { handle.resume(); });
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            return Schedule();
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept;
+    };
+};
+
+// co_await sleep(delay), continue on the pool after "delay"
+class Sleep
+{
+public:
+
+    explicit Sleep(std::chrono::steady_clock::duration delay);
+
+    bool await_ready() const noexcept;
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    void await_resume() const noexcept {}
+
+private:
+
+    std::chrono::steady_clock::duration m_delay;
+};
+
+inline Sleep sleep(std::chrono::steady_clock::duration delay)
+{
+    return Sleep(delay);
+}
+
+// co_await call(fn), run "fn" as a job of its own on the pool and continue
+// with its result, for the database operations of the loops so a loop is
+// never running them on the thread which has woken it up
+template <class F>
+class Call
+{
+public:
+
+    using Result = std::invoke_result_t<F &>;
+
+    explicit Call(F fn) :
+        m_fn(std::move(fn))
+    {}
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        post([this, handle]()
+        {
+            if constexpr (std::is_void_v<Result>)
+            {
+                m_fn();
+            }
+            else
+            {
+                m_result = m_fn();
+            }
+
+            handle.resume();
+        });
+    }
+
+    Result await_resume()
+    {
+        if constexpr (!std::is_void_v<Result>)
+        {
+            return std::move(m_result);
+        }
+    }
+
+private:
+
+    F m_fn;
+
+    std::conditional_t<std::is_void_v<Result>, char, Result> m_result{};
+};
+
+template <class F>
+Call<F> call(F fn)
+{
+    return Call<F>(std::move(fn));
+}
+
+// co_await callback(start), "start" hands the given function to something
+// which calls it once with a code, e.g. Scheduler::acquire(), the coroutine
+// continues on the pool with that code
+class Callback
+{
+public:
+
+    using Done = std::function<void (u8)>;
+
+    explicit Callback(std::function<void (Done)> start);
+
+    bool await_ready() const noexcept;
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    u8 await_resume() const noexcept;
+
+private:
+
+    std::function<void (Done)> m_start;
+
+    u8 m_code;
+};
+
+inline Callback callback(std::function<void (Callback::Done)> start)
+{
+    return Callback(std::move(start));
+}
+
+} // end namespace Executor
+
+} // end namespace Model
+
+#endif // _MODEL_EXECUTOR_HPP_
@@ -0,0 +1,122 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _MODEL_LRUCACHE_HPP_
+#define _MODEL_LRUCACHE_HPP_
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+// Bounded map which drops the least recently used entry when it is full.
+// Not thread safe.
+template<class Key, class Value>
+class LRUCache
+{
+public:
+
+    explicit LRUCache(size_t capacity) :
+        m_capacity(capacity)
+    {}
+
+    // return nullptr on miss, the pointer is valid until the next put()
+    Value *get(const Key &key)
+    {
+        auto it = m_map.find(key);
+        if (it == m_map.end())
+        {
+            return nullptr;
+        }
+
+        m_list.splice(m_list.begin(), m_list, it->second);
+        return &it->second->second;
+    }
+
+    void put(const Key &key, const Value &value)
+    {
+        if (!m_capacity)
+        {
+            return;
+        }
+
+        auto it = m_map.find(key);
+        if (it != m_map.end())
+        {
+            it->second->second = value;
+            m_list.splice(m_list.begin(), m_list, it->second);
+            return;
+        }
+
+        if (m_map.size() == m_capacity)
+        {
+            m_map.erase(m_list.back().first);
+            m_list.pop_back();
+        }
+
+        m_list.emplace_front(key, value);
+        m_map.emplace(key, m_list.begin());
+    }
+
+    void erase(const Key &key)
+    {
+        auto it = m_map.find(key);
+        if (it == m_map.end())
+        {
+            return;
+        }
+
+        m_list.erase(it->second);
+        m_map.erase(it);
+    }
+
+    void clear()
+    {
+        m_map.clear();
+        m_list.clear();
+    }
+
+    size_t size() const
+    {
+        return m_map.size();
+    }
+
+private:
+
+    size_t m_capacity;
+
+    // most recently used first
+    std::list<std::pair<Key, Value>> m_list;
+
+    std::unordered_map<Key,
+        typename std::list<std::pair<Key, Value>>::iterator> m_map;
+
+}; // end class LRUCache
+
+} // end namespace Model
+
+#endif // _MODEL_LRUCACHE_HPP_
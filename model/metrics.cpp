@@ -0,0 +1,307 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "fmt/format.h"
+
+#include "metrics.hpp"
+
+namespace Model
+{
+
+namespace Metrics
+{
+
+static std::mutex mutex;
+
+// key is name{labels}, the values are never removed
+static std::map<std::string, std::unique_ptr<Counter>> counters;
+
+static std::map<std::string, std::unique_ptr<Histogram>> histograms;
+
+static std::atomic<size_t> nextShard(0);
+
+static size_t shardIndex()
+{
+    thread_local size_t index =
+        nextShard.fetch_add(1, std::memory_order_relaxed) % shardCount;
+    return index;
+}
+
+static std::string metricKey(const std::string &name, const std::string &labels)
+{
+    return name + "{" + labels + "}";
+}
+
+static std::string series(const std::string &name, const std::string &labels)
+{
+    return labels.empty() ? name : metricKey(name, labels);
+}
+
+// Counter
+Counter::Counter(const std::string &name, const std::string &labels) :
+    name(name),
+    labels(labels)
+{}
+
+void Counter::add(u64 value)
+{
+    m_shards[shardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+u64 Counter::value() const
+{
+    u64 ret(0);
+    for (auto it = m_shards.begin(); it != m_shards.end(); ++it)
+    {
+        ret += it->value.load(std::memory_order_relaxed);
+    }
+
+    return ret;
+}
+
+// HistogramSnapshot
+u64 HistogramSnapshot::quantile(double q) const
+{
+    if (!count)
+    {
+        return 0;
+    }
+
+    u64 rank = static_cast<u64>(std::ceil(q * static_cast<double>(count)));
+    rank = std::clamp<u64>(rank, 1, count);
+
+    u64 seen(0);
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            return std::min(Histogram::upperBound(i), max);
+        }
+    }
+
+    return max;
+}
+
+// Histogram
+Histogram::Histogram(const std::string &name, const std::string &labels) :
+    name(name),
+    labels(labels),
+    m_max(0)
+{
+    for (auto it = m_buckets.begin(); it != m_buckets.end(); ++it)
+    {
+        it->store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::record(u64 value)
+{
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_shards[shardIndex()].sum.fetch_add(value, std::memory_order_relaxed);
+
+    u64 max = m_max.load(std::memory_order_relaxed);
+    while (value > max &&
+           !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {}
+}
+
+void Histogram::snapshot(HistogramSnapshot &out) const
+{
+    // the count is taken from the buckets, so the quantiles are consistent
+    // with it even when values are recorded meanwhile
+    out.count = 0;
+    out.buckets.resize(bucketCount);
+    for (size_t i = 0; i < bucketCount; ++i)
+    {
+        out.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        out.count += out.buckets[i];
+    }
+
+    out.sum = 0;
+    for (auto it = m_shards.begin(); it != m_shards.end(); ++it)
+    {
+        out.sum += it->sum.load(std::memory_order_relaxed);
+    }
+
+    out.max = m_max.load(std::memory_order_relaxed);
+}
+
+size_t Histogram::bucketIndex(u64 value)
+{
+    if (value < subBucketCount)
+    {
+        return static_cast<size_t>(value);
+    }
+
+    // the highest bit selects the group, the next subBucketBits bits the
+    // bucket in it
+    size_t msb = static_cast<size_t>(std::bit_width(value)) - 1;
+    size_t shift = msb - subBucketBits;
+    size_t group = shift + 1;
+    return group * subBucketCount +
+           static_cast<size_t>((value >> shift) & (subBucketCount - 1));
+}
+
+u64 Histogram::upperBound(size_t index)
+{
+    size_t group = index / subBucketCount;
+    u64 sub = index % subBucketCount;
+    if (!group)
+    {
+        return sub;
+    }
+
+    size_t shift = group - 1;
+    u64 low = (subBucketCount + sub) << shift;
+    return low + ((static_cast<u64>(1) << shift) - 1);
+}
+
+// Scope
+Scope::Scope(Histogram &histogram) :
+    m_histogram(histogram),
+    m_begin(std::chrono::steady_clock::now())
+{}
+
+Scope::~Scope()
+{
+    auto used = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_begin);
+    m_histogram.record(static_cast<u64>(used.count()));
+}
+
+// registry
+Counter &counter(const std::string &name, const std::string &labels)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto &ret = counters[metricKey(name, labels)];
+    if (!ret)
+    {
+        ret = std::make_unique<Counter>(name, labels);
+    }
+
+    return *ret;
+}
+
+Histogram &histogram(const std::string &name, const std::string &labels)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto &ret = histograms[metricKey(name, labels)];
+    if (!ret)
+    {
+        ret = std::make_unique<Histogram>(name, labels);
+    }
+
+    return *ret;
+}
+
+void collect(std::vector<Metric> &out)
+{
+    out.clear();
+    std::unique_lock<std::mutex> lock(mutex);
+    out.reserve(counters.size() + histograms.size());
+    for (auto it = counters.begin(); it != counters.end(); ++it)
+    {
+        Metric metric;
+        metric.type = MetricType_COUNTER;
+        metric.name = it->second->name;
+        metric.labels = it->second->labels;
+        metric.value = it->second->value();
+        out.push_back(std::move(metric));
+    }
+
+    for (auto it = histograms.begin(); it != histograms.end(); ++it)
+    {
+        Metric metric;
+        metric.type = MetricType_HISTOGRAM;
+        metric.name = it->second->name;
+        metric.labels = it->second->labels;
+        it->second->snapshot(metric.histogram);
+        out.push_back(std::move(metric));
+    }
+
+    lock.unlock();
+    std::sort(out.begin(), out.end(), [](const Metric &lhs, const Metric &rhs)
+    {
+        if (lhs.name != rhs.name)
+        {
+            return lhs.name < rhs.name;
+        }
+
+        return lhs.labels < rhs.labels;
+    });
+}
+
+std::string prometheus()
+{
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    std::vector<Metric> metrics;
+    collect(metrics);
+
+    std::string out;
+    std::string lastName;
+    for (auto it = metrics.begin(); it != metrics.end(); ++it)
+    {
+        // the histograms are exported as summaries, their bucket bounds
+        // depend on the recorded values
+        if (it->name != lastName)
+        {
+            out += fmt::format("# TYPE {} {}\n", it->name,
+                it->type == MetricType_COUNTER ? "counter" : "summary");
+            lastName = it->name;
+        }
+
+        if (it->type == MetricType_COUNTER)
+        {
+            out += fmt::format("{} {}\n", series(it->name, it->labels), it->value);
+            continue;
+        }
+
+        std::string sep = it->labels.empty() ? "" : ",";
+        for (auto q : quantiles)
+        {
+            out += fmt::format("{}{{{}{}quantile=\"{}\"}} {}\n", it->name,
+                it->labels, sep, q, it->histogram.quantile(q));
+        }
+
+        out += fmt::format("{} {}\n", series(it->name + "_sum", it->labels),
+            it->histogram.sum);
+        out += fmt::format("{} {}\n", series(it->name + "_count", it->labels),
+            it->histogram.count);
+    }
+
+    return out;
+}
+
+} // end namespace Metrics
+
+} // end namespace Model
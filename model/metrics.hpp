@@ -0,0 +1,193 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _MODEL_METRICS_HPP_
+#define _MODEL_METRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "controller/global/defines.hpp"
+
+#define MetricType_COUNTER   0
+#define MetricType_HISTOGRAM 1
+
+namespace Model
+{
+
+// Server wide registry of counters and latency histograms.
+// Metrics are registered once by name and labels (in the text format of
+// Prometheus, e.g. "method=\"AddTask\"") and are never removed, so the hot
+// paths keep a reference in a function local static and update it without
+// any lock.
+namespace Metrics
+{
+
+// every thread adds to its own cache line, a shard is picked once per
+// thread in round-robin order
+static constexpr size_t shardCount = 16;
+
+class Counter
+{
+public:
+
+    Counter(const std::string &name, const std::string &labels);
+
+    void add(u64 value = 1);
+
+    u64 value() const;
+
+    const std::string name;
+
+    const std::string labels;
+
+private:
+
+    class alignas(64) Shard
+    {
+    public:
+
+        std::atomic<u64> value{0};
+    };
+
+    std::array<Shard, shardCount> m_shards;
+
+}; // end class Counter
+
+class HistogramSnapshot
+{
+public:
+
+    u64 count = 0;
+
+    u64 sum = 0;
+
+    u64 max = 0;
+
+    // count of every bucket, see Histogram::upperBound()
+    std::vector<u64> buckets;
+
+    // upper bound of the bucket the q-th value (0 < q <= 1) is in
+    u64 quantile(double q) const;
+};
+
+// Log-linear buckets like HdrHistogram: values below 8 are exact, above
+// that every power of two is split into 8 buckets, so any recorded value
+// is reported within 12.5%. Covers the whole range of u64 in 496 buckets.
+class Histogram
+{
+public:
+
+    static constexpr size_t subBucketBits = 3;
+
+    static constexpr size_t subBucketCount = 1 << subBucketBits;
+
+    static constexpr size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+    Histogram(const std::string &name, const std::string &labels);
+
+    void record(u64 value);
+
+    void snapshot(HistogramSnapshot &out) const;
+
+    static size_t bucketIndex(u64 value);
+
+    // largest value of the bucket
+    static u64 upperBound(size_t index);
+
+    const std::string name;
+
+    const std::string labels;
+
+private:
+
+    // every value hits the sum, the buckets are spread by value
+    class alignas(64) Shard
+    {
+    public:
+
+        std::atomic<u64> sum{0};
+    };
+
+    std::array<Shard, shardCount> m_shards;
+
+    std::array<std::atomic<u64>, bucketCount> m_buckets;
+
+    std::atomic<u64> m_max;
+
+}; // end class Histogram
+
+// record the microseconds from construction to destruction
+class Scope
+{
+public:
+
+    explicit Scope(Histogram &histogram);
+
+    ~Scope();
+
+private:
+
+    Histogram &m_histogram;
+
+    std::chrono::steady_clock::time_point m_begin;
+
+}; // end class Scope
+
+class Metric
+{
+public:
+
+    // one of MetricType_*
+    u8 type = MetricType_COUNTER;
+
+    std::string name;
+
+    std::string labels;
+
+    // value of a counter
+    u64 value = 0;
+
+    HistogramSnapshot histogram;
+};
+
+// return the metric registered before with the same name and labels
+Counter &counter(const std::string &name, const std::string &labels = "");
+
+Histogram &histogram(const std::string &name, const std::string &labels = "");
+
+// all metrics, sorted by name and labels
+void collect(std::vector<Metric> &out);
+
+// all metrics in the text exposition format of Prometheus
+std::string prometheus();
+
+} // end namespace Metrics
+
+} // end namespace Model
+
+#endif // _MODEL_METRICS_HPP_
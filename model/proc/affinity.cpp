@@ -0,0 +1,118 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cctype>
+
+#include "spdlog/spdlog.h"
+
+#include "affinity.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+Affinity::Affinity() :
+    cpus(std::vector<i32>()),
+    numaNode(-1),
+    roundRobin(false)
+{}
+
+bool Affinity::empty() const
+{
+    return cpus.empty() && numaNode < 0;
+}
+
+u8 Affinity::parseCPUList(const std::string &in, std::vector<i32> &out)
+{
+    out.clear();
+
+    size_t begin(0), end(0);
+    std::string token;
+    while (begin < in.length())
+    {
+        end = in.find(',', begin);
+        if (end == std::string::npos)
+        {
+            end = in.length();
+        }
+
+        token = in.substr(begin, end - begin);
+        begin = end + 1;
+
+        // trailing newline from sysfs
+        while (!token.empty() && isspace(static_cast<unsigned char>(token.back())))
+        {
+            token.pop_back();
+        }
+
+        if (token.empty())
+        {
+            continue;
+        }
+
+        i32 first(0), last(0);
+        try
+        {
+            size_t dash = token.find('-');
+            if (dash == std::string::npos)
+            {
+                first = std::stoi(token);
+                last = first;
+            }
+            else
+            {
+                first = std::stoi(token.substr(0, dash));
+                last = std::stoi(token.substr(dash + 1));
+            }
+        }
+        catch (...)
+        {
+            spdlog::error("{}:{} Invalid cpu list: {}", __FILE__, __LINE__, in);
+            out.clear();
+            return 1;
+        }
+
+        if (first < 0 || last < first)
+        {
+            spdlog::error("{}:{} Invalid cpu range: {}", __FILE__, __LINE__, token);
+            out.clear();
+            return 1;
+        }
+
+        for (i32 cpu = first; cpu <= last; ++cpu)
+        {
+            out.push_back(cpu);
+        }
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return 0;
+}
+
+} // end namespace Proc
+
+} // end namespace Model
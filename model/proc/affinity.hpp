@@ -0,0 +1,65 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _MODEL_PROC_AFFINITY_HPP_
+#define _MODEL_PROC_AFFINITY_HPP_
+
+#include <string>
+#include <vector>
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+class Affinity
+{
+public:
+
+    Affinity();
+
+    // logical cpu ids the tasks are allowed to run on, empty for no pinning
+    std::vector<i32> cpus;
+
+    // NUMA node for cpus and memory, -1 for no binding
+    i32 numaNode;
+
+    // pin every task to a single cpu of "cpus" in round-robin order
+    // instead of the whole set
+    bool roundRobin;
+
+    bool empty() const;
+
+    // parse cpu list like "0-3,8,10-11" (the format of taskset and sysfs)
+    static u8 parseCPUList(const std::string &in, std::vector<i32> &out);
+
+}; // end class Affinity
+
+} // end namespace Proc
+
+} // end namespace Model
+
+#endif // _MODEL_PROC_AFFINITY_HPP_
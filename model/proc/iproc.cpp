@@ -21,6 +21,8 @@
  * SOFTWARE.
  */
 
+#include "model/executor.hpp"
+
 #include "iproc.hpp"
 
 namespace Model
@@ -29,8 +31,29 @@ namespace Model
 namespace Proc
 {
 
+static Executor::Job pollExit(IProc *proc, std::function<void ()> cb)
+{
+    while (proc->isRunning())
+    {
+        co_await Executor::sleep(std::chrono::seconds(1));
+    }
+
+    cb();
+}
+
 IProc::~IProc() {}
 
+void IProc::onExited(std::function<void ()> cb)
+{
+    if (!isRunning())
+    {
+        cb();
+        return;
+    }
+
+    pollExit(this, std::move(cb));
+}
+
 } // end namespace Proc
 
 } // end namespace Model
@@ -24,6 +24,9 @@
 #ifndef _MODEL_PROC_IPROC_HPP_
 #define _MODEL_PROC_IPROC_HPP_
 
+#include <functional>
+
+#include "affinity.hpp"
 #include "task.hpp"
 
 namespace Model
@@ -46,10 +49,29 @@ public:
 
     virtual bool isRunning() = 0;
 
+    // call "cb" once when the task has exited, at once if it is not running,
+    // polls isRunning() every second on the executor if not overridden
+    virtual void onExited(std::function<void ()> cb);
+
     virtual void readCurrentOutput(std::vector<std::string> &out) = 0;
 
     virtual u8 exitCode(i32 &out) = 0;
 
+    // user + system cpu time of the last run in milliseconds
+    virtual u8 cpuTime(i64 &out) = 0;
+
+    virtual u8 setAffinity(const Affinity &in) = 0;
+
+    // ask the running task and its children to exit,
+    // force kills them without giving a chance to clean up
+    virtual u8 terminate(bool force) = 0;
+
+    // unix time of the last output, or of the start if there is none yet
+    virtual i64 lastOutputTime() = 0;
+
+    // output of the last run, only the last FF_MAX_OUTPUT_LOG bytes are kept
+    virtual void outputLog(std::string &out) = 0;
+
 }; // end class IProc
 
 } // end namespace Proc
@@ -23,9 +23,15 @@
 
 #include <cerrno>
 #include <config.h>
+#include <ctime>
+#include <fstream>
 #include <mutex>
 #include <string.h>
+#include <utility>
 
+#include "linux/mempolicy.h"
+#include "sys/resource.h"
+#include "sys/syscall.h"
 #include "sys/types.h"
 #include "sys/wait.h"
 #include "fcntl.h"
@@ -34,8 +40,10 @@
 #include "spdlog/spdlog.h"
 
 #include "controller/global/global.hpp"
+#include "model/metrics.hpp"
 
 #include "linuxproc.hpp"
+#include "reactor.hpp"
 
 namespace Model
 {
@@ -43,12 +51,19 @@ namespace Model
 namespace Proc
 {
 
+// size of the node mask passed to set_mempolicy
+#define MAX_NUMA_NODE 1024
+
 LinuxProc::LinuxProc() :
-    m_pid(0)
+    m_pid(0),
+    m_cpuTime(0),
+    m_lastOutput(0)
 {}
 
 LinuxProc::~LinuxProc()
-{}
+{
+    release();
+}
 
 u8 LinuxProc::init()
 {
@@ -59,6 +74,9 @@ u8 LinuxProc::init()
 
 u8 LinuxProc::start(const Task &task)
 {
+    static Metrics::Histogram &latency = Metrics::histogram("ff_proc_spawn_us");
+    Metrics::Scope scope(latency);
+
     if (isRunning())
     {
         spdlog::error("{}:{} Process is running", __FILE__, __LINE__);
@@ -73,6 +91,14 @@ u8 LinuxProc::start(const Task &task)
 
     m_masterFD = -1;
     m_exitCode.store(0, std::memory_order_relaxed);
+    m_cpuTime.store(0, std::memory_order_relaxed);
+    m_lastOutput.store(time(nullptr), std::memory_order_relaxed);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_log.clear();
+    }
+
+    prepareChildAffinity();
 
     m_pid = forkpty(&m_masterFD, NULL, NULL, NULL);
     if (m_pid == -1)
@@ -103,15 +129,17 @@ u8 LinuxProc::start(const Task &task)
         return 1;
     }
 
-    if (epollInit())
+    if (watch())
     {
-        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
         kill(m_pid, SIGKILL);
-        epollFin();
+        release();
+        int status(0);
+        struct rusage usage = {};
+        UNUSED(wait4(m_pid, &status, 0, &usage));
+        setExited(status, usage);
         return 1;
     }
 
-    m_thread = std::jthread(&LinuxProc::readOutputLoop, this);
     return 0;
 }
 
@@ -122,28 +150,52 @@ void LinuxProc::stop()
 
 bool LinuxProc::isRunning()
 {
-    int status;
-    pid_t ret = waitpid(m_pid, &status, WNOHANG);
-    if (ret == -1)
     {
-        spdlog::debug("{}:{} {}", __FILE__, __LINE__, strerror(errno));
-        epollFin();
-        return false;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_exited)
+        {
+            return false;
+        }
+
+        if (!m_pollExit)
+        {
+            return true;
+        }
     }
-    else if (ret == 0)
+
+    int status(0);
+    struct rusage usage = {};
+    pid_t ret = wait4(m_pid, &status, WNOHANG, &usage);
+    if (ret == 0)
     {
         return true;
     }
-    else
+
+    if (ret == -1)
     {
-        if (WIFEXITED(status) || WIFSIGNALED(status))
+        spdlog::debug("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        status = 0;
+        usage = {};
+    }
+
+    release();
+    setExited(status, usage);
+    return false;
+}
+
+void LinuxProc::onExited(std::function<void ()> cb)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_exited && !m_pollExit)
         {
-            m_exitCode.store(status, std::memory_order_relaxed);
+            m_onExited = std::move(cb);
+            return;
         }
-
-        epollFin();
-        return false;
     }
+
+    // exited already, or no pidfd to be told by the reactor
+    IProc::onExited(std::move(cb));
 }
 
 void LinuxProc::readCurrentOutput(std::vector<std::string> &out)
@@ -180,9 +232,176 @@ u8 LinuxProc::exitCode(i32 &out)
     return 0;
 }
 
+u8 LinuxProc::cpuTime(i64 &out)
+{
+    if (isRunning())
+    {
+        spdlog::error("{}:{} Process is running", __FILE__, __LINE__);
+        return 1;
+    }
+
+    out = m_cpuTime.load(std::memory_order_relaxed);
+    return 0;
+}
+
+u8 LinuxProc::terminate(bool force)
+{
+    if (m_pid <= 0)
+    {
+        spdlog::error("{}:{} Process is not started", __FILE__, __LINE__);
+        return 1;
+    }
+
+    // reaped already, the pid may belong to someone else by now
+    if (!isRunning())
+    {
+        return 0;
+    }
+
+    // the child is a session leader (forkpty), signal the whole group so
+    // whatever it has spawned goes away as well
+    if (kill(-m_pid, force ? SIGKILL : SIGTERM) == -1)
+    {
+        if (errno == ESRCH)
+        {
+            // exited already
+            return 0;
+        }
+
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        return 1;
+    }
+
+    return 0;
+}
+
+i64 LinuxProc::lastOutputTime()
+{
+    return m_lastOutput.load(std::memory_order_relaxed);
+}
+
+void LinuxProc::outputLog(std::string &out)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_log.size() > FF_MAX_OUTPUT_LOG)
+    {
+        out = m_log.substr(m_log.size() - FF_MAX_OUTPUT_LOG);
+        return;
+    }
+
+    out = m_log;
+}
+
+void LinuxProc::appendLog(const std::string &in)
+{
+    // m_mutex is held, grows up to twice the limit so that the tail is
+    // moved once per FF_MAX_OUTPUT_LOG bytes instead of on every read
+    m_log += in;
+    if (m_log.size() > 2 * FF_MAX_OUTPUT_LOG)
+    {
+        m_log.erase(0, m_log.size() - FF_MAX_OUTPUT_LOG);
+    }
+}
+
+u8 LinuxProc::setAffinity(const Affinity &in)
+{
+    Affinity affinity(in);
+    if (affinity.numaNode >= MAX_NUMA_NODE)
+    {
+        spdlog::error("{}:{} Invalid NUMA node: {}", __FILE__, __LINE__,
+                      affinity.numaNode);
+        return 1;
+    }
+
+    if (affinity.cpus.empty() && affinity.numaNode >= 0)
+    {
+        // no explicit cpu set, use all cpus of the node
+        std::string path = "/sys/devices/system/node/node" +
+                           std::to_string(affinity.numaNode) + "/cpulist";
+        std::ifstream file(path);
+        std::string line;
+        if (!file || !std::getline(file, line))
+        {
+            spdlog::error("{}:{} Fail to read {}", __FILE__, __LINE__, path);
+            return 1;
+        }
+
+        if (Affinity::parseCPUList(line, affinity.cpus))
+        {
+            spdlog::error("{}:{} Fail to parse {}", __FILE__, __LINE__, path);
+            return 1;
+        }
+    }
+
+    for (auto it = affinity.cpus.begin(); it != affinity.cpus.end(); ++it)
+    {
+        if (*it >= CPU_SETSIZE)
+        {
+            spdlog::error("{}:{} Invalid cpu: {}", __FILE__, __LINE__, *it);
+            return 1;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_affinityMutex);
+    m_affinity = affinity;
+    m_nextCPU = 0;
+    return 0;
+}
+
 // private member functions
+void LinuxProc::prepareChildAffinity()
+{
+    // resolve the cpu set in parent, child only applies it
+    std::unique_lock<std::mutex> lock(m_affinityMutex);
+    CPU_ZERO(&m_childCPUSet);
+    m_childNumaNode = m_affinity.numaNode;
+    m_pinChild = !m_affinity.cpus.empty();
+    if (!m_pinChild)
+    {
+        return;
+    }
+
+    if (m_affinity.roundRobin)
+    {
+        CPU_SET(m_affinity.cpus[m_nextCPU % m_affinity.cpus.size()], &m_childCPUSet);
+        ++m_nextCPU;
+        return;
+    }
+
+    for (auto it = m_affinity.cpus.begin(); it != m_affinity.cpus.end(); ++it)
+    {
+        CPU_SET(*it, &m_childCPUSet);
+    }
+}
+
+void LinuxProc::applyChildAffinity()
+{
+    if (m_pinChild &&
+        sched_setaffinity(0, sizeof(cpu_set_t), &m_childCPUSet) == -1)
+    {
+        perror("sched_setaffinity");
+        exit(1);
+    }
+
+    if (m_childNumaNode < 0)
+    {
+        return;
+    }
+
+    unsigned long nodeMask[MAX_NUMA_NODE / (8 * sizeof(unsigned long))] = {};
+    size_t bits = 8 * sizeof(unsigned long);
+    nodeMask[m_childNumaNode / bits] |= (1UL << (m_childNumaNode % bits));
+    if (syscall(SYS_set_mempolicy, MPOL_BIND, nodeMask, MAX_NUMA_NODE) == -1)
+    {
+        // kernel without NUMA support, cpu pinning is still applied
+        perror("set_mempolicy");
+    }
+}
+
 void LinuxProc::startChild(const Task &task)
 {
+    applyChildAffinity();
+
     if (chdir(task.workDir.c_str()) == -1)
     {
         perror("chdir");
@@ -265,116 +484,153 @@ char **LinuxProc::buildChildArgv(const Task &task)
 
 void LinuxProc::stopImpl()
 {
-    if (kill(m_pid, SIGKILL) == -1)
+    // nothing spawned yet (e.g. the queue is still waiting for a slot),
+    // kill(0) would hit the whole process group of the server
+    if (m_pid <= 0 || !isRunning())
     {
-        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
         return;
     }
 
-    sleep(2);
+    if (terminate(true))
+    {
+        return;
+    }
+
+    wait(std::chrono::seconds(2));
+}
+
+void LinuxProc::wait(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_exitCond.wait_for(lock, timeout, [this]() { return m_exited; });
 }
 
-u8 LinuxProc::epollInit()
+u8 LinuxProc::watch()
 {
-    m_epoll_fd = epoll_create1(0);
-    if (m_epoll_fd == -1)
+    // pidfd_open needs linux 5.3, older kernels fall back to polling
+    m_pidFD = static_cast<int>(syscall(SYS_pidfd_open, m_pid, 0));
+    m_pollExit = (m_pidFD == -1);
+    if (m_pollExit)
     {
-        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
-        return 1;
+        spdlog::debug("{}:{} pidfd_open: {}", __FILE__, __LINE__, strerror(errno));
     }
 
-    m_event.events = EPOLLIN;
-    m_event.data.fd = m_masterFD;
-    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_masterFD, &m_event))
+    // the callbacks wait for the ids to be set
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_exited = false;
+    m_outputWatch = Reactor::read(m_masterFD, [this](const char *data, size_t size)
     {
-        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        onOutput(data, size);
+    });
+    if (!m_outputWatch)
+    {
+        spdlog::error("{}:{} Fail to watch output", __FILE__, __LINE__);
         return 1;
     }
 
+    if (!m_pollExit)
+    {
+        m_exitWatch = Reactor::add(m_pidFD, [this]() { onExit(); });
+        if (!m_exitWatch)
+        {
+            spdlog::error("{}:{} Fail to watch exit", __FILE__, __LINE__);
+            return 1;
+        }
+    }
+
     return 0;
 }
 
-void LinuxProc::closeFile(int *fd)
+void LinuxProc::onOutput(const char *data, size_t size)
 {
-    if (*fd != -1)
+    // on the reactor thread
+    m_lastOutput.store(time(nullptr), std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::string buf(data, size);
+    appendLog(buf);
+    if (m_deque.size() == FF_MAX_READ_QUEUE_SIZE)
     {
-        close(*fd);
-        *fd = -1;
+        m_deque.pop_front();
     }
+
+    m_deque.push_back(std::move(buf));
 }
 
-void LinuxProc::epollFin()
+void LinuxProc::onExit()
 {
-    closeFile(&m_epoll_fd);
-    closeFile(&m_masterFD);
+    // on the reactor thread, the pidfd is readable once the child has exited
+    int status(0);
+    struct rusage usage = {};
+    if (wait4(m_pid, &status, WNOHANG, &usage) <= 0)
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        status = 0;
+        usage = {};
+    }
+
+    // what the child has written before exiting
+    u64 outputWatch(0);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        outputWatch = m_outputWatch;
+    }
+
+    Reactor::flush(outputWatch);
+    release();
+    setExited(status, usage);
 }
 
-void LinuxProc::readOutputLoop()
+void LinuxProc::setExited(int status, const struct rusage &usage)
 {
-    ssize_t count(0);
-    while(1)
+    if (WIFEXITED(status) || WIFSIGNALED(status))
     {
-        int event_count = epoll_wait(m_epoll_fd, m_events, 10, 1000);
-        if (event_count == -1)
-        {
-            // epoll failed
-            spdlog::error("{}:{} epoll_wait failed: {}",
-                __FILE__, __LINE__, strerror(errno));
-            break;
-        }
+        m_exitCode.store(status, std::memory_order_relaxed);
+    }
 
-        for (int i = 0; i < event_count; ++i)
-        {
-            if (m_events[i].data.fd == m_masterFD &&
-                (m_events[i].events & EPOLLIN))
-            {
-                std::string buf;
-                buf.resize(STQ_READ_BUFFER_SIZE);
-                while (1)
-                {
-                    count = read(m_events[i].data.fd, buf.data(), buf.size());
-                    if (count == -1)
-                    {
-                        if (errno == EINTR || errno == EAGAIN || errno == EIO)
-                        {
-                            spdlog::debug("{}:{} {}", __FILE__, __LINE__, strerror(errno));
-                            continue;
-                        }
-                        else
-                        {
-                            spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
-                            return;
-                        }
-                    }
-                    else if (count == 0)
-                    {
-                        // pipe is closed or child process is exited
-                        spdlog::debug("{}:{} {}", __FILE__, __LINE__, "Nothing to read");
-                        return;
-                    }
-                    else // count != 0
-                    {
-                        buf.resize(count);
-
-                        {
-                            std::unique_lock<std::mutex> lock(m_mutex);
-
-                            if (m_deque.size() == STQ_MAX_READ_QUEUE_SIZE)
-                            {
-                                m_deque.pop_front();
-                            }
-
-                            m_deque.push_back(std::move(buf));
-                        }
-
-                        break;
-                    }
-                } // end while(1)
-            }
-        } // end for (int i = 0; i < event_count; ++i)
+    i64 cpuTime = (static_cast<i64>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000 +
+                  (static_cast<i64>(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) / 1000;
+    m_cpuTime.store(cpuTime, std::memory_order_relaxed);
+
+    std::function<void ()> cb;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_exited = true;
+        cb = std::move(m_onExited);
+        m_onExited = nullptr;
+        m_exitCond.notify_all();
+    }
+
+    if (cb)
+    {
+        cb();
+    }
+}
+
+void LinuxProc::release()
+{
+    u64 outputWatch(0), exitWatch(0);
+    int masterFD(-1), pidFD(-1);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        outputWatch = std::exchange(m_outputWatch, 0);
+        exitWatch = std::exchange(m_exitWatch, 0);
+        masterFD = std::exchange(m_masterFD, -1);
+        pidFD = std::exchange(m_pidFD, -1);
+    }
 
-        sleep(1);
-    } // end while(1)
+    // not holding m_mutex, a running callback may need it to finish
+    Reactor::remove(outputWatch);
+    Reactor::remove(exitWatch);
+    if (masterFD != -1)
+    {
+        close(masterFD);
+    }
+
+    if (pidFD != -1)
+    {
+        close(pidFD);
+    }
 }
 
 } // end namespace Proc
@@ -25,10 +25,12 @@
 #define _MODEL_PROC_LINUXPROC_HPP_
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <deque>
-#include <thread>
+#include <mutex>
 
-#include "sys/epoll.h"
+#include "sched.h"
 
 #include "iproc.hpp"
 
@@ -54,10 +56,22 @@ public:
 
     virtual bool isRunning() override;
 
+    virtual void onExited(std::function<void ()> cb) override;
+
     virtual void readCurrentOutput(std::vector<std::string> &out) override;
 
     virtual u8 exitCode(i32 &out) override;
 
+    virtual u8 cpuTime(i64 &out) override;
+
+    virtual u8 setAffinity(const Affinity &in) override;
+
+    virtual u8 terminate(bool force) override;
+
+    virtual i64 lastOutputTime() override;
+
+    virtual void outputLog(std::string &out) override;
+
 private:
 
     pid_t m_pid;
@@ -66,31 +80,75 @@ private:
 
     std::atomic<i32> m_exitCode;
 
+    // of the task and the children it has waited for, from wait4()
+    std::atomic<i64> m_cpuTime;
+
+    std::atomic<i64> m_lastOutput;
+
     void startChild(const Task &);
 
+    // cpu & NUMA pinning
+    std::mutex m_affinityMutex;
+
+    Affinity m_affinity;
+
+    size_t m_nextCPU = 0;
+
+    bool m_pinChild = false;
+
+    i32 m_childNumaNode = -1;
+
+    cpu_set_t m_childCPUSet;
+
+    void prepareChildAffinity();
+
+    void applyChildAffinity();
+
     char **buildChildArgv(const Task &);
 
     void stopImpl();
 
-    // epoll
-    struct epoll_event m_event, m_events[10];
+    // the exit and the output are handled by Reactor
+    int m_pidFD = -1;
 
-    int m_epoll_fd = -1;
+    u64 m_outputWatch = 0;
 
-    u8 epollInit();
+    u64 m_exitWatch = 0;
 
-    void closeFile(int *);
+    // no pidfd (kernel before 5.3), isRunning() polls with waitpid
+    bool m_pollExit = false;
 
-    void epollFin();
+    // guarded by m_mutex, notified with m_exitCond
+    bool m_exited = true;
 
-    // for reading current output
-    std::jthread m_thread;
+    std::condition_variable m_exitCond;
+
+    // guarded by m_mutex, called once by setExited()
+    std::function<void ()> m_onExited;
+
+    // block until the task has exited or timeout has passed
+    void wait(std::chrono::milliseconds timeout);
+
+    u8 watch();
 
+    void onOutput(const char *data, size_t size);
+
+    void onExit();
+
+    void setExited(int status, const struct rusage &usage);
+
+    // stop watching and close the descriptors of the last run
+    void release();
+
+    // for reading current output
     std::mutex m_mutex;
 
     std::deque<std::string> m_deque;
 
-    void readOutputLoop();
+    // guarded by m_mutex
+    std::string m_log;
+
+    void appendLog(const std::string &);
 };
 
 } // end namespace Proc
@@ -0,0 +1,87 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <mutex>
+#include <new>
+
+#include "spdlog/spdlog.h"
+
+#include "procfactory.hpp"
+
+#if (defined _WIN32)
+#include "winproc.hpp"
+#elif (defined __linux__)
+#include "linuxproc.hpp"
+#endif
+
+namespace Model
+{
+
+namespace Proc
+{
+
+namespace Factory
+{
+
+static std::mutex mutex;
+
+static bool simulated(false);
+
+static SimConfig simConfig;
+
+void simulate(const SimConfig &config)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    simulated = true;
+    simConfig = config;
+    spdlog::warn("{}:{} Tasks are simulated, no process will be run",
+                 __FILE__, __LINE__);
+}
+
+bool isSimulated()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return simulated;
+}
+
+IProc *create()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (simulated)
+    {
+        return new (std::nothrow) SimProc(simConfig);
+    }
+
+#ifdef _WIN32
+    return new (std::nothrow) WinProc();
+#else
+    return new (std::nothrow) LinuxProc();
+#endif
+}
+
+} // end namespace Factory
+
+} // end namespace Proc
+
+} // end namespace Model
@@ -0,0 +1,55 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _MODEL_PROC_PROCFACTORY_HPP_
+#define _MODEL_PROC_PROCFACTORY_HPP_
+
+#include "iproc.hpp"
+#include "simproc.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+// Makes the IProc every new queue runs its tasks with: the native process
+// of the platform by default, or SimProc once simulate() is called.
+namespace Factory
+{
+
+void simulate(const SimConfig &config);
+
+bool isSimulated();
+
+// nullptr if fails to allocate, the caller owns the result
+IProc *create();
+
+} // end namespace Factory
+
+} // end namespace Proc
+
+} // end namespace Model
+
+#endif // _MODEL_PROC_PROCFACTORY_HPP_
@@ -0,0 +1,871 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <config.h>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "poll.h"
+#include "sys/epoll.h"
+#include "sys/eventfd.h"
+#include "unistd.h"
+
+#include "spdlog/spdlog.h"
+
+#include "reactor.hpp"
+
+#ifdef FF_IO_URING
+#include "uring.hpp"
+#endif
+
+// events handled per epoll_wait
+#define REACTOR_MAX_EVENTS 64
+
+// reads of one readiness, the rest is read on the next round so a
+// chatty task cannot hold up the others
+#define REACTOR_MAX_READS 4
+
+// results of readFD()
+#define READ_DRAINED 0
+#define READ_MORE    1
+#define READ_END     2
+
+#ifdef FF_IO_URING
+#define URING_ENTRIES 256
+
+// room for the requests of every running task without overflowing
+#define URING_CQ_ENTRIES 4096
+
+// registered read buffers, the watches beyond them read into their own
+#define URING_BUFFERS 64
+
+// kind of a request, in the low bits of user_data above the watch id
+#define URING_POLL      0
+#define URING_READ      1
+#define URING_CANCEL    2
+#define URING_KIND_BITS 2
+#endif
+
+namespace Model
+{
+
+namespace Proc
+{
+
+namespace Reactor
+{
+
+class Watch
+{
+public:
+
+    int fd = -1;
+
+    // set by add()
+    std::shared_ptr<std::function<void()>> cb;
+
+    // set by read()
+    std::shared_ptr<std::function<void(const char *, size_t)>> onData;
+
+    // io_uring only: removed, kept until its requests in flight are done
+    bool removed = false;
+
+    u32 inflight = 0;
+
+    // index of the registered buffer, -1 for "buffer"
+    i32 bufIndex = -1;
+
+    std::shared_ptr<std::vector<char>> buffer;
+};
+
+static std::mutex mutex;
+
+static std::condition_variable cond;
+
+static std::jthread thread;
+
+static std::thread::id threadID;
+
+static bool keepRunning(false);
+
+static int epollFD(-1);
+
+// wakes the reactor thread up, registered with id 0
+static int wakeFD(-1);
+
+static u64 nextID(1);
+
+// ids of the callbacks which are running, nested by flush()
+static std::vector<u64> runningIDs;
+
+static std::unordered_map<u64, Watch> watches;
+
+#ifdef FF_IO_URING
+static bool useUring(false);
+
+// used by the reactor thread only
+static Uring ring;
+
+// result of setting up the ring on the reactor thread, -1 while pending
+static int ringState(-1);
+
+static std::vector<char> bufferPool;
+
+static std::vector<i32> freeBuffers;
+
+// requests for the reactor thread to submit
+static std::vector<u64> toArm;
+
+static std::vector<u64> toCancel;
+#endif
+
+static void closeFile(int *fd)
+{
+    if (*fd != -1)
+    {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+static bool isRunning(u64 id)
+{
+    return std::find(runningIDs.begin(), runningIDs.end(), id) != runningIDs.end();
+}
+
+static bool isAlive(u64 id)
+{
+    auto it = watches.find(id);
+    return it != watches.end() && !it->second.removed;
+}
+
+static void wake()
+{
+    u64 value(1);
+    if (write(wakeFD, &value, sizeof(value)) == -1)
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+    }
+}
+
+// run a callback of watch "id" without holding the lock
+template<typename F>
+static void dispatch(std::unique_lock<std::mutex> &lock, u64 id, F &&call)
+{
+    runningIDs.push_back(id);
+    lock.unlock();
+    try
+    {
+        call();
+    }
+    catch (...)
+    {
+        spdlog::error("{}:{} Reactor callback throws", __FILE__, __LINE__);
+    }
+
+    lock.lock();
+    runningIDs.pop_back();
+    cond.notify_all();
+}
+
+// the lock is held
+static void erase(std::unordered_map<u64, Watch>::iterator it)
+{
+#ifdef FF_IO_URING
+    if (it->second.bufIndex >= 0)
+    {
+        freeBuffers.push_back(it->second.bufIndex);
+    }
+#endif
+
+    watches.erase(it);
+}
+
+// stop watching "id", the lock is held
+static void drop(u64 id)
+{
+    auto it = watches.find(id);
+    if (it == watches.end())
+    {
+        return;
+    }
+
+#ifdef FF_IO_URING
+    if (useUring)
+    {
+        if (it->second.removed)
+        {
+            return;
+        }
+
+        it->second.removed = true;
+        if (it->second.inflight)
+        {
+            toCancel.push_back(id);
+            if (std::this_thread::get_id() != threadID)
+            {
+                wake();
+            }
+
+            return;
+        }
+
+        erase(it);
+        return;
+    }
+#endif
+
+    // ENOENT or EBADF if the fd is closed already, nothing to do then
+    UNUSED(epoll_ctl(epollFD, EPOLL_CTL_DEL, it->second.fd, nullptr));
+    erase(it);
+}
+
+// read what "fd" has right now with plain read(), the lock is held but
+// released while reading, remove() waits for the reads like for a callback
+static u8 readFD(std::unique_lock<std::mutex> &lock, u64 id, int fd,
+                 const std::shared_ptr<std::function<void(const char *, size_t)>> &onData,
+                 int maxReads)
+{
+    u8 ret(READ_MORE);
+    dispatch(lock, id, [&]()
+    {
+        char buf[FF_READ_BUFFER_SIZE];
+        for (int i = 0; i < maxReads; ++i)
+        {
+            ssize_t count = ::read(fd, buf, sizeof(buf));
+            if (count > 0)
+            {
+                (*onData)(buf, static_cast<size_t>(count));
+                continue;
+            }
+
+            if (count == -1 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (count == -1 && errno == EAGAIN)
+            {
+                ret = READ_DRAINED;
+                return;
+            }
+
+            // EIO from a pty master once every writer has gone
+            ret = READ_END;
+            return;
+        }
+    });
+
+    if (ret == READ_MORE && !isAlive(id))
+    {
+        return READ_DRAINED;
+    }
+
+    return ret;
+}
+
+static void epollLoop()
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    std::unique_lock<std::mutex> lock(mutex);
+    while (keepRunning)
+    {
+        lock.unlock();
+        int count = epoll_wait(epollFD, events, REACTOR_MAX_EVENTS, -1);
+        lock.lock();
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            spdlog::error("{}:{} epoll_wait failed: {}", __FILE__, __LINE__,
+                          strerror(errno));
+            break;
+        }
+
+        // the callbacks (exits) first, then the reads, so a task which has
+        // exited is not kept waiting behind the output of the others
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (int i = 0; i < count && keepRunning; ++i)
+            {
+                u64 id = events[i].data.u64;
+                auto it = watches.find(id);
+                if (it == watches.end() || (!pass != !it->second.onData))
+                {
+                    // the wake up, removed by an earlier callback,
+                    // or not in this pass
+                    continue;
+                }
+
+                if (it->second.onData)
+                {
+                    auto onData = it->second.onData;
+                    if (readFD(lock, id, it->second.fd, onData, REACTOR_MAX_READS) == READ_END)
+                    {
+                        drop(id);
+                    }
+
+                    continue;
+                }
+
+                auto cb = it->second.cb;
+                dispatch(lock, id, [&]() { (*cb)(); });
+            }
+        }
+    }
+}
+
+#ifdef FF_IO_URING
+static u64 userData(u64 id, u64 kind)
+{
+    return (id << URING_KIND_BITS) | kind;
+}
+
+static u8 setupRing()
+{
+    // the kernel runs the completions only when we ask for them, so a read
+    // which is done is never reported after a later plain read() in flush()
+    if (ring.init(URING_ENTRIES, URING_CQ_ENTRIES,
+                  IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN))
+    {
+        return 1;
+    }
+
+    bufferPool.assign(static_cast<size_t>(URING_BUFFERS) * FF_READ_BUFFER_SIZE, 0);
+    std::vector<struct iovec> iov(URING_BUFFERS);
+    for (size_t i = 0; i < iov.size(); ++i)
+    {
+        iov[i].iov_base = &bufferPool[i * FF_READ_BUFFER_SIZE];
+        iov[i].iov_len = FF_READ_BUFFER_SIZE;
+    }
+
+    freeBuffers.clear();
+    if (ring.registerBuffers(iov.data(), URING_BUFFERS))
+    {
+        spdlog::warn("{}:{} Read without registered buffers", __FILE__, __LINE__);
+        bufferPool.clear();
+        return 0;
+    }
+
+    for (i32 i = URING_BUFFERS - 1; i >= 0; --i)
+    {
+        freeBuffers.push_back(i);
+    }
+
+    return 0;
+}
+
+static u8 ensureSpace(u32 count)
+{
+    if (ring.space() < count)
+    {
+        UNUSED(ring.submit(0));
+    }
+
+    return ring.space() < count;
+}
+
+static void armWake()
+{
+    if (ensureSpace(1))
+    {
+        spdlog::error("{}:{} Submission queue is full", __FILE__, __LINE__);
+        return;
+    }
+
+    struct io_uring_sqe *sqe = ring.getSQE();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wakeFD;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = userData(0, URING_POLL);
+}
+
+// the lock is held
+static void arm(u64 id, Watch &watch)
+{
+    if (ensureSpace(watch.onData ? 2 : 1))
+    {
+        // try again on the next round
+        toArm.push_back(id);
+        return;
+    }
+
+    struct io_uring_sqe *sqe = ring.getSQE();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = watch.fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = userData(id, URING_POLL);
+    ++watch.inflight;
+    if (!watch.onData)
+    {
+        return;
+    }
+
+    // the fd is non-blocking, so read only once the poll has fired
+    sqe->flags = IOSQE_IO_LINK;
+    sqe = ring.getSQE();
+    sqe->fd = watch.fd;
+    sqe->off = static_cast<u64>(-1);
+    sqe->len = FF_READ_BUFFER_SIZE;
+    sqe->user_data = userData(id, URING_READ);
+    if (watch.bufIndex >= 0)
+    {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = reinterpret_cast<u64>(
+            &bufferPool[static_cast<size_t>(watch.bufIndex) * FF_READ_BUFFER_SIZE]);
+        sqe->buf_index = static_cast<u16>(watch.bufIndex);
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_READ;
+        sqe->addr = reinterpret_cast<u64>(watch.buffer->data());
+    }
+
+    ++watch.inflight;
+}
+
+static void cancel(u64 id, const Watch &watch)
+{
+    // a cancel which finds nothing fails with ENOENT, that is fine
+    for (u64 kind = URING_POLL; kind <= (watch.onData ? URING_READ : URING_POLL); ++kind)
+    {
+        if (ensureSpace(1))
+        {
+            toCancel.push_back(id);
+            return;
+        }
+
+        struct io_uring_sqe *sqe = ring.getSQE();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = userData(id, kind);
+        sqe->user_data = userData(id, URING_CANCEL);
+    }
+}
+
+// queue the requests asked for since the last round, the lock is held
+static void prepare()
+{
+    std::vector<u64> ids;
+    ids.swap(toArm);
+    for (auto id = ids.begin(); id != ids.end(); ++id)
+    {
+        auto it = watches.find(*id);
+        if (it != watches.end() && !it->second.removed && !it->second.inflight)
+        {
+            arm(*id, it->second);
+        }
+    }
+
+    ids.clear();
+    ids.swap(toCancel);
+    for (auto id = ids.begin(); id != ids.end(); ++id)
+    {
+        auto it = watches.find(*id);
+        if (it != watches.end() && it->second.inflight)
+        {
+            cancel(*id, it->second);
+        }
+    }
+}
+
+// the lock is held
+static void complete(std::unique_lock<std::mutex> &lock, const struct io_uring_cqe &cqe)
+{
+    u64 id = cqe.user_data >> URING_KIND_BITS;
+    u64 kind = cqe.user_data & ((1 << URING_KIND_BITS) - 1);
+    if (!id)
+    {
+        u64 value(0);
+        UNUSED(::read(wakeFD, &value, sizeof(value)));
+        if (keepRunning)
+        {
+            armWake();
+        }
+
+        return;
+    }
+
+    auto it = watches.find(id);
+    if (kind == URING_CANCEL || it == watches.end())
+    {
+        return;
+    }
+
+    Watch &watch = it->second;
+    --watch.inflight;
+    if (watch.removed)
+    {
+        if (!watch.inflight)
+        {
+            erase(it);
+        }
+
+        return;
+    }
+
+    if (!watch.onData)
+    {
+        if (cqe.res < 0)
+        {
+            spdlog::error("{}:{} poll failed: {}", __FILE__, __LINE__, strerror(-cqe.res));
+            drop(id);
+            return;
+        }
+
+        auto cb = watch.cb;
+        dispatch(lock, id, [&]() { (*cb)(); });
+    }
+    else if (kind == URING_POLL)
+    {
+        // the linked read follows, it is cancelled if the poll has failed
+        if (cqe.res < 0)
+        {
+            drop(id);
+        }
+
+        return;
+    }
+    else if (cqe.res > 0)
+    {
+        const char *data = watch.bufIndex >= 0 ?
+            &bufferPool[static_cast<size_t>(watch.bufIndex) * FF_READ_BUFFER_SIZE] :
+            watch.buffer->data();
+        auto onData = watch.onData;
+        auto buffer = watch.buffer;
+        dispatch(lock, id, [&]() { (*onData)(data, static_cast<size_t>(cqe.res)); });
+    }
+    else if (cqe.res != -EAGAIN && cqe.res != -EINTR)
+    {
+        // end of file, or EIO from a pty master once every writer has gone
+        drop(id);
+        return;
+    }
+
+    it = watches.find(id);
+    if (it != watches.end() && !it->second.removed && !it->second.inflight)
+    {
+        toArm.push_back(id);
+    }
+}
+
+static void completeAll(std::unique_lock<std::mutex> &lock)
+{
+    struct io_uring_cqe cqe;
+    while (ring.popCQE(cqe))
+    {
+        complete(lock, cqe);
+    }
+}
+
+static void uringLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // a single issuer ring belongs to the thread which has made it
+    ringState = setupRing();
+    cond.notify_all();
+    if (ringState)
+    {
+        return;
+    }
+
+    armWake();
+    while (keepRunning)
+    {
+        prepare();
+        lock.unlock();
+        int ret = ring.submit(1);
+        lock.lock();
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY)
+        {
+            spdlog::error("{}:{} io_uring_enter failed: {}", __FILE__, __LINE__,
+                          strerror(-ret));
+            break;
+        }
+
+        completeAll(lock);
+    }
+}
+#endif
+
+static u64 insert(Watch &&watch)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!keepRunning)
+    {
+        spdlog::error("{}:{} Reactor is not running", __FILE__, __LINE__);
+        return 0;
+    }
+
+    u64 id = nextID++;
+#ifdef FF_IO_URING
+    if (useUring)
+    {
+        if (watch.onData && !freeBuffers.empty())
+        {
+            watch.bufIndex = freeBuffers.back();
+            freeBuffers.pop_back();
+        }
+        else if (watch.onData)
+        {
+            watch.buffer = std::make_shared<std::vector<char>>(FF_READ_BUFFER_SIZE);
+        }
+
+        watches[id] = std::move(watch);
+        toArm.push_back(id);
+        if (std::this_thread::get_id() != threadID)
+        {
+            wake();
+        }
+
+        return id;
+    }
+#endif
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    if (epoll_ctl(epollFD, EPOLL_CTL_ADD, watch.fd, &event))
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        return 0;
+    }
+
+    watches[id] = std::move(watch);
+    return id;
+}
+
+static u8 startEpoll()
+{
+    epollFD = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFD == -1)
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        return 1;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    if (epoll_ctl(epollFD, EPOLL_CTL_ADD, wakeFD, &event))
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        closeFile(&epollFD);
+        return 1;
+    }
+
+    try
+    {
+        thread = std::jthread(epollLoop);
+        threadID = thread.get_id();
+    }
+    catch (...)
+    {
+        closeFile(&epollFD);
+        spdlog::error("{}:{} Fail to start reactor thread", __FILE__, __LINE__);
+        return 1;
+    }
+
+    return 0;
+}
+
+u8 init()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (keepRunning)
+    {
+        spdlog::error("{}:{} Reactor is running", __FILE__, __LINE__);
+        return 1;
+    }
+
+    wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFD == -1)
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        return 1;
+    }
+
+    keepRunning = true;
+#ifdef FF_IO_URING
+    useUring = true;
+    ringState = -1;
+    try
+    {
+        thread = std::jthread(uringLoop);
+        threadID = thread.get_id();
+        cond.wait(lock, []() { return ringState != -1; });
+    }
+    catch (...)
+    {
+        ringState = 1;
+    }
+
+    if (!ringState)
+    {
+        spdlog::info("{}:{} Reactor uses io_uring", __FILE__, __LINE__);
+        return 0;
+    }
+
+    // the thread has returned
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+    spdlog::warn("{}:{} io_uring is not available, use epoll", __FILE__, __LINE__);
+    useUring = false;
+#endif
+
+    if (startEpoll())
+    {
+        keepRunning = false;
+        closeFile(&wakeFD);
+        return 1;
+    }
+
+    return 0;
+}
+
+void fin()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!keepRunning)
+        {
+            return;
+        }
+
+        keepRunning = false;
+        wake();
+    }
+
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    watches.clear();
+#ifdef FF_IO_URING
+    // closing the ring cancels what is still in flight
+    ring.fin();
+    bufferPool.clear();
+    freeBuffers.clear();
+    toArm.clear();
+    toCancel.clear();
+#endif
+    closeFile(&wakeFD);
+    closeFile(&epollFD);
+}
+
+u64 add(int fd, std::function<void()> cb)
+{
+    Watch watch;
+    watch.fd = fd;
+    watch.cb = std::make_shared<std::function<void()>>(std::move(cb));
+    return insert(std::move(watch));
+}
+
+u64 read(int fd, std::function<void(const char *data, size_t size)> onData)
+{
+    Watch watch;
+    watch.fd = fd;
+    watch.onData = std::make_shared<std::function<void(const char *, size_t)>>(
+        std::move(onData));
+    return insert(std::move(watch));
+}
+
+void flush(u64 id)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (std::this_thread::get_id() != threadID)
+    {
+        spdlog::error("{}:{} Not on the reactor thread", __FILE__, __LINE__);
+        return;
+    }
+
+#ifdef FF_IO_URING
+    if (useUring)
+    {
+        // the reads which are done already go first, to keep the order
+        lock.unlock();
+        UNUSED(ring.submit(0));
+        lock.lock();
+        completeAll(lock);
+    }
+#endif
+
+    auto it = watches.find(id);
+    if (it == watches.end() || it->second.removed || !it->second.onData)
+    {
+        return;
+    }
+
+    int fd = it->second.fd;
+    auto onData = it->second.onData;
+    u8 ret(READ_MORE);
+    while (ret == READ_MORE)
+    {
+        ret = readFD(lock, id, fd, onData, REACTOR_MAX_READS);
+    }
+
+    if (ret == READ_END)
+    {
+        drop(id);
+    }
+}
+
+void remove(u64 id)
+{
+    if (!id)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    drop(id);
+    if (std::this_thread::get_id() == threadID)
+    {
+        return;
+    }
+
+    cond.wait(lock, [id]() { return !isRunning(id); });
+}
+
+} // end namespace Reactor
+
+} // end namespace Proc
+
+} // end namespace Model
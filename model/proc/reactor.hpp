@@ -0,0 +1,79 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _MODEL_PROC_REACTOR_HPP_
+#define _MODEL_PROC_REACTOR_HPP_
+
+#include <functional>
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+// Server wide event loop for the file descriptors of the running tasks
+// (pty masters and pidfds). One thread serves all of them, so the number of
+// threads does not grow with the number of running tasks. Callbacks run on
+// the reactor thread and must not block.
+//
+// Uses epoll, or io_uring when built with ENABLE_IO_URING and the kernel
+// supports it: reads are then done by the kernel into registered buffers
+// and all requests of a round are submitted with one system call.
+namespace Reactor
+{
+
+// start the reactor thread
+u8 init();
+
+void fin();
+
+// call "cb" whenever "fd" is readable or hung up (level triggered) until
+// remove() is called, the caller keeps owning "fd",
+// return the watch id for remove(), 0 on failure
+u64 add(int fd, std::function<void()> cb);
+
+// read "fd" (non-blocking) as data arrives and pass every chunk to "onData",
+// stops by itself at end of file or on error, the caller keeps owning "fd",
+// return the watch id for remove(), 0 on failure
+u64 read(int fd, std::function<void(const char *data, size_t size)> onData);
+
+// pass what can be read from a read() watch right now to its "onData",
+// only from a callback
+void flush(u64 id);
+
+// after return the callback is neither pending nor running, except when
+// called from a callback: it does not wait for the callback it is called from
+// 0 is ignored
+void remove(u64 id);
+
+} // end namespace Reactor
+
+} // end namespace Proc
+
+} // end namespace Model
+
+#endif // _MODEL_PROC_REACTOR_HPP_
@@ -0,0 +1,298 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <config.h>
+#include <ctime>
+#include <utility>
+
+#include "spdlog/spdlog.h"
+
+#include "model/executor.hpp"
+
+#include "simproc.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+// exit code of a terminated task, the same as the raw wait status
+// of a process killed by SIGTERM / SIGKILL
+#define SIM_TERM_CODE 15
+#define SIM_KILL_CODE 9
+
+SimProc::SimProc(const SimConfig &config) :
+    m_config(config),
+    m_exitTimer(0),
+    m_run(0),
+    m_gen(std::random_device()()),
+    m_exitCode(0),
+    m_lastOutput(0),
+    m_emitted(0)
+{}
+
+SimProc::~SimProc()
+{
+    Executor::cancel(m_exitTimer);
+}
+
+u8 SimProc::init()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_exitCode = 0;
+    m_deque.clear();
+    return 0;
+}
+
+u8 SimProc::start(const Task &task)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (running(now))
+    {
+        spdlog::error("{}:{} Process is running", __FILE__, __LINE__);
+        return 1;
+    }
+
+    u32 duration = m_config.duration;
+    if (m_config.jitter)
+    {
+        duration += std::uniform_int_distribution<u32>(0, m_config.jitter)(m_gen);
+    }
+
+    m_exitCode = 0;
+    if (m_config.failRate > 0 &&
+        std::uniform_real_distribution<double>(0, 1)(m_gen) < m_config.failRate)
+    {
+        m_exitCode = 1;
+    }
+
+    ++m_run;
+    m_execName = task.execName;
+    m_begin = now;
+    m_end = now + std::chrono::milliseconds(duration);
+    m_lastOutput = static_cast<i64>(time(nullptr));
+    m_emitted = 0;
+    m_log.clear();
+    return 0;
+}
+
+void SimProc::stop()
+{
+    UNUSED(terminate(true));
+}
+
+bool SimProc::isRunning()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    emitOutput(now);
+    return running(now);
+}
+
+void SimProc::onExited(std::function<void ()> cb)
+{
+    // a timer which has not fired, so this is not called from it
+    u64 stale(0);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        stale = std::exchange(m_exitTimer, 0);
+    }
+
+    Executor::cancel(stale);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (running(std::chrono::steady_clock::now()))
+        {
+            m_onExited = std::move(cb);
+            u64 run = m_run;
+            m_exitTimer = Executor::at(m_end, [this, run]() { exited(run); });
+            return;
+        }
+    }
+
+    cb();
+}
+
+void SimProc::readCurrentOutput(std::vector<std::string> &out)
+{
+    out.clear();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    emitOutput(std::chrono::steady_clock::now());
+    if (m_deque.empty())
+    {
+        spdlog::debug("{}:{} nothing to read", __FILE__, __LINE__);
+        return;
+    }
+
+    out.reserve(m_deque.size());
+    while (!m_deque.empty())
+    {
+        out.push_back(std::move(m_deque.front()));
+        m_deque.pop_front();
+    }
+}
+
+u8 SimProc::exitCode(i32 &out)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    emitOutput(now);
+    if (running(now))
+    {
+        spdlog::error("{}:{} Process is running", __FILE__, __LINE__);
+        return 1;
+    }
+
+    out = m_exitCode;
+    return 0;
+}
+
+u8 SimProc::cpuTime(i64 &out)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (running(std::chrono::steady_clock::now()))
+    {
+        spdlog::error("{}:{} Process is running", __FILE__, __LINE__);
+        return 1;
+    }
+
+    // nothing has run
+    out = 0;
+    return 0;
+}
+
+u8 SimProc::setAffinity(const Affinity &in)
+{
+    // nothing is spawned, nothing to pin
+    UNUSED(in);
+    return 0;
+}
+
+u8 SimProc::terminate(bool force)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (!running(now))
+    {
+        // exited already
+        return 0;
+    }
+
+    // the output written so far is kept, the rest is never written
+    emitOutput(now);
+    m_emitted = m_config.outputLines;
+    m_end = now;
+    m_exitCode = force ? SIM_KILL_CODE : SIM_TERM_CODE;
+    u64 run = m_run;
+    u64 timer = std::exchange(m_exitTimer, 0);
+    lock.unlock();
+
+    // not called from the timer, it is gone once cancel() returns
+    Executor::cancel(timer);
+    exited(run);
+    return 0;
+}
+
+i64 SimProc::lastOutputTime()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    emitOutput(std::chrono::steady_clock::now());
+    return m_lastOutput;
+}
+
+void SimProc::outputLog(std::string &out)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    out = m_log;
+}
+
+// private member functions
+void SimProc::exited(u64 run)
+{
+    std::function<void ()> cb;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (run != m_run)
+        {
+            // the timer of an earlier run, the task it was armed for is gone
+            return;
+        }
+
+        m_exitTimer = 0;
+        cb = std::move(m_onExited);
+        m_onExited = nullptr;
+    }
+
+    if (cb)
+    {
+        cb();
+    }
+}
+
+bool SimProc::running(std::chrono::steady_clock::time_point now) const
+{
+    return now < m_end;
+}
+
+void SimProc::emitOutput(std::chrono::steady_clock::time_point now)
+{
+    // the output is made when it is looked at, as far as the run has gone
+    u32 due = m_config.outputLines;
+    if (running(now))
+    {
+        auto total = (m_end - m_begin).count();
+        due = static_cast<u32>(static_cast<u64>(due) * (now - m_begin).count() / total);
+    }
+
+    if (m_emitted >= due)
+    {
+        return;
+    }
+
+    for (; m_emitted < due; ++m_emitted)
+    {
+        std::string line = fmt::format("{} {}/{}\n", m_execName, m_emitted + 1,
+                                       m_config.outputLines);
+        m_log += line;
+        m_deque.push_back(std::move(line));
+        if (m_deque.size() > FF_MAX_READ_QUEUE_SIZE)
+        {
+            m_deque.pop_front();
+        }
+    }
+
+    if (m_log.size() > FF_MAX_OUTPUT_LOG)
+    {
+        m_log.erase(0, m_log.size() - FF_MAX_OUTPUT_LOG);
+    }
+
+    m_lastOutput = static_cast<i64>(time(nullptr));
+}
+
+} // end namespace Proc
+
+} // end namespace Model
@@ -0,0 +1,139 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _MODEL_PROC_SIMPROC_HPP_
+#define _MODEL_PROC_SIMPROC_HPP_
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+
+#include "iproc.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+class SimConfig
+{
+public:
+
+    // how long every task "runs", in milliseconds
+    u32 duration = 0;
+
+    // a random amount of 0 to jitter milliseconds is added to the duration
+    u32 jitter = 0;
+
+    // lines of output emitted evenly over the run
+    u32 outputLines = 1;
+
+    // share of the tasks which exit with 1, from 0 to 1
+    double failRate = 0;
+
+}; // end class SimConfig
+
+// Runs no process at all: a task is "running" for a synthetic duration and
+// writes synthetic output. Lets the scheduler, the queue loops and the
+// database be profiled without the cost of process creation.
+class SimProc : public IProc
+{
+public:
+
+    SimProc(const SimConfig &config);
+
+    ~SimProc();
+
+    virtual u8 init() override;
+
+    virtual u8 start(const Task &task) override;
+
+    virtual void stop() override;
+
+    virtual bool isRunning() override;
+
+    virtual void onExited(std::function<void ()> cb) override;
+
+    virtual void readCurrentOutput(std::vector<std::string> &out) override;
+
+    virtual u8 exitCode(i32 &out) override;
+
+    virtual u8 cpuTime(i64 &out) override;
+
+    virtual u8 setAffinity(const Affinity &in) override;
+
+    virtual u8 terminate(bool force) override;
+
+    virtual i64 lastOutputTime() override;
+
+    virtual void outputLog(std::string &out) override;
+
+private:
+
+    SimConfig m_config;
+
+    std::mutex m_mutex;
+
+    // called at the end of the run by an executor timer, or by terminate()
+    std::function<void ()> m_onExited;
+
+    // 0 once it has fired or is cancelled
+    u64 m_exitTimer;
+
+    // counts the runs, a timer armed for an earlier run calls nothing
+    u64 m_run;
+
+    std::mt19937 m_gen;
+
+    std::string m_execName;
+
+    std::chrono::steady_clock::time_point m_begin;
+
+    std::chrono::steady_clock::time_point m_end;
+
+    i32 m_exitCode;
+
+    i64 m_lastOutput;
+
+    u32 m_emitted;
+
+    std::deque<std::string> m_deque;
+
+    std::string m_log;
+
+    // m_mutex is held
+    bool running(std::chrono::steady_clock::time_point now) const;
+
+    void emitOutput(std::chrono::steady_clock::time_point now);
+
+    void exited(u64 run);
+};
+
+} // end namespace Proc
+
+} // end namespace Model
+
+#endif // _MODEL_PROC_SIMPROC_HPP_
@@ -31,15 +31,41 @@ namespace Model
 namespace Proc
 {
 
+TaskRef::TaskRef() :
+    queue(""),
+    ID(0)
+{}
+
 Task::Task() :
     execName(""),
     args(std::vector<std::string>()),
     workDir(""),
     ID(0),
     exitCode(0),
-    isSuccess(false)
+    isSuccess(false),
+    priority(0),
+    notBefore(0),
+    cron(""),
+    maxRetries(0),
+    backoff(0),
+    backoffMax(0),
+    attempt(0),
+    timeout(0),
+    idleOutputTimeout(0),
+    timedOut(false),
+    idempotencyKey(""),
+    inputs(std::vector<std::string>()),
+    cached(false),
+    dependsOn(std::vector<TaskRef>()),
+    enqueueTime(0),
+    startTime(0),
+    endTime(0),
+    waitTime(0),
+    runTime(0),
+    cpuTime(0)
 {
     args.clear();
+    inputs.clear();
 }
 
 void Task::print() const
@@ -56,8 +82,45 @@ void Task::print() const
     fmt::println("ID: {}", ID);
     fmt::println("exitCode: {}", exitCode);
     fmt::println("isSuccess: {}", std::to_string(isSuccess));
+    fmt::println("priority: {}", priority);
+    fmt::println("notBefore: {}", notBefore);
+    fmt::println("cron: {}", cron);
+    fmt::println("maxRetries: {}", maxRetries);
+    fmt::println("backoff: {}", backoff);
+    fmt::println("backoffMax: {}", backoffMax);
+    fmt::println("attempt: {}", attempt);
+    fmt::println("timeout: {}", timeout);
+    fmt::println("idleOutputTimeout: {}", idleOutputTimeout);
+    fmt::println("timedOut: {}", std::to_string(timedOut));
+    fmt::println("inputs: ");
+    for (auto it = inputs.begin(); it != inputs.end(); ++it)
+    {
+        fmt::println("{}", *it);
+    }
+    fmt::println("");
+
+    fmt::println("cached: {}", std::to_string(cached));
+    fmt::println("dependsOn: ");
+    for (auto it = dependsOn.begin(); it != dependsOn.end(); ++it)
+    {
+        fmt::println("{}:{}", it->queue, it->ID);
+    }
+    fmt::println("");
+
+    fmt::println("enqueueTime: {}", enqueueTime);
+    fmt::println("startTime: {}", startTime);
+    fmt::println("endTime: {}", endTime);
+    fmt::println("waitTime: {} ms", waitTime);
+    fmt::println("runTime: {} ms", runTime);
+    fmt::println("cpuTime: {} ms", cpuTime);
 }
 
+Attempt::Attempt() :
+    attempt(0),
+    exitCode(0),
+    endTime(0)
+{}
+
 } // end namespace Proc
 
 } // end namespace Model
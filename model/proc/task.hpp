@@ -35,6 +35,18 @@ namespace Model
 namespace Proc
 {
 
+// a task of any queue of the server
+class TaskRef
+{
+public:
+
+    TaskRef();
+
+    // empty for the queue of the task which refers to it
+    std::string queue;
+    i32 ID;
+}; // end class TaskRef
+
 class Task
 {
 public:
@@ -47,10 +59,64 @@ public:
     i32 ID;
     i32 exitCode;
     bool isSuccess;
+    i32 priority;
+    // unix time in seconds, the task waits in "scheduled" until then
+    i64 notBefore;
+    // recurring task, see Model::Cron
+    std::string cron;
+    // retry a failed task up to maxRetries times, the delay starts from
+    // "backoff" seconds and doubles every attempt up to "backoffMax"
+    i32 maxRetries;
+    i32 backoff;
+    i32 backoffMax;
+    // number of the runs before this one
+    i32 attempt;
+    // seconds, 0 for no limit, the task is terminated when it runs longer
+    // or has written nothing for idleOutputTimeout seconds
+    i32 timeout;
+    i32 idleOutputTimeout;
+    bool timedOut;
+    // client supplied, a submission with a key used within FF_DEDUP_WINDOW
+    // returns the ID of the first one, only used by IQueue::addTask()
+    std::string idempotencyKey;
+    // files the result depends on, their size and mtime are part of the
+    // key of the result cache, relative paths are relative to workDir
+    std::vector<std::string> inputs;
+    // finished from the result cache without running
+    bool cached;
+    // the task waits in "blocked" until all of them have succeeded,
+    // and fails if one of them fails
+    std::vector<TaskRef> dependsOn;
+    // unix time in milliseconds the task has entered "pending",
+    // 0 if it never has or the database is older
+    i64 enqueueTime;
+    // unix time in milliseconds the run has started and ended,
+    // 0 if it has not
+    i64 startTime;
+    i64 endTime;
+    // milliseconds from entering "pending" to the start of the run, the
+    // wait for a slot of the scheduler included, and of the run itself,
+    // which is measured by the monotonic clock
+    i64 waitTime;
+    i64 runTime;
+    // milliseconds of user + system cpu time of the run
+    i64 cpuTime;
 
     void print() const;
 }; // end class Task
 
+class Attempt
+{
+public:
+
+    Attempt();
+
+    i32 attempt;
+    i32 exitCode;
+    // unix time in milliseconds
+    i64 endTime;
+}; // end class Attempt
+
 } // end namespace Proc
 
 } // end namespace Model
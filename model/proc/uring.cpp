@@ -0,0 +1,217 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <cerrno>
+#include <string.h>
+
+#include "sys/mman.h"
+#include "sys/syscall.h"
+#include "unistd.h"
+
+#include "spdlog/spdlog.h"
+
+#include "uring.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+Uring::Uring() :
+    m_fd(-1),
+    m_ring(MAP_FAILED),
+    m_ringSize(0),
+    m_sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)),
+    m_sqesSize(0),
+    m_sqHead(nullptr),
+    m_sqTail(nullptr),
+    m_sqMask(0),
+    m_sqEntries(0),
+    m_sqArray(nullptr),
+    m_sqeTail(0),
+    m_sqeSubmitted(0),
+    m_cqHead(nullptr),
+    m_cqTail(nullptr),
+    m_cqMask(0),
+    m_cqes(nullptr)
+{}
+
+Uring::~Uring()
+{
+    fin();
+}
+
+u8 Uring::init(u32 entries, u32 cqEntries, u32 flags)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = flags;
+    if (cqEntries)
+    {
+        params.flags |= IORING_SETUP_CQSIZE;
+        params.cq_entries = cqEntries;
+    }
+
+    m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (m_fd == -1)
+    {
+        spdlog::debug("{}:{} io_uring_setup: {}", __FILE__, __LINE__, strerror(errno));
+        return 1;
+    }
+
+    // the submission and the completion rings share one mapping
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        spdlog::debug("{}:{} Kernel is too old for io_uring", __FILE__, __LINE__);
+        fin();
+        return 1;
+    }
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(__u32);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    m_ringSize = sqSize > cqSize ? sqSize : cqSize;
+    m_ring = mmap(nullptr, m_ringSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_ring == MAP_FAILED)
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        fin();
+        return 1;
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = static_cast<struct io_uring_sqe *>(
+        mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES));
+    if (m_sqes == MAP_FAILED)
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, strerror(errno));
+        fin();
+        return 1;
+    }
+
+    char *ring = static_cast<char *>(m_ring);
+    m_sqHead = reinterpret_cast<__u32 *>(ring + params.sq_off.head);
+    m_sqTail = reinterpret_cast<__u32 *>(ring + params.sq_off.tail);
+    m_sqMask = *reinterpret_cast<__u32 *>(ring + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_sqArray = reinterpret_cast<__u32 *>(ring + params.sq_off.array);
+    m_sqeTail = *m_sqTail;
+    m_sqeSubmitted = m_sqeTail;
+
+    m_cqHead = reinterpret_cast<__u32 *>(ring + params.cq_off.head);
+    m_cqTail = reinterpret_cast<__u32 *>(ring + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<__u32 *>(ring + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<struct io_uring_cqe *>(ring + params.cq_off.cqes);
+    return 0;
+}
+
+void Uring::fin()
+{
+    if (m_sqes != MAP_FAILED)
+    {
+        munmap(m_sqes, m_sqesSize);
+        m_sqes = static_cast<struct io_uring_sqe *>(MAP_FAILED);
+    }
+
+    if (m_ring != MAP_FAILED)
+    {
+        munmap(m_ring, m_ringSize);
+        m_ring = MAP_FAILED;
+    }
+
+    if (m_fd != -1)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+struct io_uring_sqe *Uring::getSQE()
+{
+    __u32 head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if (m_sqeTail - head >= m_sqEntries)
+    {
+        return nullptr;
+    }
+
+    __u32 index = m_sqeTail & m_sqMask;
+    m_sqArray[index] = index;
+    ++m_sqeTail;
+
+    struct io_uring_sqe *sqe = &m_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+u32 Uring::space() const
+{
+    return m_sqEntries - (m_sqeTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE));
+}
+
+int Uring::submit(u32 waitNr)
+{
+    __u32 count = m_sqeTail - m_sqeSubmitted;
+    __atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, m_fd, count, waitNr,
+                                       IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (ret == -1)
+    {
+        return -errno;
+    }
+
+    m_sqeSubmitted += static_cast<__u32>(ret);
+    return ret;
+}
+
+bool Uring::popCQE(struct io_uring_cqe &out)
+{
+    __u32 head = *m_cqHead;
+    if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+
+    out = m_cqes[head & m_cqMask];
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+u8 Uring::registerBuffers(const struct iovec *iov, u32 count)
+{
+    if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, iov, count))
+    {
+        spdlog::debug("{}:{} io_uring_register: {}", __FILE__, __LINE__,
+                      strerror(errno));
+        return 1;
+    }
+
+    return 0;
+}
+
+} // end namespace Proc
+
+} // end namespace Model
@@ -0,0 +1,113 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _MODEL_PROC_URING_HPP_
+#define _MODEL_PROC_URING_HPP_
+
+#include "linux/io_uring.h"
+#include "sys/uio.h"
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+namespace Proc
+{
+
+// Minimal io_uring on top of the kernel interface, only what Reactor needs.
+// Not thread safe, every call must come from the same thread.
+// The ring counters are shared with the kernel and wrap at 32 bits, so they
+// are __u32 and not u32 (which may be wider).
+class Uring
+{
+public:
+
+    Uring();
+
+    ~Uring();
+
+    // "cqEntries" 0 for the default of the kernel (2 * entries)
+    u8 init(u32 entries, u32 cqEntries, u32 flags);
+
+    void fin();
+
+    // next free submission entry, zeroed, nullptr if the queue is full
+    struct io_uring_sqe *getSQE();
+
+    // free submission entries
+    u32 space() const;
+
+    // submit every entry got since the last call, run the deferred
+    // completions and wait for "waitNr" of them,
+    // return the number submitted or -errno
+    int submit(u32 waitNr);
+
+    // take the next completion, return false if there is none
+    bool popCQE(struct io_uring_cqe &out);
+
+    u8 registerBuffers(const struct iovec *iov, u32 count);
+
+private:
+
+    int m_fd;
+
+    void *m_ring;
+
+    size_t m_ringSize;
+
+    struct io_uring_sqe *m_sqes;
+
+    size_t m_sqesSize;
+
+    __u32 *m_sqHead;
+
+    __u32 *m_sqTail;
+
+    __u32 m_sqMask;
+
+    __u32 m_sqEntries;
+
+    __u32 *m_sqArray;
+
+    // local tail, published by submit()
+    __u32 m_sqeTail;
+
+    __u32 m_sqeSubmitted;
+
+    __u32 *m_cqHead;
+
+    __u32 *m_cqTail;
+
+    __u32 m_cqMask;
+
+    struct io_uring_cqe *m_cqes;
+
+}; // end class Uring
+
+} // end namespace Proc
+
+} // end namespace Model
+
+#endif // _MODEL_PROC_URING_HPP_
@@ -21,6 +21,7 @@
  * SOFTWARE.
  */
 
+#include <ctime>
 #include <new>
 
 #include "spdlog/spdlog.h"
@@ -28,6 +29,7 @@
 #include "winproc.hpp"
 
 #include "controller/global/global.hpp"
+#include "model/metrics.hpp"
 #include "model/utils.hpp"
 
 namespace Model
@@ -39,7 +41,9 @@ namespace Proc
 WinProc::WinProc() :
     m_childStdoutRead(nullptr),
     m_childStdoutWrite(nullptr),
-    m_procInfo(PROCESS_INFORMATION())
+    m_procInfo(PROCESS_INFORMATION()),
+    m_cpuTime(0),
+    m_lastOutput(0)
 {}
 
 WinProc::~WinProc()
@@ -58,6 +62,9 @@ u8 WinProc::init()
 
 u8 WinProc::start(const Task &task)
 {
+    static Metrics::Histogram &latency = Metrics::histogram("ff_proc_spawn_us");
+    Metrics::Scope scope(latency);
+
     if (isRunning())
     {
         spdlog::error("{}:{} {}", __FILE__, __LINE__, "Process is running");
@@ -110,6 +117,13 @@ u8 WinProc::start(const Task &task)
     m_childStdoutWrite = NULL;
 
     m_exitCode.store(STILL_ACTIVE, std::memory_order_relaxed);
+    m_cpuTime.store(0, std::memory_order_relaxed);
+    m_lastOutput.store(time(nullptr), std::memory_order_relaxed);
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_log.clear();
+    }
+
     m_thread = std::jthread(&WinProc::readOutputLoop, this);
     return 0;
 }
@@ -144,6 +158,21 @@ bool WinProc::isRunning()
     }
 
     m_exitCode.store(currentExitCode, std::memory_order_relaxed);
+
+    // in units of 100 nanoseconds
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(m_procInfo.hProcess, &creationTime, &exitTime,
+                        &kernelTime, &userTime))
+    {
+        ULARGE_INTEGER kernel, user;
+        kernel.LowPart = kernelTime.dwLowDateTime;
+        kernel.HighPart = kernelTime.dwHighDateTime;
+        user.LowPart = userTime.dwLowDateTime;
+        user.HighPart = userTime.dwHighDateTime;
+        m_cpuTime.store(static_cast<i64>((kernel.QuadPart + user.QuadPart) / 10000),
+                        std::memory_order_relaxed);
+    }
+
     return false;
 }
 
@@ -181,6 +210,85 @@ u8 WinProc::exitCode(i32 &out)
     return 0;
 }
 
+u8 WinProc::cpuTime(i64 &out)
+{
+    if (isRunning())
+    {
+        spdlog::error("{}:{} {}", __FILE__, __LINE__, "Process is running");
+        return 1;
+    }
+
+    out = m_cpuTime.load(std::memory_order_relaxed);
+    return 0;
+}
+
+u8 WinProc::terminate(bool force)
+{
+    // there is no SIGTERM for a console process, the polite request
+    // would have to go through the pseudo console which can block,
+    // so both ways end the process at once
+    UNUSED(force);
+    if (m_procInfo.hProcess == NULL)
+    {
+        spdlog::error("{}:{} Process is not started", __FILE__, __LINE__);
+        return 1;
+    }
+
+    // the handle stays valid after exit, terminating an exited
+    // process only fails with access denied
+    if (!TerminateProcess(m_procInfo.hProcess, 1) &&
+        GetLastError() != ERROR_ACCESS_DENIED)
+    {
+        Utils::writeLastError(__FILE__, __LINE__);
+        return 1;
+    }
+
+    return 0;
+}
+
+i64 WinProc::lastOutputTime()
+{
+    return m_lastOutput.load(std::memory_order_relaxed);
+}
+
+void WinProc::outputLog(std::string &out)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    out = m_log;
+}
+
+void WinProc::appendLog(const std::string &in)
+{
+    // m_mutex is held
+    m_log += in;
+    if (m_log.size() > FF_MAX_OUTPUT_LOG)
+    {
+        m_log.erase(0, m_log.size() - FF_MAX_OUTPUT_LOG);
+    }
+}
+
+u8 WinProc::setAffinity(const Affinity &in)
+{
+    if (in.numaNode >= 0)
+    {
+        spdlog::warn("{}:{} NUMA binding is not supported, ignore...", __FILE__, __LINE__);
+    }
+
+    for (auto it = in.cpus.begin(); it != in.cpus.end(); ++it)
+    {
+        if (*it >= static_cast<i32>(sizeof(DWORD_PTR) * 8))
+        {
+            spdlog::error("{}:{} Invalid cpu: {}", __FILE__, __LINE__, *it);
+            return 1;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_affinityMutex);
+    m_affinity = in;
+    m_nextCPU = 0;
+    return 0;
+}
+
 // private member functions
 u8 WinProc::prepareStartupInformation(STARTUPINFOEXA *output)
 {
@@ -273,7 +381,7 @@ u8 WinProc::CreateChildProcess(const Task &task)
         NULL,          // process security attributes
         NULL,          // primary thread security attributes
         FALSE,         // no inherited handle
-        EXTENDED_STARTUPINFO_PRESENT, // creation flags
+        EXTENDED_STARTUPINFO_PRESENT | CREATE_SUSPENDED, // creation flags
         NULL,          // use parent's environment
         task.workDir.c_str(),
         &siStartInfoEX.StartupInfo,  // STARTUPINFO pointer
@@ -285,6 +393,22 @@ u8 WinProc::CreateChildProcess(const Task &task)
     if (!bSuccess)
     {
         Utils::writeLastError(__FILE__, __LINE__);
+        delete[] cmdPtr;
+        return 1;
+    }
+
+    // pin before the child runs its first instruction
+    DWORD_PTR mask = childAffinityMask();
+    if (mask && !SetProcessAffinityMask(m_procInfo.hProcess, mask))
+    {
+        Utils::writeLastError(__FILE__, __LINE__);
+        TerminateProcess(m_procInfo.hProcess, 1);
+        ret = 1;
+    }
+    else if (ResumeThread(m_procInfo.hThread) == static_cast<DWORD>(-1))
+    {
+        Utils::writeLastError(__FILE__, __LINE__);
+        TerminateProcess(m_procInfo.hProcess, 1);
         ret = 1;
     }
 
@@ -292,6 +416,31 @@ u8 WinProc::CreateChildProcess(const Task &task)
     return ret;
 }
 
+DWORD_PTR WinProc::childAffinityMask()
+{
+    std::unique_lock<std::mutex> lock(m_affinityMutex);
+    DWORD_PTR mask(0);
+    if (m_affinity.cpus.empty())
+    {
+        return mask;
+    }
+
+    if (m_affinity.roundRobin)
+    {
+        mask = static_cast<DWORD_PTR>(1) <<
+               m_affinity.cpus[m_nextCPU % m_affinity.cpus.size()];
+        ++m_nextCPU;
+        return mask;
+    }
+
+    for (auto it = m_affinity.cpus.begin(); it != m_affinity.cpus.end(); ++it)
+    {
+        mask |= static_cast<DWORD_PTR>(1) << *it;
+    }
+
+    return mask;
+}
+
 void WinProc::resetHandle()
 {
     if (m_childStdoutRead)
@@ -370,9 +519,11 @@ void WinProc::readOutputLoop()
 
         // set correct buffer size
         buf.resize(dwRead);
+        m_lastOutput.store(time(nullptr), std::memory_order_relaxed);
 
         {
             std::unique_lock<std::mutex> lock(m_mutex);
+            appendLog(buf);
 
             if (m_deque.size() == FF_MAX_READ_QUEUE_SIZE)
             {
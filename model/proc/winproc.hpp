@@ -63,6 +63,16 @@ public:
 
     virtual u8 exitCode(i32 &out) override;
 
+    virtual u8 cpuTime(i64 &out) override;
+
+    virtual u8 setAffinity(const Affinity &in) override;
+
+    virtual u8 terminate(bool force) override;
+
+    virtual i64 lastOutputTime() override;
+
+    virtual void outputLog(std::string &out) override;
+
 private:
 
     HANDLE m_childStdoutRead = nullptr;
@@ -77,6 +87,11 @@ private:
 
     std::atomic<i32> m_exitCode;
 
+    // of the process itself, Windows does not count the children
+    std::atomic<i64> m_cpuTime;
+
+    std::atomic<i64> m_lastOutput;
+
     // pseudo console
     HPCON m_pseudoConsole = nullptr;
 
@@ -84,6 +99,15 @@ private:
 
     u8 CreateChildProcess(const Task &);
 
+    // cpu pinning
+    std::mutex m_affinityMutex;
+
+    Affinity m_affinity;
+
+    size_t m_nextCPU = 0;
+
+    DWORD_PTR childAffinityMask();
+
     void resetHandle();
 
     void stopImpl();
@@ -94,6 +118,11 @@ private:
 
     std::deque<std::string> m_deque;
 
+    // guarded by m_mutex
+    std::string m_log;
+
+    void appendLog(const std::string &);
+
     void readOutputLoop();
 
 };
@@ -0,0 +1,340 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "scheduler.hpp"
+
+namespace Model
+{
+
+namespace Scheduler
+{
+
+class QueueState
+{
+public:
+
+    i32 priority = 0;
+
+    u32 weight = 1;
+
+    // virtual time, advanced by used time / weight on every release
+    double pass = 0;
+
+    u64 consumed = 0;
+
+    u64 tasks = 0;
+
+    u32 running = 0;
+
+    u32 waiting = 0;
+};
+
+class Waiter
+{
+public:
+
+    const void *queue;
+
+    QueueState *state;
+
+    u64 seq;
+
+    std::function<void (u8)> onDone;
+};
+
+using Granted = std::vector<std::function<void (u8)>>;
+
+static std::mutex mutex;
+
+static u32 budget(0);
+
+static u32 runningCount(0);
+
+static u64 nextSeq(0);
+
+// pass of the last granted queue, used to bring a queue which was idle back
+// in line instead of letting it catch up on the time it did not use
+static double virtualTime(0);
+
+static std::unordered_map<const void *, QueueState> states;
+
+static std::list<Waiter> waiters;
+
+static bool isBefore(const Waiter &lhs, const Waiter &rhs)
+{
+    if (lhs.state->priority != rhs.state->priority)
+    {
+        return lhs.state->priority > rhs.state->priority;
+    }
+
+    if (lhs.state->pass != rhs.state->pass)
+    {
+        return lhs.state->pass < rhs.state->pass;
+    }
+
+    return lhs.seq < rhs.seq;
+}
+
+// mutex is held, hand out the free slots in order, the callbacks are called
+// by finish() after the lock is released
+static void grant(Granted &out)
+{
+    while (!waiters.empty() && (!budget || runningCount < budget))
+    {
+        auto next = waiters.begin();
+        for (auto it = std::next(next); it != waiters.end(); ++it)
+        {
+            if (isBefore(*it, *next))
+            {
+                next = it;
+            }
+        }
+
+        QueueState *state = next->state;
+        --state->waiting;
+        virtualTime = state->pass;
+        ++state->running;
+        ++runningCount;
+        out.push_back(std::move(next->onDone));
+        waiters.erase(next);
+    }
+}
+
+// mutex is held
+static void drop(const void *queue, Granted &out)
+{
+    for (auto it = waiters.begin(); it != waiters.end();)
+    {
+        if (it->queue != queue)
+        {
+            ++it;
+            continue;
+        }
+
+        --it->state->waiting;
+        out.push_back(std::move(it->onDone));
+        it = waiters.erase(it);
+    }
+}
+
+static void finish(Granted &in, u8 code)
+{
+    for (auto it = in.begin(); it != in.end(); ++it)
+    {
+        (*it)(code);
+    }
+}
+
+void init(u32 slots)
+{
+    Granted granted;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        budget = slots;
+        spdlog::info("{}:{} Scheduler slots: {}", __FILE__, __LINE__, budget);
+        grant(granted);
+    }
+
+    finish(granted, 0);
+}
+
+u32 slots()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return budget;
+}
+
+u32 running()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return runningCount;
+}
+
+void addQueue(const void *queue)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    QueueState &state = states[queue];
+    state = QueueState();
+    state.pass = virtualTime;
+}
+
+void removeQueue(const void *queue)
+{
+    Granted dropped;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drop(queue, dropped);
+        states.erase(queue);
+    }
+
+    finish(dropped, 1);
+}
+
+void setPriority(const void *queue, i32 priority)
+{
+    Granted granted;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        states[queue].priority = priority;
+        grant(granted);
+    }
+
+    finish(granted, 0);
+}
+
+u8 setWeight(const void *queue, u32 weight)
+{
+    if (!weight)
+    {
+        spdlog::error("{}:{} Weight must be greater than 0", __FILE__, __LINE__);
+        return 1;
+    }
+
+    Granted granted;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        states[queue].weight = weight;
+        grant(granted);
+    }
+
+    finish(granted, 0);
+    return 0;
+}
+
+u8 share(const void *queue, Share &out)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = states.find(queue);
+    if (it == states.end())
+    {
+        spdlog::error("{}:{} Queue is not registered", __FILE__, __LINE__);
+        return 1;
+    }
+
+    out.weight = it->second.weight;
+    out.priority = it->second.priority;
+    out.consumed = it->second.consumed;
+    out.tasks = it->second.tasks;
+    out.running = it->second.running;
+    out.waiting = it->second.waiting;
+    return 0;
+}
+
+void acquire(const void *queue,
+             const std::atomic<bool> &keepWaiting,
+             std::function<void (u8)> onDone)
+{
+    Granted granted;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // cancel() has been called before the lock is taken
+        if (!keepWaiting.load(std::memory_order_relaxed))
+        {
+            lock.unlock();
+            onDone(1);
+            return;
+        }
+
+        // the state stays valid while we are waiting, removeQueue() drops
+        // the waiter as well
+        QueueState *state = &states[queue];
+        if (!state->running && !state->waiting)
+        {
+            state->pass = std::max(state->pass, virtualTime);
+        }
+
+        Waiter waiter;
+        waiter.queue = queue;
+        waiter.state = state;
+        waiter.seq = nextSeq++;
+        waiter.onDone = std::move(onDone);
+        waiters.push_back(std::move(waiter));
+        ++state->waiting;
+        grant(granted);
+    }
+
+    finish(granted, 0);
+}
+
+void release(const void *queue, std::chrono::nanoseconds used)
+{
+    Granted granted;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!runningCount)
+        {
+            spdlog::error("{}:{} Release without acquire", __FILE__, __LINE__);
+            return;
+        }
+
+        --runningCount;
+        auto it = states.find(queue);
+        if (it != states.end())
+        {
+            QueueState &state = it->second;
+            if (state.running)
+            {
+                --state.running;
+            }
+
+            if (used.count() < 0)
+            {
+                used = std::chrono::nanoseconds(0);
+            }
+
+            state.consumed += static_cast<u64>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(used).count());
+            ++state.tasks;
+            state.pass += std::chrono::duration<double>(used).count() / state.weight;
+        }
+
+        grant(granted);
+    }
+
+    finish(granted, 0);
+}
+
+void cancel(const void *queue)
+{
+    // taking the lock orders this against an acquire() which has checked
+    // its keepWaiting flag already
+    Granted dropped;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drop(queue, dropped);
+    }
+
+    finish(dropped, 1);
+}
+
+} // end namespace Scheduler
+
+} // end namespace Model
@@ -0,0 +1,103 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _MODEL_SCHEDULER_HPP_
+#define _MODEL_SCHEDULER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+// Host wide budget of concurrently running tasks, shared by all queues.
+// Every queue loop asks for a slot before spawning its task and gives it back
+// when the task is finished with the time it has used. Nobody blocks for a
+// slot: a waiting queue is an entry with a callback, granted by the thread
+// which frees the slot.
+//
+// Waiting queues are granted in order of priority. Between queues of the same
+// priority the slot goes to the one with the least weighted consumed time
+// (stride scheduling: every release advances the queue's pass by
+// used time / weight), then in order of arrival.
+namespace Scheduler
+{
+
+class Share
+{
+public:
+
+    u32 weight = 1;
+
+    i32 priority = 0;
+
+    // wall time consumed by finished tasks, in milliseconds
+    u64 consumed = 0;
+
+    u64 tasks = 0;
+
+    u32 running = 0;
+
+    u32 waiting = 0;
+};
+
+// 0 for unlimited, which is also the default before init() is called
+void init(u32 slots);
+
+u32 slots();
+
+u32 running();
+
+void addQueue(const void *queue);
+
+void removeQueue(const void *queue);
+
+// higher value is granted first, default is 0
+void setPriority(const void *queue, i32 priority);
+
+// relative share among queues of the same priority, must be > 0, default is 1
+u8 setWeight(const void *queue, u32 weight);
+
+u8 share(const void *queue, Share &out);
+
+// call "onDone" with 0 once a slot is granted, or with 1 if keepWaiting is
+// false or cancel() is called before, it may be called before acquire()
+// returns and must not block
+void acquire(const void *queue,
+             const std::atomic<bool> &keepWaiting,
+             std::function<void (u8)> onDone);
+
+void release(const void *queue, std::chrono::nanoseconds used);
+
+// fail the waiting acquire() of the queue, clear its keepWaiting flag first
+// so an acquire() which is just being called fails as well
+void cancel(const void *queue);
+
+} // end namespace Scheduler
+
+} // end namespace Model
+
+#endif // _MODEL_SCHEDULER_HPP_
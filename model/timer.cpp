@@ -0,0 +1,304 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "timer.hpp"
+
+#define TIMER_LEVEL_BITS 6
+#define TIMER_SLOTS (1 << TIMER_LEVEL_BITS)
+#define TIMER_LEVELS 4
+
+namespace Model
+{
+
+namespace Timer
+{
+
+class Entry
+{
+public:
+
+    i64 when;
+
+    std::function<void()> cb;
+
+    // TIMER_LEVELS for the overflow list
+    u8 level;
+
+    u8 slot;
+};
+
+static std::mutex mutex;
+
+static std::condition_variable cond;
+
+static std::jthread thread;
+
+static bool isInit(false);
+
+static bool keepRunning(false);
+
+// the last processed tick
+static i64 current(0);
+
+static u64 nextID(1);
+
+// expired timers waiting for their callbacks to run
+static std::unordered_set<u64> firing;
+
+// id of the callback which is running, 0 for none
+static u64 runningID(0);
+
+static std::unordered_map<u64, Entry> entries;
+
+static std::unordered_set<u64> wheel[TIMER_LEVELS][TIMER_SLOTS];
+
+static std::unordered_set<u64> overflow;
+
+static i64 now()
+{
+    return static_cast<i64>(time(nullptr));
+}
+
+static void setCurrent()
+{
+    if (!isInit)
+    {
+        current = now();
+        isInit = true;
+    }
+}
+
+// "entry.when" must not be before the current tick, one due at the current
+// tick is moved down by a cascade and expires in the same tick()
+static void place(u64 id, Entry &entry)
+{
+    i64 delta = entry.when - current;
+    for (u8 level = 0; level < TIMER_LEVELS; ++level)
+    {
+        if (delta < (static_cast<i64>(1) << (TIMER_LEVEL_BITS * (level + 1))))
+        {
+            entry.level = level;
+            entry.slot = static_cast<u8>(
+                (entry.when >> (TIMER_LEVEL_BITS * level)) & (TIMER_SLOTS - 1));
+            wheel[level][entry.slot].insert(id);
+            return;
+        }
+    }
+
+    entry.level = TIMER_LEVELS;
+    entry.slot = 0;
+    overflow.insert(id);
+}
+
+static void cascade(std::unordered_set<u64> &from)
+{
+    std::unordered_set<u64> ids;
+    ids.swap(from);
+    for (auto it = ids.begin(); it != ids.end(); ++it)
+    {
+        place(*it, entries[*it]);
+    }
+}
+
+// advance one tick, collect the expired timers
+static void tick(std::vector<std::pair<u64, std::function<void()>>> &expired)
+{
+    ++current;
+
+    // move the timers of the block starting at this tick one level down,
+    // from the top so nothing is moved into an already cascaded slot
+    if (!(current & ((static_cast<i64>(1) << (TIMER_LEVEL_BITS * TIMER_LEVELS)) - 1)))
+    {
+        cascade(overflow);
+    }
+
+    for (u8 level = TIMER_LEVELS - 1; level > 0; --level)
+    {
+        if (!(current & ((static_cast<i64>(1) << (TIMER_LEVEL_BITS * level)) - 1)))
+        {
+            cascade(wheel[level][(current >> (TIMER_LEVEL_BITS * level)) & (TIMER_SLOTS - 1)]);
+        }
+    }
+
+    std::unordered_set<u64> &slot = wheel[0][current & (TIMER_SLOTS - 1)];
+    for (auto it = slot.begin(); it != slot.end();)
+    {
+        auto entry = entries.find(*it);
+        if (entry->second.when > current)
+        {
+            ++it;
+            continue;
+        }
+
+        expired.push_back(std::make_pair(*it, std::move(entry->second.cb)));
+        firing.insert(*it);
+        entries.erase(entry);
+        it = slot.erase(it);
+    }
+}
+
+static void mainLoop()
+{
+    std::vector<std::pair<u64, std::function<void()>>> expired;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (keepRunning)
+    {
+        // catch up after the thread or the host was suspended, a clock
+        // going backwards just waits until it reaches the last tick again
+        i64 target = now();
+        while (current < target)
+        {
+            tick(expired);
+        }
+
+        for (auto it = expired.begin(); it != expired.end(); ++it)
+        {
+            // cancelled after expired
+            if (!firing.erase(it->first))
+            {
+                continue;
+            }
+
+            runningID = it->first;
+            lock.unlock();
+            try
+            {
+                it->second();
+            }
+            catch (...)
+            {
+                spdlog::error("{}:{} Timer callback throws", __FILE__, __LINE__);
+            }
+
+            lock.lock();
+            runningID = 0;
+            cond.notify_all();
+        }
+
+        expired.clear();
+        if (!keepRunning)
+        {
+            break;
+        }
+
+        cond.wait_until(lock,
+                        std::chrono::system_clock::from_time_t(current + 1),
+                        []() { return !keepRunning; });
+    }
+}
+
+u8 init()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (keepRunning)
+    {
+        spdlog::error("{}:{} Timer is running", __FILE__, __LINE__);
+        return 1;
+    }
+
+    setCurrent();
+    keepRunning = true;
+    try
+    {
+        thread = std::jthread(mainLoop);
+    }
+    catch (...)
+    {
+        keepRunning = false;
+        spdlog::error("{}:{} Fail to start timer thread", __FILE__, __LINE__);
+        return 1;
+    }
+
+    return 0;
+}
+
+void fin()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        keepRunning = false;
+        cond.notify_all();
+    }
+
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+u64 add(i64 when, std::function<void()> cb)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    setCurrent();
+
+    u64 id = nextID++;
+    Entry &entry = entries[id];
+
+    // the current tick is processed already
+    entry.when = std::max(when, current + 1);
+    entry.cb = std::move(cb);
+    place(id, entry);
+    return id;
+}
+
+void cancel(u64 id)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = entries.find(id);
+    if (it != entries.end())
+    {
+        if (it->second.level == TIMER_LEVELS)
+        {
+            overflow.erase(id);
+        }
+        else
+        {
+            wheel[it->second.level][it->second.slot].erase(id);
+        }
+
+        entries.erase(it);
+        return;
+    }
+
+    if (firing.erase(id))
+    {
+        return;
+    }
+
+    cond.wait(lock, [id]() { return runningID != id; });
+}
+
+} // end namespace Timer
+
+} // end namespace Model
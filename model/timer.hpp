@@ -0,0 +1,58 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _MODEL_TIMER_HPP_
+#define _MODEL_TIMER_HPP_
+
+#include <functional>
+
+#include "controller/global/defines.hpp"
+
+namespace Model
+{
+
+// Server wide hierarchical timer wheel with 1 second resolution.
+// Four levels of 64 slots cover about 194 days, later timers wait in an
+// overflow list. Callbacks run on the timer thread and must not block for
+// long.
+namespace Timer
+{
+
+// start the timer thread, timers added before are kept
+u8 init();
+
+void fin();
+
+// run "cb" once at unix time "when" (in seconds), a time in the past fires on
+// the next tick, return the timer id for cancel(), never 0
+u64 add(i64 when, std::function<void()> cb);
+
+// after return the callback is neither pending nor running,
+// must not be called from the callback of the same timer
+void cancel(u64 id);
+
+} // end namespace Timer
+
+} // end namespace Model
+
+#endif // _MODEL_TIMER_HPP_
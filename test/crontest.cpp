@@ -0,0 +1,147 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <ctime>
+
+#include "gtest/gtest.h"
+
+#include "model/cron.hpp"
+
+namespace
+{
+
+// the expressions are in local time, the tests run in UTC
+class CronTest : public ::testing::Test
+{
+protected:
+
+    static void SetUpTestSuite()
+    {
+#ifdef _WIN32
+        _putenv_s("TZ", "UTC");
+        _tzset();
+#else
+        setenv("TZ", "UTC", 1);
+        tzset();
+#endif
+    }
+
+    // 2024-01-01 (a monday) plus the given offset
+    static i64 at(i32 day, i32 hour, i32 minute)
+    {
+        return 1704067200 + day * 86400 + hour * 3600 + minute * 60;
+    }
+};
+
+TEST_F(CronTest, RejectsInvalidExpressions)
+{
+    Model::Cron cron;
+    EXPECT_TRUE(cron.parse(""));
+    EXPECT_TRUE(cron.parse("* * * *"));
+    EXPECT_TRUE(cron.parse("* * * * * *"));
+    EXPECT_TRUE(cron.parse("60 * * * *"));
+    EXPECT_TRUE(cron.parse("* 24 * * *"));
+    EXPECT_TRUE(cron.parse("* * 0 * *"));
+    EXPECT_TRUE(cron.parse("* * * 13 *"));
+    EXPECT_TRUE(cron.parse("* * * * 8"));
+    EXPECT_TRUE(cron.parse("5-1 * * * *"));
+    EXPECT_TRUE(cron.parse("*/0 * * * *"));
+    EXPECT_TRUE(cron.parse("a * * * *"));
+    EXPECT_FALSE(cron.parse("*/15 1-3,5 1,15 * 1-5"));
+}
+
+TEST_F(CronTest, NextIsAfterTheGivenTime)
+{
+    Model::Cron cron;
+    ASSERT_FALSE(cron.parse("* * * * *"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(0, 0, 1));
+    EXPECT_EQ(cron.next(at(0, 0, 0) + 59), at(0, 0, 1));
+}
+
+TEST_F(CronTest, StepsAndRanges)
+{
+    Model::Cron cron;
+    ASSERT_FALSE(cron.parse("*/15 * * * *"));
+    EXPECT_EQ(cron.next(at(0, 0, 7)), at(0, 0, 15));
+    EXPECT_EQ(cron.next(at(0, 0, 45)), at(0, 1, 0));
+
+    // "a/n" runs from a to the max
+    ASSERT_FALSE(cron.parse("10/20 * * * *"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(0, 0, 10));
+    EXPECT_EQ(cron.next(at(0, 0, 50)), at(0, 1, 10));
+
+    ASSERT_FALSE(cron.parse("0 9-17/4 * * *"));
+    EXPECT_EQ(cron.next(at(0, 10, 0)), at(0, 13, 0));
+    EXPECT_EQ(cron.next(at(0, 17, 0)), at(1, 9, 0));
+}
+
+TEST_F(CronTest, DailyRollsOverToTheNextDay)
+{
+    Model::Cron cron;
+    ASSERT_FALSE(cron.parse("30 3 * * *"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(0, 3, 30));
+    EXPECT_EQ(cron.next(at(0, 3, 30)), at(1, 3, 30));
+}
+
+TEST_F(CronTest, SundayIsZeroAndSeven)
+{
+    Model::Cron cron;
+    ASSERT_FALSE(cron.parse("0 0 * * 7"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(6, 0, 0));
+    ASSERT_FALSE(cron.parse("0 0 * * 0"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(6, 0, 0));
+}
+
+TEST_F(CronTest, DayOrWeekdayWhenBothAreRestricted)
+{
+    // the 13th or a friday, the first friday comes first
+    Model::Cron cron;
+    ASSERT_FALSE(cron.parse("0 0 13 * 5"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(4, 0, 0));
+    EXPECT_EQ(cron.next(at(11, 0, 0)), at(12, 0, 0));
+
+    // only one of them restricted, both must match
+    ASSERT_FALSE(cron.parse("0 0 */1 * 5"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(4, 0, 0));
+}
+
+TEST_F(CronTest, MonthsAndLeapDay)
+{
+    Model::Cron cron;
+    ASSERT_FALSE(cron.parse("0 0 1 3 *"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(60, 0, 0));
+
+    // 2024 is a leap year
+    ASSERT_FALSE(cron.parse("0 0 29 2 *"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), at(59, 0, 0));
+}
+
+TEST_F(CronTest, NeverMatches)
+{
+    Model::Cron cron;
+    ASSERT_FALSE(cron.parse("0 0 31 2 *"));
+    EXPECT_EQ(cron.next(at(0, 0, 0)), -1);
+}
+
+} // end namespace
@@ -0,0 +1,225 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "model/dag.hpp"
+
+namespace
+{
+
+// a queue as seen by the graph, the states are set by the test
+class FakeQueue
+{
+public:
+
+    explicit FakeQueue(const std::string &name) :
+        m_name(name)
+    {
+        Model::DAG::Handler handler;
+        handler.state = [this](i32 id)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto it = m_states.find(id);
+            return (it == m_states.end()) ? TaskState_NOT_FOUND : it->second;
+        };
+
+        handler.resolve = [this](i32 id, bool success)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_resolved.push_back(std::make_pair(id, success));
+        };
+
+        Model::DAG::addQueue(m_name, handler);
+    }
+
+    ~FakeQueue()
+    {
+        Model::DAG::removeQueue(m_name);
+    }
+
+    void set(i32 id, u8 state)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_states[id] = state;
+    }
+
+    std::vector<std::pair<i32, bool>> resolved()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_resolved;
+    }
+
+    Model::Proc::TaskRef ref(i32 id) const
+    {
+        Model::Proc::TaskRef ret;
+        ret.queue = m_name;
+        ret.ID = id;
+        return ret;
+    }
+
+    std::string m_name;
+
+private:
+
+    std::mutex m_mutex;
+
+    std::map<i32, u8> m_states;
+
+    std::vector<std::pair<i32, bool>> m_resolved;
+};
+
+typedef std::vector<std::pair<i32, bool>> Resolved;
+
+TEST(DAGTest, FinishedParentsResolveOnAdd)
+{
+    FakeQueue q("dag-finished");
+    q.set(1, TaskState_SUCCEEDED);
+    q.set(2, TaskState_WAITING);
+    Model::DAG::add(q.ref(2), {q.ref(1)});
+    EXPECT_EQ(q.resolved(), Resolved({{2, true}}));
+
+    q.set(3, TaskState_FAILED);
+    q.set(4, TaskState_WAITING);
+    Model::DAG::add(q.ref(4), {q.ref(1), q.ref(3)});
+    EXPECT_EQ(q.resolved(), Resolved({{2, true}, {4, false}}));
+}
+
+TEST(DAGTest, ChildWaitsForEveryParent)
+{
+    FakeQueue q("dag-every");
+    q.set(1, TaskState_WAITING);
+    q.set(2, TaskState_WAITING);
+    q.set(3, TaskState_WAITING);
+    Model::DAG::add(q.ref(3), {q.ref(1), q.ref(2)});
+    EXPECT_TRUE(q.resolved().empty());
+
+    q.set(1, TaskState_SUCCEEDED);
+    Model::DAG::finished(q.ref(1), true);
+    EXPECT_TRUE(q.resolved().empty());
+
+    q.set(2, TaskState_SUCCEEDED);
+    Model::DAG::finished(q.ref(2), true);
+    EXPECT_EQ(q.resolved(), Resolved({{3, true}}));
+}
+
+TEST(DAGTest, FirstFailedParentResolvesOnce)
+{
+    FakeQueue q("dag-failed");
+    q.set(1, TaskState_WAITING);
+    q.set(2, TaskState_WAITING);
+    q.set(3, TaskState_WAITING);
+    Model::DAG::add(q.ref(3), {q.ref(1), q.ref(2)});
+
+    Model::DAG::finished(q.ref(1), false);
+    Model::DAG::finished(q.ref(2), true);
+    EXPECT_EQ(q.resolved(), Resolved({{3, false}}));
+}
+
+TEST(DAGTest, RemovedChildIsNotResolved)
+{
+    FakeQueue q("dag-removed");
+    q.set(1, TaskState_WAITING);
+    q.set(2, TaskState_WAITING);
+    Model::DAG::add(q.ref(2), {q.ref(1)});
+    Model::DAG::remove(q.ref(2));
+    Model::DAG::finished(q.ref(1), true);
+    EXPECT_TRUE(q.resolved().empty());
+}
+
+TEST(DAGTest, RecurringParentCountsAsFailed)
+{
+    FakeQueue q("dag-recurring");
+    q.set(1, TaskState_RECURRING);
+    q.set(2, TaskState_WAITING);
+    Model::DAG::add(q.ref(2), {q.ref(1)});
+    EXPECT_EQ(q.resolved(), Resolved({{2, false}}));
+}
+
+TEST(DAGTest, ParentQueueAddedLater)
+{
+    FakeQueue child("dag-later-child");
+    child.set(1, TaskState_WAITING);
+
+    Model::Proc::TaskRef parent;
+    parent.queue = "dag-later-parent";
+    parent.ID = 7;
+    EXPECT_EQ(Model::DAG::state(parent), TaskState_UNKNOWN);
+    Model::DAG::add(child.ref(1), {parent});
+    EXPECT_TRUE(child.resolved().empty());
+
+    // the parent has finished while its queue was not loaded
+    {
+        Model::DAG::Handler handler;
+        handler.state = [](i32) { return static_cast<u8>(TaskState_SUCCEEDED); };
+        handler.resolve = [](i32, bool) {};
+        Model::DAG::addQueue(parent.queue, handler);
+    }
+
+    EXPECT_EQ(child.resolved(), Resolved({{1, true}}));
+    Model::DAG::removeQueue(parent.queue);
+}
+
+TEST(DAGTest, RenameMovesTheQueueAndItsEdges)
+{
+    FakeQueue a("dag-rename-a");
+    FakeQueue other("dag-rename-other");
+    a.set(1, TaskState_WAITING);
+    other.set(1, TaskState_WAITING);
+    Model::DAG::add(other.ref(1), {a.ref(1)});
+
+    EXPECT_TRUE(Model::DAG::renameQueue(a.m_name, other.m_name));
+    EXPECT_TRUE(Model::DAG::renameQueue("dag-rename-none", "dag-rename-x"));
+    ASSERT_FALSE(Model::DAG::renameQueue(a.m_name, "dag-rename-b"));
+    a.m_name = "dag-rename-b";
+
+    Model::Proc::TaskRef old;
+    old.queue = "dag-rename-a";
+    old.ID = 1;
+    EXPECT_EQ(Model::DAG::state(old), TaskState_UNKNOWN);
+    EXPECT_EQ(Model::DAG::state(a.ref(1)), TaskState_WAITING);
+
+    // the edge follows the parent to its new name
+    Model::DAG::finished(a.ref(1), true);
+    EXPECT_EQ(other.resolved(), Resolved({{1, true}}));
+}
+
+TEST(DAGTest, RemovedQueueIsUnknown)
+{
+    Model::Proc::TaskRef ref;
+    {
+        FakeQueue q("dag-gone");
+        q.set(1, TaskState_SUCCEEDED);
+        ref = q.ref(1);
+        EXPECT_EQ(Model::DAG::state(ref), TaskState_SUCCEEDED);
+    }
+
+    EXPECT_EQ(Model::DAG::state(ref), TaskState_UNKNOWN);
+}
+
+} // end namespace
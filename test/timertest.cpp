@@ -0,0 +1,136 @@
+/*
+ * Simple Task Queue
+ * Copyright (c) 2024-present fdar0536
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "model/timer.hpp"
+
+namespace
+{
+
+class TimerTest : public ::testing::Test
+{
+protected:
+
+    void SetUp() override
+    {
+        ASSERT_FALSE(Model::Timer::init());
+    }
+
+    void TearDown() override
+    {
+        Model::Timer::fin();
+    }
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_cond;
+
+    // unix time each callback ran at
+    std::vector<i64> m_fired;
+
+    std::function<void()> record()
+    {
+        return [this]()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_fired.push_back(static_cast<i64>(time(nullptr)));
+            m_cond.notify_all();
+        };
+    }
+
+    bool waitFired(size_t count, std::chrono::seconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cond.wait_for(lock, timeout, [&]() { return m_fired.size() >= count; });
+    }
+};
+
+TEST_F(TimerTest, PastTimeFiresOnTheNextTick)
+{
+    i64 now = static_cast<i64>(time(nullptr));
+    EXPECT_NE(Model::Timer::add(now - 10, record()), 0u);
+    ASSERT_TRUE(waitFired(1, std::chrono::seconds(3)));
+    EXPECT_LE(m_fired[0], now + 2);
+}
+
+TEST_F(TimerTest, FiresAtItsSecond)
+{
+    i64 when = static_cast<i64>(time(nullptr)) + 2;
+    Model::Timer::add(when, record());
+    ASSERT_TRUE(waitFired(1, std::chrono::seconds(5)));
+    EXPECT_EQ(m_fired[0], when);
+}
+
+TEST_F(TimerTest, CancelledTimerDoesNotFire)
+{
+    i64 now = static_cast<i64>(time(nullptr));
+    u64 id = Model::Timer::add(now + 1, record());
+    Model::Timer::add(now + 2, record());
+    Model::Timer::cancel(id);
+    ASSERT_TRUE(waitFired(1, std::chrono::seconds(5)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    EXPECT_EQ(m_fired.size(), 1u);
+}
+
+TEST_F(TimerTest, CancelWaitsForTheRunningCallback)
+{
+    std::atomic<bool> isRunning(false);
+    std::atomic<bool> isDone(false);
+    u64 id = Model::Timer::add(static_cast<i64>(time(nullptr)), [&]()
+    {
+        isRunning = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        isDone = true;
+    });
+
+    while (!isRunning)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    Model::Timer::cancel(id);
+    EXPECT_TRUE(isDone);
+}
+
+// a timer of a higher level whose deadline starts a level 1 block is moved
+// down on the tick it is due and must fire on that tick, takes 64 to 127s
+TEST_F(TimerTest, CascadedTimerIsNotLate)
+{
+    i64 when = ((static_cast<i64>(time(nullptr)) + 64 + 63) / 64) * 64;
+    Model::Timer::add(when, record());
+    ASSERT_TRUE(waitFired(1, std::chrono::seconds(when - time(nullptr) + 3)));
+    EXPECT_EQ(m_fired[0], when);
+}
+
+} // end namespace